@@ -4,6 +4,13 @@ layout (location = 0) in vec3 inColor;
 layout (location = 1) flat in uint inObjectIndex;
 layout (location = 0) out vec4 outFragColor;
 
+// Variant of the material, chosen when its pipeline is compiled
+const uint MATERIAL_FLAG_UNLIT = 1;
+layout (constant_id = 0) const uint materialFlags = 0;
+layout (constant_id = 1) const float albedoR = 1.0;
+layout (constant_id = 2) const float albedoG = 1.0;
+layout (constant_id = 3) const float albedoB = 1.0;
+layout (constant_id = 4) const float albedoA = 1.0;
 
 layout(set = 0, binding = 1) uniform  SceneData{   
     vec4 fogColor; // w is for exponent
@@ -22,5 +29,11 @@ layout (std140, set = 1, binding = 1) readonly buffer ObjectColorBuffer {
 } objectColorBuffer;
 
 void main() {
-    outFragColor = vec4(inColor * sceneData.ambientColor.xyz, 1.0) * objectColorBuffer.objects[inObjectIndex].albedo;
-}
\ No newline at end of file
+    vec4 color = vec4(inColor * sceneData.ambientColor.xyz, 1.0);
+    // The branch is removed from the variants that don't use it
+    if ((materialFlags & MATERIAL_FLAG_UNLIT) != 0) {
+        color = vec4(1.0);
+    }
+    vec4 albedo = vec4(albedoR, albedoG, albedoB, albedoA);
+    outFragColor = color * albedo * objectColorBuffer.objects[inObjectIndex].albedo;
+}
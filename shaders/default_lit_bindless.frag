@@ -0,0 +1,55 @@
+#version 460
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout (location = 0) in vec3 inColor;
+layout (location = 1) flat in uint inObjectIndex;
+layout (location = 2) flat in uint inMaterialIndex;
+layout (location = 3) in vec2 inTexCoord;
+layout (location = 0) out vec4 outFragColor;
+
+
+layout(set = 0, binding = 1) uniform  SceneData{
+    vec4 fogColor; // w is for exponent
+	vec4 fogDistances; //x for min, y for max, zw unused.
+	vec4 ambientColor;
+	vec4 sunlightDirection; //w for sun power
+	vec4 sunlightColor;
+} sceneData;
+
+// Object color
+struct ObjectColor {
+	vec4 albedo;
+};
+layout (std140, set = 1, binding = 1) readonly buffer ObjectColorBuffer {
+	ObjectColor objects[];
+} objectColorBuffer;
+
+// Material parameters, indexed by the material index of the object
+const uint MATERIAL_FLAG_UNLIT = 1;
+const uint NO_TEXTURE = 0xFFFFFFFF;
+struct MaterialData {
+	vec4 albedo;
+	uvec4 textures; // x for albedo texture, y for flags
+};
+layout (std140, set = 2, binding = 0) readonly buffer MaterialBuffer {
+	MaterialData materials[];
+} materialBuffer;
+
+// All the textures, indexed by the material
+layout (set = 2, binding = 1) uniform sampler2D textures[];
+
+void main() {
+    MaterialData material = materialBuffer.materials[inMaterialIndex];
+
+    // Use the albedo texture instead of the vertex color if there is one
+    vec3 baseColor = inColor;
+    if (material.textures.x != NO_TEXTURE) {
+        baseColor = texture(textures[nonuniformEXT(material.textures.x)], inTexCoord).xyz;
+    }
+
+    vec4 color = vec4(baseColor * sceneData.ambientColor.xyz, 1.0);
+    if ((material.textures.y & MATERIAL_FLAG_UNLIT) != 0) {
+        color = vec4(1.0);
+    }
+    outFragColor = color * material.albedo * objectColorBuffer.objects[inObjectIndex].albedo;
+}
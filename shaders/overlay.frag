@@ -0,0 +1,12 @@
+#version 460
+
+layout (location = 0) in vec4 inColor;
+layout (location = 1) in vec2 inTexCoord;
+layout (location = 0) out vec4 outFragColor;
+
+// ImGui font atlas
+layout (set = 0, binding = 0) uniform sampler2D fontTexture;
+
+void main() {
+    outFragColor = inColor * texture(fontTexture, inTexCoord);
+}
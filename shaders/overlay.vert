@@ -0,0 +1,20 @@
+#version 460
+
+layout (location = 0) in vec2 vPosition;
+layout (location = 1) in vec2 vTexCoord;
+layout (location = 2) in vec4 vColor;
+layout (location = 0) out vec4 outColor;
+layout (location = 1) out vec2 outTexCoord;
+
+// Maps the ImGui coordinates, in pixels, to clip space
+layout (push_constant) uniform constants
+{
+    vec2 scale;
+    vec2 translate;
+} pushConstants;
+
+void main() {
+    gl_Position = vec4(vPosition * pushConstants.scale + pushConstants.translate, 0.0, 1.0);
+    outColor = vColor;
+    outTexCoord = vTexCoord;
+}
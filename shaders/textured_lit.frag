@@ -0,0 +1,31 @@
+#version 460
+
+layout (location = 0) in vec3 inColor;
+layout (location = 1) flat in uint inObjectIndex;
+layout (location = 3) in vec2 inTexCoord;
+layout (location = 0) out vec4 outFragColor;
+
+
+layout(set = 0, binding = 1) uniform  SceneData{
+    vec4 fogColor; // w is for exponent
+	vec4 fogDistances; //x for min, y for max, zw unused.
+	vec4 ambientColor;
+	vec4 sunlightDirection; //w for sun power
+	vec4 sunlightColor;
+} sceneData;
+
+// Object color
+struct ObjectColor {
+	vec4 albedo;
+};
+layout (std140, set = 1, binding = 1) readonly buffer ObjectColorBuffer {
+	ObjectColor objects[];
+} objectColorBuffer;
+
+// Albedo texture of the material
+layout (set = 2, binding = 0) uniform sampler2D albedoTexture;
+
+void main() {
+    vec3 baseColor = texture(albedoTexture, inTexCoord).xyz;
+    outFragColor = vec4(baseColor * sceneData.ambientColor.xyz, 1.0) * objectColorBuffer.objects[inObjectIndex].albedo;
+}
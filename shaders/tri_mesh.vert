@@ -3,8 +3,11 @@
 layout (location = 0) in vec3 vPosition;
 layout (location = 1) in vec3 vNormal;
 layout (location = 2) in vec3 vColor;
+layout (location = 3) in vec2 vTexCoord;
 layout (location = 0) out vec3 outColor;
 layout (location = 1) flat out uint outObjectIndex;
+layout (location = 2) flat out uint outMaterialIndex;
+layout (location = 3) out vec2 outTexCoord;
 
 // Camera
 layout (set = 0, binding = 0) uniform CameraBuffer{
@@ -16,6 +19,8 @@ layout (set = 0, binding = 0) uniform CameraBuffer{
 // Objects
 struct ObjectData {
     mat4 model;
+    uvec4 materialData; // x is the material index
+    vec4 sphere; // world space bounding sphere, for the culling
 };
 layout (std140, set = 1, binding = 0) readonly buffer ObjectBuffer {
     ObjectData objects[];
@@ -29,9 +34,12 @@ layout (push_constant) uniform constants
 } pushConstants;
 
 void main() {
-    mat4 modelMatrix = objectBuffer.objects[gl_BaseInstance].model;
+    // The instance index includes the first instance of the draw, so it is the index of the object
+    mat4 modelMatrix = objectBuffer.objects[gl_InstanceIndex].model;
     mat4 transformMatrix = cameraData.viewProj * modelMatrix;
     gl_Position = transformMatrix * vec4(vPosition, 1.0);
     outColor = vColor;
-    outObjectIndex = gl_BaseInstance;
+    outObjectIndex = gl_InstanceIndex;
+    outMaterialIndex = objectBuffer.objects[gl_InstanceIndex].materialData.x;
+    outTexCoord = vTexCoord;
 }
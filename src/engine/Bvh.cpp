@@ -0,0 +1,368 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "Bvh.h"
+#include <algorithm>
+#include <array>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <numeric>
+
+/** Deeper nodes are not split, so that the traversal stacks have a fixed size */
+constexpr uint32_t BVH_MAX_DEPTH = 64;
+
+namespace {
+
+enum class Containment {
+  eOutside,
+  eIntersecting,
+  eInside,
+};
+
+Containment TestFrustum(const Aabb &box, const glm::vec4 planes[6]) {
+  const glm::vec3 center = box.GetCenter();
+  const glm::vec3 extent = (box.max - box.min) * 0.5f;
+  bool inside = true;
+  for (uint32_t p = 0; p < 6; p++) {
+    const glm::vec3 normal(planes[p]);
+    const float distance = glm::dot(normal, center) + planes[p].w;
+    const float radius = glm::dot(extent, glm::abs(normal));
+    if (distance + radius < 0.0f)
+      return Containment::eOutside;
+    if (distance - radius < 0.0f)
+      inside = false;
+  }
+  return inside ? Containment::eInside : Containment::eIntersecting;
+}
+
+float GetSquaredDistance(const Aabb &box, const glm::vec3 &point) {
+  const glm::vec3 closest = glm::clamp(point, box.min, box.max);
+  const glm::vec3 offset = point - closest;
+  return glm::dot(offset, offset);
+}
+
+/** Distance at which the ray enters the box, or FLT_MAX if it misses it */
+float IntersectRay(const Aabb &box, const glm::vec3 &origin, const glm::vec3 &inverseDirection,
+                   float maxDistance) {
+  const glm::vec3 t0 = (box.min - origin) * inverseDirection;
+  const glm::vec3 t1 = (box.max - origin) * inverseDirection;
+  const glm::vec3 tMin = glm::min(t0, t1);
+  const glm::vec3 tMax = glm::max(t0, t1);
+  const float enter = std::max({tMin.x, tMin.y, tMin.z, 0.0f});
+  const float exit = std::min({tMax.x, tMax.y, tMax.z, maxDistance});
+  return enter <= exit ? enter : FLT_MAX;
+}
+
+bool operator==(const Aabb &a, const Aabb &b) { return a.min == b.min && a.max == b.max; }
+
+} // namespace
+
+// ==== Aabb ====
+
+void Aabb::Grow(const glm::vec3 &point) {
+  min = glm::min(min, point);
+  max = glm::max(max, point);
+}
+
+void Aabb::Grow(const Aabb &box) {
+  min = glm::min(min, box.min);
+  max = glm::max(max, box.max);
+}
+
+glm::vec3 Aabb::GetCenter() const { return (min + max) * 0.5f; }
+
+float Aabb::GetHalfArea() const {
+  const glm::vec3 size = max - min;
+  if (size.x < 0.0f)
+    return 0.0f;
+  return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+// ==== Build ====
+
+void Bvh::Build(std::vector<Aabb> bounds) {
+  _bounds = std::move(bounds);
+  const auto count = static_cast<uint32_t>(_bounds.size());
+  _objects.resize(count);
+  std::iota(_objects.begin(), _objects.end(), 0);
+  _leaves.assign(count, 0);
+  _nodes.clear();
+  _buildCost = 0.0f;
+  if (count == 0)
+    return;
+
+  // A binary tree with non-empty leaves has less than 2 * count nodes, so the vector never grows
+  _nodes.reserve(2 * count);
+  _nodes.push_back(Node{
+      .bounds = {},
+      .firstObject = 0,
+      .objectCount = count,
+      .leftChild = 0,
+      .parent = 0,
+  });
+
+  // Children are appended after their parent, so a single pass splits the whole tree
+  std::vector<uint8_t> depths(1, 0);
+  depths.reserve(2 * count);
+  for (uint32_t i = 0; i < _nodes.size(); i++) {
+    if (depths[i] + 1u < BVH_MAX_DEPTH) {
+      Subdivide(i);
+    } else {
+      // Too deep: the node stays a leaf, whatever its size
+      Node &node = _nodes[i];
+      for (uint32_t o = node.firstObject; o < node.firstObject + node.objectCount; o++) {
+        node.bounds.Grow(_bounds[_objects[o]]);
+        _leaves[_objects[o]] = i;
+      }
+    }
+    depths.resize(_nodes.size(), depths[i] + 1);
+  }
+
+  _buildCost = ComputeCost();
+}
+
+void Bvh::Subdivide(uint32_t nodeIndex) {
+  const uint32_t first = _nodes[nodeIndex].firstObject;
+  const uint32_t count = _nodes[nodeIndex].objectCount;
+
+  // Bounds of the node, and of the centers of its objects
+  Aabb bounds;
+  Aabb centers;
+  for (uint32_t i = first; i < first + count; i++) {
+    bounds.Grow(_bounds[_objects[i]]);
+    centers.Grow(_bounds[_objects[i]].GetCenter());
+    // Set for every node on the way down, so the last one is the leaf
+    _leaves[_objects[i]] = nodeIndex;
+  }
+  _nodes[nodeIndex].bounds = bounds;
+  if (count <= 1)
+    return;
+
+  // Find the cheapest split between two bins, on every axis
+  struct Bin {
+    Aabb bounds;
+    uint32_t count = 0;
+  };
+  auto getBin = [&](uint32_t object, uint32_t axis, float scale) {
+    const float position = (_bounds[object].GetCenter()[axis] - centers.min[axis]) * scale;
+    return std::min(static_cast<uint32_t>(position), BVH_BIN_COUNT - 1);
+  };
+  float bestCost = FLT_MAX;
+  uint32_t bestAxis = 0;
+  uint32_t bestSplit = 0;
+  for (uint32_t axis = 0; axis < 3; axis++) {
+    const float extent = centers.max[axis] - centers.min[axis];
+    if (extent <= 0.0f)
+      continue;
+    const float scale = static_cast<float>(BVH_BIN_COUNT) / extent;
+
+    std::array<Bin, BVH_BIN_COUNT> bins{};
+    for (uint32_t i = first; i < first + count; i++) {
+      Bin &bin = bins[getBin(_objects[i], axis, scale)];
+      bin.bounds.Grow(_bounds[_objects[i]]);
+      bin.count++;
+    }
+
+    // Cost of the left side of each split, then sweep from the right
+    std::array<float, BVH_BIN_COUNT - 1> leftCosts{};
+    Aabb left;
+    uint32_t leftCount = 0;
+    for (uint32_t b = 0; b < BVH_BIN_COUNT - 1; b++) {
+      left.Grow(bins[b].bounds);
+      leftCount += bins[b].count;
+      leftCosts[b] = static_cast<float>(leftCount) * left.GetHalfArea();
+    }
+    Aabb right;
+    uint32_t rightCount = 0;
+    for (uint32_t b = BVH_BIN_COUNT - 1; b > 0; b--) {
+      right.Grow(bins[b].bounds);
+      rightCount += bins[b].count;
+      const float cost = leftCosts[b - 1] + static_cast<float>(rightCount) * right.GetHalfArea();
+      if (rightCount > 0 && rightCount < count && cost < bestCost) {
+        bestCost = cost;
+        bestAxis = axis;
+        bestSplit = b;
+      }
+    }
+  }
+
+  // Small nodes are only split when visiting both children is cheaper than testing every object
+  const float leafCost = static_cast<float>(count) * bounds.GetHalfArea();
+  if (bestCost == FLT_MAX || (count <= BVH_MAX_LEAF_SIZE && bestCost + bounds.GetHalfArea() >= leafCost))
+    return;
+
+  const float scale = static_cast<float>(BVH_BIN_COUNT) / (centers.max[bestAxis] - centers.min[bestAxis]);
+  const auto begin = _objects.begin() + first;
+  const auto middle = std::partition(begin, begin + count, [&](uint32_t object) {
+    return getBin(object, bestAxis, scale) < bestSplit;
+  });
+  const auto leftCount = static_cast<uint32_t>(middle - begin);
+
+  const auto leftChild = static_cast<uint32_t>(_nodes.size());
+  _nodes[nodeIndex].leftChild = leftChild;
+  _nodes.push_back(Node{
+      .bounds = {},
+      .firstObject = first,
+      .objectCount = leftCount,
+      .leftChild = 0,
+      .parent = nodeIndex,
+  });
+  _nodes.push_back(Node{
+      .bounds = {},
+      .firstObject = first + leftCount,
+      .objectCount = count - leftCount,
+      .leftChild = 0,
+      .parent = nodeIndex,
+  });
+}
+
+float Bvh::ComputeCost() const {
+  if (_nodes.empty() || _nodes[0].bounds.GetHalfArea() <= 0.0f)
+    return 0.0f;
+
+  // Visiting a node and testing an object are given the same cost
+  float cost = 0.0f;
+  for (const Node &node : _nodes) {
+    const float count = node.leftChild == 0 ? static_cast<float>(node.objectCount) : 1.0f;
+    cost += count * node.bounds.GetHalfArea();
+  }
+  return cost / _nodes[0].bounds.GetHalfArea();
+}
+
+// ==== Updates ====
+
+void Bvh::Refit(uint32_t object, const Aabb &bounds) {
+  _bounds[object] = bounds;
+
+  // Go up until a node doesn't change: the ones above it don't either
+  uint32_t nodeIndex = _leaves[object];
+  while (true) {
+    Node &node = _nodes[nodeIndex];
+    Aabb nodeBounds;
+    if (node.leftChild == 0) {
+      for (uint32_t i = node.firstObject; i < node.firstObject + node.objectCount; i++) {
+        nodeBounds.Grow(_bounds[_objects[i]]);
+      }
+    } else {
+      nodeBounds.Grow(_nodes[node.leftChild].bounds);
+      nodeBounds.Grow(_nodes[node.leftChild + 1].bounds);
+    }
+
+    if (nodeBounds == node.bounds)
+      break;
+    node.bounds = nodeBounds;
+    if (nodeIndex == 0)
+      break;
+    nodeIndex = node.parent;
+  }
+}
+
+float Bvh::GetDegradation() const { return _buildCost > 0.0f ? ComputeCost() / _buildCost : 1.0f; }
+
+uint32_t Bvh::GetObjectCount() const { return static_cast<uint32_t>(_bounds.size()); }
+
+const Aabb &Bvh::GetBounds(uint32_t object) const { return _bounds[object]; }
+
+// ==== Queries ====
+
+void Bvh::QueryFrustum(const glm::vec4 planes[6], std::vector<uint32_t> &results) const {
+  results.clear();
+  if (_nodes.empty())
+    return;
+
+  std::array<uint32_t, BVH_MAX_DEPTH> stack{};
+  uint32_t stackSize = 0;
+  stack[stackSize++] = 0;
+  while (stackSize > 0) {
+    const Node &node = _nodes[stack[--stackSize]];
+    const Containment containment = TestFrustum(node.bounds, planes);
+    if (containment == Containment::eOutside)
+      continue;
+
+    // Everything below is visible: no need to test it
+    if (containment == Containment::eInside) {
+      results.insert(results.end(), _objects.begin() + node.firstObject,
+                     _objects.begin() + node.firstObject + node.objectCount);
+    } else if (node.leftChild == 0) {
+      for (uint32_t i = node.firstObject; i < node.firstObject + node.objectCount; i++) {
+        if (TestFrustum(_bounds[_objects[i]], planes) != Containment::eOutside) {
+          results.push_back(_objects[i]);
+        }
+      }
+    } else {
+      stack[stackSize++] = node.leftChild;
+      stack[stackSize++] = node.leftChild + 1;
+    }
+  }
+}
+
+void Bvh::QueryRadius(const glm::vec3 &center, float radius, std::vector<uint32_t> &results) const {
+  results.clear();
+  if (_nodes.empty())
+    return;
+
+  const float squaredRadius = radius * radius;
+  std::array<uint32_t, BVH_MAX_DEPTH> stack{};
+  uint32_t stackSize = 0;
+  stack[stackSize++] = 0;
+  while (stackSize > 0) {
+    const Node &node = _nodes[stack[--stackSize]];
+    if (GetSquaredDistance(node.bounds, center) > squaredRadius)
+      continue;
+
+    if (node.leftChild == 0) {
+      for (uint32_t i = node.firstObject; i < node.firstObject + node.objectCount; i++) {
+        if (GetSquaredDistance(_bounds[_objects[i]], center) <= squaredRadius) {
+          results.push_back(_objects[i]);
+        }
+      }
+    } else {
+      stack[stackSize++] = node.leftChild;
+      stack[stackSize++] = node.leftChild + 1;
+    }
+  }
+}
+
+uint32_t Bvh::Raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance,
+                      float *distance) const {
+  if (_nodes.empty())
+    return NO_OBJECT;
+
+  const glm::vec3 inverseDirection = 1.0f / direction;
+  uint32_t closestObject = NO_OBJECT;
+  float closestDistance = maxDistance;
+
+  std::array<uint32_t, BVH_MAX_DEPTH> stack{};
+  uint32_t stackSize = 0;
+  stack[stackSize++] = 0;
+  while (stackSize > 0) {
+    const Node &node = _nodes[stack[--stackSize]];
+    if (IntersectRay(node.bounds, origin, inverseDirection, closestDistance) == FLT_MAX)
+      continue;
+
+    if (node.leftChild == 0) {
+      for (uint32_t i = node.firstObject; i < node.firstObject + node.objectCount; i++) {
+        const float hit = IntersectRay(_bounds[_objects[i]], origin, inverseDirection, closestDistance);
+        if (hit != FLT_MAX && (closestObject == NO_OBJECT || hit < closestDistance)) {
+          closestDistance = hit;
+          closestObject = _objects[i];
+        }
+      }
+    } else {
+      // Visit the closest child first, so that the other one is more likely to be skipped
+      const Node &leftNode = _nodes[node.leftChild];
+      const Node &rightNode = _nodes[node.leftChild + 1];
+      const float left = IntersectRay(leftNode.bounds, origin, inverseDirection, closestDistance);
+      const float right = IntersectRay(rightNode.bounds, origin, inverseDirection, closestDistance);
+      const bool leftFirst = left <= right;
+      stack[stackSize++] = leftFirst ? node.leftChild + 1 : node.leftChild;
+      stack[stackSize++] = leftFirst ? node.leftChild : node.leftChild + 1;
+    }
+  }
+
+  if (distance != nullptr && closestObject != NO_OBJECT) {
+    *distance = closestDistance;
+  }
+  return closestObject;
+}
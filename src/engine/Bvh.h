@@ -0,0 +1,90 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include <cfloat>
+#include <cstdint>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <vector>
+
+/** Object index meaning that no object was found */
+constexpr uint32_t NO_OBJECT = ~0u;
+/** Leaves are split until they hold at most this many objects, unless the split costs more than the leaf */
+constexpr uint32_t BVH_MAX_LEAF_SIZE = 4;
+/** Bins used to evaluate the splits on each axis */
+constexpr uint32_t BVH_BIN_COUNT = 16;
+
+/** Axis aligned bounding box. Empty by default. */
+struct Aabb {
+  glm::vec3 min{FLT_MAX};
+  glm::vec3 max{-FLT_MAX};
+
+  void Grow(const glm::vec3 &point);
+  void Grow(const Aabb &box);
+  [[nodiscard]] glm::vec3 GetCenter() const;
+  /** Half of the surface area, which is enough to compare boxes. 0 for empty boxes. */
+  [[nodiscard]] float GetHalfArea() const;
+};
+
+/**
+ * Bounding volume hierarchy over the boxes of objects, identified by their index in the array given to Build.
+ *
+ * The tree is built top-down with binned SAH: the objects of each node are sorted in bins along each axis by
+ * the center of their box, and the split between the bins with the lowest surface area cost is chosen.
+ * Moving objects are refit in place, which keeps the queries correct but makes the boxes looser over time:
+ * GetDegradation tells when a rebuild is worth it. Since the tree is a value, it can be rebuilt on a job.
+ */
+class Bvh {
+private:
+  struct Node {
+    Aabb bounds;
+    /** Range of the objects of the node in _objects. The objects of a subtree are contiguous. */
+    uint32_t firstObject;
+    uint32_t objectCount;
+    /** Index of the left child, followed by the right one. 0 for leaves, since the root is never a child. */
+    uint32_t leftChild;
+    uint32_t parent;
+  };
+
+  std::vector<Node> _nodes;
+  /** Objects sorted by leaf */
+  std::vector<uint32_t> _objects;
+  std::vector<Aabb> _bounds;
+  /** Leaf containing each object */
+  std::vector<uint32_t> _leaves;
+  /** SAH cost of the tree right after the build */
+  float _buildCost = 0.0f;
+
+  void Subdivide(uint32_t nodeIndex);
+  [[nodiscard]] float ComputeCost() const;
+
+public:
+  /** Builds the tree over the given boxes. Replaces the previous one. */
+  void Build(std::vector<Aabb> bounds);
+  /** Changes the box of an object, and grows or shrinks the nodes above it */
+  void Refit(uint32_t object, const Aabb &bounds);
+
+  /** SAH cost of the tree divided by its cost after the build. Goes over 1 as refits degrade it. */
+  [[nodiscard]] float GetDegradation() const;
+  [[nodiscard]] uint32_t GetObjectCount() const;
+  [[nodiscard]] const Aabb &GetBounds(uint32_t object) const;
+
+  /**
+   * Finds the objects whose box is at least partly inside the frustum.
+   * @param planes planes of the frustum, pointing inside, as (normal, distance)
+   */
+  void QueryFrustum(const glm::vec4 planes[6], std::vector<uint32_t> &results) const;
+  /** Finds the objects whose box is closer than radius to the center */
+  void QueryRadius(const glm::vec3 &center, float radius, std::vector<uint32_t> &results) const;
+  /**
+   * Finds the first object whose box is hit by the ray.
+   * @param direction normalized direction of the ray
+   * @param distance set to the distance of the hit, if there is one
+   * @return the object, or NO_OBJECT
+   */
+  uint32_t Raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance,
+                   float *distance = nullptr) const;
+};
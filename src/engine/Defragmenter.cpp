@@ -0,0 +1,127 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "Defragmenter.h"
+#include <algorithm>
+#include <sstream>
+
+// ==== Metrics ====
+
+float FragmentationMetrics::GetFragmentation() const {
+  if (unusedSize == 0)
+    return 0.0f;
+  return 1.0f - static_cast<float>(largestFreeRange) / static_cast<float>(unusedSize);
+}
+
+std::string FragmentationMetrics::ToString() const {
+  std::ostringstream string;
+  string << (size - unusedSize) / 1024 << " / " << size / 1024 << " KiB used in " << blockCount << " blocks, "
+         << allocationCount << " allocations, " << freeRangeCount << " free ranges (largest: "
+         << largestFreeRange / 1024 << " KiB), fragmentation " << GetFragmentation();
+  return string.str();
+}
+
+// ==== Defragmenter ====
+
+void Defragmenter::Init(vk::Device device, VmaAllocator allocator, DeletionQueue *deletionQueue,
+                        std::vector<VmaPool> pools, const DefragmentationPolicy &policy) {
+  _device = device;
+  _allocator = allocator;
+  _deletionQueue = deletionQueue;
+  _pools = std::move(pools);
+  _policy = policy;
+}
+
+void Defragmenter::Register(vk::Buffer &buffer, VmaAllocation allocation,
+                            const vk::BufferCreateInfo &createInfo) {
+  _buffers[allocation] = MovableBuffer{.buffer = &buffer, .createInfo = createInfo};
+  _compacted = false;
+}
+
+void Defragmenter::Unregister(VmaAllocation allocation) {
+  _buffers.erase(allocation);
+  _compacted = false;
+}
+
+FragmentationMetrics Defragmenter::GetMetrics() const {
+  FragmentationMetrics metrics;
+  for (auto pool : _pools) {
+    VmaPoolStats stats;
+    vmaGetPoolStats(_allocator, pool, &stats);
+    metrics.size += stats.size;
+    metrics.unusedSize += stats.unusedSize;
+    metrics.largestFreeRange = std::max(metrics.largestFreeRange, stats.unusedRangeSizeMax);
+    metrics.blockCount += stats.blockCount;
+    metrics.allocationCount += stats.allocationCount;
+    metrics.freeRangeCount += stats.unusedRangeCount;
+  }
+  return metrics;
+}
+
+bool Defragmenter::NeedsPass(uint64_t frame) {
+  if (_context || _compacted || _buffers.empty() || frame < _lastCheckFrame + _policy.framesBetweenChecks)
+    return false;
+
+  _lastCheckFrame = frame;
+  return GetMetrics().GetFragmentation() >= _policy.fragmentationThreshold;
+}
+
+void Defragmenter::BeginPass(vk::CommandBuffer cmd) {
+  _passMetrics = GetMetrics();
+  _passStats = {};
+  _passAllocations.clear();
+  for (const auto &[allocation, buffer] : _buffers) {
+    _passAllocations.push_back(allocation);
+  }
+  _passChanged.assign(_passAllocations.size(), VK_FALSE);
+
+  // Everything is copied by the GPU, since the pools are not host visible
+  VmaDefragmentationInfo2 defragmentationInfo{
+      .flags = 0,
+      .allocationCount = static_cast<uint32_t>(_passAllocations.size()),
+      .pAllocations = _passAllocations.data(),
+      .pAllocationsChanged = _passChanged.data(),
+      .poolCount = 0,
+      .pPools = nullptr,
+      .maxCpuBytesToMove = 0,
+      .maxCpuAllocationsToMove = 0,
+      .maxGpuBytesToMove = _policy.maxBytesPerPass,
+      .maxGpuAllocationsToMove = _policy.maxAllocationsPerPass,
+      .commandBuffer = cmd,
+  };
+  vmaDefragmentationBegin(_allocator, &defragmentationInfo, &_passStats, &_context);
+}
+
+DefragmentationReport Defragmenter::EndPass(uint64_t frame) {
+  DefragmentationReport report;
+  report.before = _passMetrics;
+  if (_context) {
+    vmaDefragmentationEnd(_allocator, _context);
+    _context = nullptr;
+  }
+
+  for (size_t i = 0; i < _passAllocations.size(); i++) {
+    if (!_passChanged[i])
+      continue;
+
+    // The old buffer is still bound to the previous place of the allocation
+    VmaAllocation allocation = _passAllocations[i];
+    MovableBuffer &moved = _buffers.at(allocation);
+    _deletionQueue->Retire(*moved.buffer, frame);
+
+    vk::Buffer newBuffer = _device.createBuffer(moved.createInfo);
+    vmaBindBufferMemory(_allocator, allocation, newBuffer);
+    *moved.buffer = newBuffer;
+    _deletionQueue->ReplaceBuffer(allocation, newBuffer);
+    report.movedAllocations.push_back(allocation);
+  }
+
+  report.after = GetMetrics();
+  report.bytesMoved = _passStats.bytesMoved;
+  report.bytesFreed = _passStats.bytesFreed;
+  report.blocksFreed = _passStats.deviceMemoryBlocksFreed;
+  // Nothing to gain until the buffers change
+  _compacted = report.movedAllocations.empty();
+  return report;
+}
@@ -0,0 +1,108 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include "DeletionQueue.h"
+#include "vk_types.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** State of the free space of the defragmented pools */
+struct FragmentationMetrics {
+  vk::DeviceSize size = 0;
+  vk::DeviceSize unusedSize = 0;
+  /** Largest allocation that could still fit without a new block */
+  vk::DeviceSize largestFreeRange = 0;
+  size_t blockCount = 0;
+  size_t allocationCount = 0;
+  size_t freeRangeCount = 0;
+
+  /** 0 when the free space is a single range, close to 1 when it is split in many small ranges */
+  [[nodiscard]] float GetFragmentation() const;
+  [[nodiscard]] std::string ToString() const;
+};
+
+/** Result of a defragmentation pass */
+struct DefragmentationReport {
+  FragmentationMetrics before;
+  FragmentationMetrics after;
+  vk::DeviceSize bytesMoved = 0;
+  vk::DeviceSize bytesFreed = 0;
+  uint32_t blocksFreed = 0;
+  /** Allocations whose buffer was recreated. The descriptors using them must be rewritten. */
+  std::vector<VmaAllocation> movedAllocations;
+};
+
+struct DefragmentationPolicy {
+  /** Bytes copied in one pass. Bounds the time the pass takes on the GPU. */
+  vk::DeviceSize maxBytesPerPass = 16ull << 20;
+  uint32_t maxAllocationsPerPass = 256;
+  /** A pass runs when the fragmentation goes over it */
+  float fragmentationThreshold = 0.5f;
+  /** Frames between two checks of the fragmentation */
+  uint32_t framesBetweenChecks = 120;
+};
+
+/**
+ * Incremental defragmentation of the buffers of some pools, using the GPU defragmentation of VMA.
+ *
+ * Each pass moves a bounded amount of memory with copy commands. The moved buffers are recreated, bound to
+ * their new place and patched in their owner, and the old buffers are retired to the deletion queue.
+ *
+ * Only buffers can be moved: VMA can't move images with an optimal tiling.
+ */
+class Defragmenter {
+private:
+  struct MovableBuffer {
+    /** Handle stored by the owner of the buffer, patched when it moves */
+    vk::Buffer *buffer;
+    vk::BufferCreateInfo createInfo;
+  };
+
+  vk::Device _device = nullptr;
+  VmaAllocator _allocator = nullptr;
+  DeletionQueue *_deletionQueue = nullptr;
+  std::vector<VmaPool> _pools;
+  DefragmentationPolicy _policy;
+  std::unordered_map<VmaAllocation, MovableBuffer> _buffers;
+  uint64_t _lastCheckFrame = 0;
+  /** Set when a pass couldn't move anything, until the registered buffers change */
+  bool _compacted = false;
+
+  // Pass in progress
+  VmaDefragmentationContext _context = nullptr;
+  VmaDefragmentationStats _passStats = {};
+  FragmentationMetrics _passMetrics;
+  std::vector<VmaAllocation> _passAllocations;
+  std::vector<VkBool32> _passChanged;
+
+public:
+  void Init(vk::Device device, VmaAllocator allocator, DeletionQueue *deletionQueue,
+            std::vector<VmaPool> pools, const DefragmentationPolicy &policy = {});
+
+  /**
+   * Allows a buffer to be moved.
+   * @param buffer handle of the buffer in its owner. It must stay valid until the buffer is unregistered.
+   * @param createInfo used to recreate the buffer at its new place
+   */
+  void Register(vk::Buffer &buffer, VmaAllocation allocation, const vk::BufferCreateInfo &createInfo);
+  void Unregister(VmaAllocation allocation);
+
+  [[nodiscard]] FragmentationMetrics GetMetrics() const;
+  /** Checks the fragmentation from time to time. Returns true if a pass should run. */
+  [[nodiscard]] bool NeedsPass(uint64_t frame);
+
+  /**
+   * Chooses the buffers to move, and records the copies in the command buffer.
+   * The frames using the registered buffers must be done.
+   */
+  void BeginPass(vk::CommandBuffer cmd);
+  /**
+   * Recreates the moved buffers once the command buffer of BeginPass has executed.
+   * @param frame frame retiring the old buffers
+   */
+  DefragmentationReport EndPass(uint64_t frame);
+};
@@ -0,0 +1,136 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "DeletionQueue.h"
+
+// ==== Deletion list ====
+
+void DeletionList::Add(vk::Pipeline pipeline) { pipelines.push_back(pipeline); }
+void DeletionList::Add(vk::Sampler sampler) { samplers.push_back(sampler); }
+void DeletionList::Add(vk::ImageView imageView) { imageViews.push_back(imageView); }
+void DeletionList::Add(const AllocatedImage &image) { images.push_back(image); }
+void DeletionList::Add(const AllocatedBuffer &buffer) { buffers.push_back(buffer); }
+void DeletionList::Add(vk::Buffer buffer) { bufferHandles.push_back(buffer); }
+void DeletionList::Add(vk::DescriptorPool descriptorPool) { descriptorPools.push_back(descriptorPool); }
+void DeletionList::Add(vk::CommandPool commandPool) { commandPools.push_back(commandPool); }
+void DeletionList::Add(vk::Fence fence) { fences.push_back(fence); }
+void DeletionList::Add(vk::Semaphore semaphore) { semaphores.push_back(semaphore); }
+
+void DeletionList::Destroy(vk::Device device, VmaAllocator allocator, MemoryTracker *memoryTracker) {
+  // Users first, then what they use
+  for (auto pipeline : pipelines) {
+    device.destroyPipeline(pipeline);
+  }
+  for (auto sampler : samplers) {
+    device.destroySampler(sampler);
+  }
+  for (auto imageView : imageViews) {
+    device.destroyImageView(imageView);
+  }
+  for (const auto &image : images) {
+    if (memoryTracker) {
+      memoryTracker->Untrack(image.allocation);
+    }
+    vmaDestroyImage(allocator, image.image, image.allocation);
+  }
+  for (const auto &buffer : buffers) {
+    if (memoryTracker) {
+      memoryTracker->Untrack(buffer.allocation);
+    }
+    vmaDestroyBuffer(allocator, buffer.buffer, buffer.allocation);
+  }
+  for (auto buffer : bufferHandles) {
+    device.destroyBuffer(buffer);
+  }
+  for (auto descriptorPool : descriptorPools) {
+    device.destroyDescriptorPool(descriptorPool);
+  }
+  for (auto commandPool : commandPools) {
+    device.destroyCommandPool(commandPool);
+  }
+  for (auto fence : fences) {
+    device.destroyFence(fence);
+  }
+  for (auto semaphore : semaphores) {
+    device.destroySemaphore(semaphore);
+  }
+
+  pipelines.clear();
+  samplers.clear();
+  imageViews.clear();
+  images.clear();
+  buffers.clear();
+  bufferHandles.clear();
+  descriptorPools.clear();
+  commandPools.clear();
+  fences.clear();
+  semaphores.clear();
+}
+
+bool DeletionList::IsEmpty() const {
+  return pipelines.empty() && samplers.empty() && imageViews.empty() && images.empty() && buffers.empty() &&
+         bufferHandles.empty() && descriptorPools.empty() && commandPools.empty() && fences.empty() &&
+         semaphores.empty();
+}
+
+// ==== Deletion queue ====
+
+void DeletionQueue::Init(vk::Device device, VmaAllocator allocator, MemoryTracker *memoryTracker) {
+  _device = device;
+  _allocator = allocator;
+  _memoryTracker = memoryTracker;
+}
+
+DeletionList &DeletionQueue::GetRetiredList(uint64_t frame) {
+  // Resources are retired by the frame being recorded, so the list is almost always the last one
+  if (!_retiredLists.empty() && _retiredLists.back().frame == frame)
+    return _retiredLists.back().list;
+
+  auto position = _retiredLists.end();
+  while (position != _retiredLists.begin() && (position - 1)->frame > frame) {
+    position--;
+  }
+  if (position != _retiredLists.begin() && (position - 1)->frame == frame)
+    return (position - 1)->list;
+
+  RetiredList retiredList{.frame = frame, .list = {}};
+  if (!_freeLists.empty()) {
+    retiredList.list = std::move(_freeLists.back());
+    _freeLists.pop_back();
+  }
+  return _retiredLists.insert(position, std::move(retiredList))->list;
+}
+
+void DeletionQueue::PushFunction(std::function<void()> &&function) {
+  _deletors.push_back(std::move(function));
+}
+
+void DeletionQueue::ReplaceBuffer(VmaAllocation allocation, vk::Buffer buffer) {
+  for (auto &registered : _shutdownList.buffers) {
+    if (registered.allocation == allocation) {
+      registered.buffer = buffer;
+      return;
+    }
+  }
+}
+
+void DeletionQueue::Flush(uint64_t completedFrame) {
+  while (!_retiredLists.empty() && _retiredLists.front().frame <= completedFrame) {
+    _retiredLists.front().list.Destroy(_device, _allocator, _memoryTracker);
+    _freeLists.push_back(std::move(_retiredLists.front().list));
+    _retiredLists.pop_front();
+  }
+}
+
+void DeletionQueue::FlushAll() {
+  Flush(UINT64_MAX);
+  _freeLists.clear();
+  _shutdownList.Destroy(_device, _allocator, _memoryTracker);
+
+  // Reverse iterate the functions, so that objects are destroyed before the ones they depend on
+  for (auto it = _deletors.rbegin(); it != _deletors.rend(); it++) {
+    (*it)();
+  }
+  _deletors.clear();
+}
@@ -0,0 +1,90 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include "MemoryTracker.h"
+#include "vk_types.h"
+#include <deque>
+#include <functional>
+#include <vector>
+
+/** Resources destroyed together, stored by type so that registering one doesn't allocate a closure */
+struct DeletionList {
+  std::vector<vk::Pipeline> pipelines;
+  std::vector<vk::Sampler> samplers;
+  std::vector<vk::ImageView> imageViews;
+  std::vector<AllocatedImage> images;
+  std::vector<AllocatedBuffer> buffers;
+  /** Buffers whose memory now belongs to another buffer, like the ones moved by the defragmentation */
+  std::vector<vk::Buffer> bufferHandles;
+  std::vector<vk::DescriptorPool> descriptorPools;
+  std::vector<vk::CommandPool> commandPools;
+  std::vector<vk::Fence> fences;
+  std::vector<vk::Semaphore> semaphores;
+
+  void Add(vk::Pipeline pipeline);
+  void Add(vk::Sampler sampler);
+  void Add(vk::ImageView imageView);
+  void Add(const AllocatedImage &image);
+  void Add(const AllocatedBuffer &buffer);
+  void Add(vk::Buffer buffer);
+  void Add(vk::DescriptorPool descriptorPool);
+  void Add(vk::CommandPool commandPool);
+  void Add(vk::Fence fence);
+  void Add(vk::Semaphore semaphore);
+
+  /**
+   * Destroys every resource of the list, and empties it without releasing its memory.
+   * @param memoryTracker if not null, the allocations are untracked before being freed
+   */
+  void Destroy(vk::Device device, VmaAllocator allocator, MemoryTracker *memoryTracker);
+  [[nodiscard]] bool IsEmpty() const;
+};
+
+/**
+ * Deferred destruction of the GPU resources.
+ *
+ * - Resources pushed with Push live until the engine shuts down.
+ * - Resources retired with Retire may still be used by the frames in flight. They are tagged with the number
+ *   of the frame that retired them, and destroyed by Flush once the fence of that frame has signaled.
+ *
+ * Functions can still be pushed for the objects that need more than a destroy call, like the swapchain.
+ * They are called at shutdown, after the typed resources, in reverse order.
+ */
+class DeletionQueue {
+private:
+  struct RetiredList {
+    uint64_t frame;
+    DeletionList list;
+  };
+
+  vk::Device _device = nullptr;
+  VmaAllocator _allocator = nullptr;
+  MemoryTracker *_memoryTracker = nullptr;
+  DeletionList _shutdownList;
+  /** Lists of retired resources, sorted by frame */
+  std::deque<RetiredList> _retiredLists;
+  /** Flushed lists, kept to reuse their memory */
+  std::vector<DeletionList> _freeLists;
+  std::vector<std::function<void()>> _deletors;
+
+  DeletionList &GetRetiredList(uint64_t frame);
+
+public:
+  void Init(vk::Device device, VmaAllocator allocator, MemoryTracker *memoryTracker = nullptr);
+
+  /** Destroys the resource at shutdown */
+  template <class T> void Push(const T &resource) { _shutdownList.Add(resource); }
+  /** Destroys the resource once the given frame and the ones before it are done on the GPU */
+  template <class T> void Retire(const T &resource, uint64_t frame) { GetRetiredList(frame).Add(resource); }
+  void PushFunction(std::function<void()> &&function);
+  /** The buffer of the given allocation was recreated: destroy the new one at shutdown instead */
+  void ReplaceBuffer(VmaAllocation allocation, vk::Buffer buffer);
+
+  /** Destroys the resources retired on completedFrame or before it */
+  void Flush(uint64_t completedFrame);
+  /** Destroys everything. The GPU must be idle. */
+  void FlushAll();
+};
@@ -0,0 +1,127 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "ImageProcessing.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMGUTILS_SSE2
+#include <emmintrin.h>
+#endif
+
+bool imgutils::LoadImage(const char *filename, ImageData &image) {
+  int width, height, channels;
+  stbi_uc *pixels = stbi_load(filename, &width, &height, &channels, STBI_rgb_alpha);
+  if (pixels == nullptr) {
+    std::cerr << "Failed to load image " << filename << ": " << stbi_failure_reason() << '\n';
+    return false;
+  }
+
+  // Store it as the first mip level
+  const size_t size = static_cast<size_t>(width) * height * BYTES_PER_PIXEL;
+  image.pixels.assign(pixels, pixels + size);
+  image.mips = {MipLevel{
+      .width = static_cast<uint32_t>(width),
+      .height = static_cast<uint32_t>(height),
+      .offset = 0,
+      .size = size,
+  }};
+
+  stbi_image_free(pixels);
+  return true;
+}
+
+uint32_t imgutils::GetMipLevelCount(uint32_t width, uint32_t height) {
+  uint32_t levels = 1;
+  while (width > 1 || height > 1) {
+    width = std::max(width / 2, 1u);
+    height = std::max(height / 2, 1u);
+    levels++;
+  }
+  return levels;
+}
+
+void imgutils::GenerateMipChain(ImageData &image) {
+  if (image.mips.empty())
+    return;
+
+  // Compute the layout of the whole chain first, so the pixels are only allocated once
+  const uint32_t levelCount = GetMipLevelCount(image.mips[0].width, image.mips[0].height);
+  image.mips.resize(1);
+  for (uint32_t i = 1; i < levelCount; i++) {
+    const MipLevel &previous = image.mips[i - 1];
+    uint32_t width = std::max(previous.width / 2, 1u);
+    uint32_t height = std::max(previous.height / 2, 1u);
+    image.mips.push_back(MipLevel{
+        .width = width,
+        .height = height,
+        .offset = previous.offset + previous.size,
+        .size = static_cast<size_t>(width) * height * BYTES_PER_PIXEL,
+    });
+  }
+  image.pixels.resize(image.mips.back().offset + image.mips.back().size);
+
+  // Each level is computed from the previous one
+  for (uint32_t i = 1; i < levelCount; i++) {
+    const MipLevel &src = image.mips[i - 1];
+    DownsampleBox(image.pixels.data() + src.offset, src.width, src.height,
+                  image.pixels.data() + image.mips[i].offset);
+  }
+}
+
+void imgutils::DownsampleBox(const uint8_t *src, uint32_t srcWidth, uint32_t srcHeight, uint8_t *dst) {
+  const uint32_t dstWidth = std::max(srcWidth / 2, 1u);
+  const uint32_t dstHeight = std::max(srcHeight / 2, 1u);
+  const size_t srcStride = static_cast<size_t>(srcWidth) * BYTES_PER_PIXEL;
+
+  for (uint32_t y = 0; y < dstHeight; y++) {
+    // Clamp rows for odd heights
+    const uint8_t *row0 = src + std::min(2 * y, srcHeight - 1) * srcStride;
+    const uint8_t *row1 = src + std::min(2 * y + 1, srcHeight - 1) * srcStride;
+    uint8_t *dstRow = dst + static_cast<size_t>(y) * dstWidth * BYTES_PER_PIXEL;
+
+    uint32_t x = 0;
+#ifdef IMGUTILS_SSE2
+    // 4 destination pixels per iteration, from 2 rows of 8 source pixels
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rounding = _mm_set1_epi16(2);
+    for (; (x + 4) * 2 <= srcWidth; x += 4) {
+      __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 2 * BYTES_PER_PIXEL));
+      __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 2 * BYTES_PER_PIXEL + 16));
+      __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 2 * BYTES_PER_PIXEL));
+      __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 2 * BYTES_PER_PIXEL + 16));
+
+      // Vertical sums, widened to 16 bits: each register holds 2 source pixels
+      __m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+      __m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+      __m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+      __m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+      // Horizontal sums of neighbouring pixels
+      __m128i d01 = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+      __m128i d23 = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+
+      // Average with rounding and pack back to 8 bits
+      d01 = _mm_srli_epi16(_mm_add_epi16(d01, rounding), 2);
+      d23 = _mm_srli_epi16(_mm_add_epi16(d23, rounding), 2);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dstRow + x * BYTES_PER_PIXEL), _mm_packus_epi16(d01, d23));
+    }
+#endif
+
+    // Scalar path for the remaining pixels. Columns are clamped for odd widths
+    for (; x < dstWidth; x++) {
+      const uint32_t x0 = std::min(2 * x, srcWidth - 1) * BYTES_PER_PIXEL;
+      const uint32_t x1 = std::min(2 * x + 1, srcWidth - 1) * BYTES_PER_PIXEL;
+      for (uint32_t c = 0; c < BYTES_PER_PIXEL; c++) {
+        uint32_t sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+        dstRow[x * BYTES_PER_PIXEL + c] = static_cast<uint8_t>((sum + 2) / 4);
+      }
+    }
+  }
+}
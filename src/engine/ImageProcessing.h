@@ -0,0 +1,45 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** Location of one mip level in a buffer holding a whole mip chain */
+struct MipLevel {
+  uint32_t width;
+  uint32_t height;
+  size_t offset;
+  size_t size;
+};
+
+/** RGBA8 image with all of its mip levels stored one after another */
+struct ImageData {
+  std::vector<uint8_t> pixels;
+  std::vector<MipLevel> mips;
+};
+
+namespace imgutils {
+constexpr uint32_t BYTES_PER_PIXEL = 4;
+
+/**
+ * Decodes an image file into the first mip level of the image, converted to RGBA8
+ */
+bool LoadImage(const char *filename, ImageData &image);
+
+/**
+ * Appends every missing mip level down to 1x1, each one being a 2x2 box filtered version of the previous one
+ */
+void GenerateMipChain(ImageData &image);
+
+/**
+ * Downsamples a RGBA8 image to half its size (rounded down, at least 1) with a 2x2 box filter.
+ * Uses SSE2 when available. Odd borders are clamped.
+ */
+void DownsampleBox(const uint8_t *src, uint32_t srcWidth, uint32_t srcHeight, uint8_t *dst);
+
+[[nodiscard]] uint32_t GetMipLevelCount(uint32_t width, uint32_t height);
+} // namespace imgutils
@@ -0,0 +1,49 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "JobSystem.h"
+
+JobSystem::JobSystem(uint32_t workerCount) {
+  if (workerCount == 0) {
+    // Keep a thread for the main loop
+    uint32_t hardwareThreads = std::thread::hardware_concurrency();
+    workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+  }
+
+  _workers.reserve(workerCount);
+  for (uint32_t i = 0; i < workerCount; i++) {
+    _workers.emplace_back([this]() { WorkerLoop(); });
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _shouldStop = true;
+  }
+  _condition.notify_all();
+
+  // Remaining jobs are executed before the workers exit
+  for (auto &worker : _workers) {
+    worker.join();
+  }
+}
+
+void JobSystem::WorkerLoop() {
+  while (true) {
+    std::function<void()> job;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _condition.wait(lock, [this]() { return _shouldStop || !_jobs.empty(); });
+      if (_jobs.empty())
+        return;
+
+      job = std::move(_jobs.front());
+      _jobs.pop_front();
+    }
+    job();
+  }
+}
+
+size_t JobSystem::GetWorkerCount() const { return _workers.size(); }
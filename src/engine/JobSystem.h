@@ -0,0 +1,63 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Small pool of worker threads executing jobs in submission order.
+ * Used for CPU work that can run in parallel with the main thread, like image decoding.
+ */
+class JobSystem {
+private:
+  std::vector<std::thread> _workers;
+  std::deque<std::function<void()>> _jobs;
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  bool _shouldStop = false;
+
+  void WorkerLoop();
+
+public:
+  /**
+   * Starts the workers. If workerCount is 0, one worker is created per hardware thread, minus the main one.
+   */
+  explicit JobSystem(uint32_t workerCount = 0);
+  ~JobSystem();
+
+  JobSystem(const JobSystem &) = delete;
+  JobSystem &operator=(const JobSystem &) = delete;
+
+  /**
+   * Queues a job for execution on a worker thread
+   * @return a future holding the result of the job
+   */
+  template <class F> auto Submit(F &&function) -> std::future<std::invoke_result_t<F>>;
+
+  [[nodiscard]] size_t GetWorkerCount() const;
+};
+
+template <class F> auto JobSystem::Submit(F &&function) -> std::future<std::invoke_result_t<F>> {
+  using Result = std::invoke_result_t<F>;
+
+  // std::function needs a copyable callable, so the task is shared
+  auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(function));
+  std::future<Result> future = task->get_future();
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _jobs.emplace_back([task]() { (*task)(); });
+  }
+  _condition.notify_one();
+
+  return future;
+}
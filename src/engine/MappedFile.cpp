@@ -0,0 +1,114 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "MappedFile.h"
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() { Close(); }
+
+MappedFile::MappedFile(MappedFile &&other) noexcept { *this = std::move(other); }
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    Close();
+    std::swap(_data, other._data);
+    std::swap(_size, other._size);
+#ifdef _WIN32
+    std::swap(_fileHandle, other._fileHandle);
+    std::swap(_mappingHandle, other._mappingHandle);
+#endif
+  }
+  return *this;
+}
+
+bool MappedFile::Open(const char *filename) {
+  Close();
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    CloseHandle(file);
+    return false;
+  }
+
+  void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (data == nullptr) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+
+  _fileHandle = file;
+  _mappingHandle = mapping;
+  _data = static_cast<const uint8_t *>(data);
+  _size = static_cast<size_t>(fileSize.QuadPart);
+#else
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat fileStat {};
+  if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+    close(fd);
+    return false;
+  }
+
+  void *data = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after the descriptor is closed
+  close(fd);
+  if (data == MAP_FAILED)
+    return false;
+
+  _data = static_cast<const uint8_t *>(data);
+  _size = static_cast<size_t>(fileStat.st_size);
+#endif
+
+  return true;
+}
+
+void MappedFile::Close() {
+  if (_data == nullptr)
+    return;
+
+#ifdef _WIN32
+  UnmapViewOfFile(_data);
+  CloseHandle(_mappingHandle);
+  CloseHandle(_fileHandle);
+  _fileHandle = nullptr;
+  _mappingHandle = nullptr;
+#else
+  munmap(const_cast<uint8_t *>(_data), _size);
+#endif
+
+  _data = nullptr;
+  _size = 0;
+}
+
+const uint8_t *MappedFile::GetData() const { return _data; }
+
+size_t MappedFile::GetSize() const { return _size; }
+
+bool MappedFile::IsOpen() const { return _data != nullptr; }
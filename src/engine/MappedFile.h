@@ -0,0 +1,36 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Read-only memory mapping of a whole file. The mapping is released when the object is destroyed.
+ */
+class MappedFile {
+private:
+  const uint8_t *_data = nullptr;
+  size_t _size = 0;
+#ifdef _WIN32
+  void *_fileHandle = nullptr;
+  void *_mappingHandle = nullptr;
+#endif
+
+  void Close();
+
+public:
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+
+  bool Open(const char *filename);
+  [[nodiscard]] const uint8_t *GetData() const;
+  [[nodiscard]] size_t GetSize() const;
+  [[nodiscard]] bool IsOpen() const;
+};
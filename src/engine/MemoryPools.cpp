@@ -0,0 +1,166 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "MemoryPools.h"
+#include "vk_init.h"
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+/** Resource representative of what goes in each pool, to find the memory type of the pool */
+VkResult FindMemoryType(VmaAllocator allocator, PoolType type, const VmaAllocationCreateInfo &allocationInfo,
+                        uint32_t *memoryTypeIndex) {
+  if (type == PoolType::eTextures) {
+    auto imageCreateInfo = vkinit::ImageCreateInfo(
+        vk::Format::eR8G8B8A8Unorm, vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst,
+        vk::Extent3D{.width = 1024, .height = 1024, .depth = 1});
+    return vmaFindMemoryTypeIndexForImageInfo(allocator, (VkImageCreateInfo *)&imageCreateInfo, &allocationInfo,
+                                              memoryTypeIndex);
+  }
+
+  vk::BufferCreateInfo bufferCreateInfo{
+      .size = 1024,
+      .usage = type == PoolType::ePerFrame
+                   ? vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer |
+                         vk::BufferUsageFlagBits::eIndirectBuffer
+                   : vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer |
+                         vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst |
+                         vk::BufferUsageFlagBits::eTransferSrc,
+  };
+  return vmaFindMemoryTypeIndexForBufferInfo(allocator, (VkBufferCreateInfo *)&bufferCreateInfo,
+                                             &allocationInfo, memoryTypeIndex);
+}
+} // namespace
+
+void MemoryPools::Init(vk::Device device, VmaAllocator allocator, MemoryTracker *memoryTracker,
+                       const std::array<PoolPolicy, POOL_TYPE_COUNT> &policies) {
+  _device = device;
+  _allocator = allocator;
+  _memoryTracker = memoryTracker;
+  _policies = policies;
+
+  for (uint32_t i = 0; i < POOL_TYPE_COUNT; i++) {
+    const PoolPolicy &policy = _policies[i];
+    VmaAllocationCreateInfo allocationInfo{
+        .usage = policy.usage,
+        .requiredFlags = policy.requiredFlags,
+    };
+    uint32_t memoryTypeIndex;
+    if (FindMemoryType(_allocator, static_cast<PoolType>(i), allocationInfo, &memoryTypeIndex) != VK_SUCCESS)
+      continue;
+
+    VmaPoolCreateInfo poolCreateInfo{
+        .memoryTypeIndex = memoryTypeIndex,
+        .flags = policy.flags,
+        .blockSize = policy.blockSize,
+        .minBlockCount = policy.minBlockCount,
+        .maxBlockCount = policy.maxBlockCount,
+        .frameInUseCount = 0,
+    };
+    // Without the pool, the allocations simply go in the default ones
+    if (vmaCreatePool(_allocator, &poolCreateInfo, &_pools[i]) != VK_SUCCESS) {
+      std::cerr << "[Memory] Unable to create memory pool " << i << '\n';
+      _pools[i] = nullptr;
+    }
+    _memoryTypeIndices[i] = memoryTypeIndex;
+  }
+}
+
+void MemoryPools::Destroy() {
+  for (auto &pool : _pools) {
+    if (pool) {
+      vmaDestroyPool(_allocator, pool);
+      pool = nullptr;
+    }
+  }
+}
+
+VmaPool MemoryPools::FindPool(MemoryCategory category, VmaMemoryUsage usage, bool image,
+                              uint32_t memoryTypeBits) const {
+  for (uint32_t i = 0; i < POOL_TYPE_COUNT; i++) {
+    const bool imagePool = static_cast<PoolType>(i) == PoolType::eTextures;
+    if (_policies[i].category == category && _policies[i].usage == usage && imagePool == image) {
+      // The pool is created from a representative resource, which may accept other memory types
+      return (memoryTypeBits & (1u << _memoryTypeIndices[i])) != 0 ? _pools[i] : nullptr;
+    }
+  }
+  return nullptr;
+}
+
+AllocatedBuffer MemoryPools::CreateBuffer(const vk::BufferCreateInfo &createInfo, VmaMemoryUsage usage,
+                                          MemoryCategory category, VmaAllocationCreateFlags flags) {
+  // Create the buffer first, to only use the pool if its memory type fits the buffer
+  AllocatedBuffer buffer;
+  buffer.buffer = _device.createBuffer(createInfo);
+  const vk::MemoryRequirements requirements = _device.getBufferMemoryRequirements(buffer.buffer);
+  VmaAllocationCreateInfo allocationInfo{
+      .flags = flags,
+      .usage = usage,
+      .pool = FindPool(category, usage, false, requirements.memoryTypeBits),
+  };
+
+  VkResult result = vmaAllocateMemoryForBuffer(_allocator, buffer.buffer, &allocationInfo, &buffer.allocation,
+                                               nullptr);
+  // The pool may be full
+  if (result != VK_SUCCESS && allocationInfo.pool) {
+    allocationInfo.pool = nullptr;
+    result = vmaAllocateMemoryForBuffer(_allocator, buffer.buffer, &allocationInfo, &buffer.allocation,
+                                        nullptr);
+  }
+  if (result == VK_SUCCESS) {
+    result = vmaBindBufferMemory(_allocator, buffer.allocation, buffer.buffer);
+  }
+  if (result != VK_SUCCESS) {
+    if (buffer.allocation) {
+      vmaFreeMemory(_allocator, buffer.allocation);
+    }
+    _device.destroyBuffer(buffer.buffer);
+    throw std::runtime_error("Unable to create a buffer");
+  }
+
+  if (_memoryTracker) {
+    _memoryTracker->Track(buffer.allocation, category);
+  }
+  return buffer;
+}
+
+AllocatedImage MemoryPools::CreateImage(const vk::ImageCreateInfo &createInfo, VmaMemoryUsage usage,
+                                        MemoryCategory category) {
+  // Create the image first, to only use the pool if its memory type fits the image. Compressed formats and
+  // large images may not accept the type of the representative image of the pool.
+  AllocatedImage image;
+  image.image = _device.createImage(createInfo);
+  const vk::MemoryRequirements requirements = _device.getImageMemoryRequirements(image.image);
+  VmaAllocationCreateInfo allocationInfo{
+      .usage = usage,
+      .pool = FindPool(category, usage, true, requirements.memoryTypeBits),
+  };
+
+  VkResult result = vmaAllocateMemoryForImage(_allocator, image.image, &allocationInfo, &image.allocation,
+                                              nullptr);
+  // The pool may be full
+  if (result != VK_SUCCESS && allocationInfo.pool) {
+    allocationInfo.pool = nullptr;
+    result = vmaAllocateMemoryForImage(_allocator, image.image, &allocationInfo, &image.allocation, nullptr);
+  }
+  if (result == VK_SUCCESS) {
+    result = vmaBindImageMemory(_allocator, image.allocation, image.image);
+  }
+  if (result != VK_SUCCESS) {
+    if (image.allocation) {
+      vmaFreeMemory(_allocator, image.allocation);
+    }
+    _device.destroyImage(image.image);
+    throw std::runtime_error("Unable to create an image");
+  }
+
+  if (_memoryTracker) {
+    _memoryTracker->Track(image.allocation, category);
+  }
+  return image;
+}
+
+VmaPool MemoryPools::GetPool(PoolType type) const { return _pools[static_cast<uint32_t>(type)]; }
+
+const PoolPolicy &MemoryPools::GetPolicy(PoolType type) const { return _policies[static_cast<uint32_t>(type)]; }
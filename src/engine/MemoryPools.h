@@ -0,0 +1,111 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include "MemoryTracker.h"
+#include "vk_types.h"
+#include <array>
+
+enum class PoolType : uint32_t {
+  /** Buffers written by the CPU every frame. Linear, since they are only freed at shutdown. */
+  ePerFrame,
+  /** Vertex, index and meshlet buffers, in device local memory */
+  eGeometry,
+  /** Textures, in device local memory */
+  eTextures,
+};
+constexpr uint32_t POOL_TYPE_COUNT = 3;
+
+/** How a pool is sized and placed */
+struct PoolPolicy {
+  /** Allocations with this category and this usage go in the pool */
+  MemoryCategory category;
+  VmaMemoryUsage usage;
+  /** Memory properties the pool must have, on top of the ones of the usage */
+  VkMemoryPropertyFlags requiredFlags;
+  vk::DeviceSize blockSize;
+  /** Blocks allocated up front, so that the first allocations don't allocate device memory */
+  size_t minBlockCount;
+  /** 0 for no limit */
+  size_t maxBlockCount;
+  VmaPoolCreateFlags flags;
+  /** Can the allocations of the pool be moved to compact it ? */
+  bool defragmentable;
+};
+
+constexpr std::array<PoolPolicy, POOL_TYPE_COUNT> DEFAULT_POOL_POLICIES = {
+    PoolPolicy{
+        .category = MemoryCategory::ePerFrame,
+        .usage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+        .requiredFlags = 0,
+        .blockSize = 32ull << 20,
+        .minBlockCount = 1,
+        .maxBlockCount = 1,
+        .flags = VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT,
+        .defragmentable = false,
+    },
+    PoolPolicy{
+        .category = MemoryCategory::eGeometry,
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+        .requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        .blockSize = 64ull << 20,
+        .minBlockCount = 1,
+        .maxBlockCount = 0,
+        .flags = 0,
+        .defragmentable = true,
+    },
+    PoolPolicy{
+        .category = MemoryCategory::eTextures,
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+        .requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        .blockSize = 128ull << 20,
+        .minBlockCount = 0,
+        .maxBlockCount = 0,
+        .flags = 0,
+        // VMA can't move images with an optimal tiling
+        .defragmentable = false,
+    },
+};
+
+/**
+ * Custom VMA pools, one per class of resources, so that resources with different lifetimes and sizes don't
+ * fragment each other's blocks.
+ *
+ * Allocations that don't match a pool, can't use its memory type or don't fit in it, use the default pools of
+ * VMA.
+ * Every allocation is tracked by the memory tracker, if there is one.
+ */
+class MemoryPools {
+private:
+  vk::Device _device = nullptr;
+  VmaAllocator _allocator = nullptr;
+  MemoryTracker *_memoryTracker = nullptr;
+  std::array<PoolPolicy, POOL_TYPE_COUNT> _policies = DEFAULT_POOL_POLICIES;
+  std::array<VmaPool, POOL_TYPE_COUNT> _pools = {};
+  std::array<uint32_t, POOL_TYPE_COUNT> _memoryTypeIndices = {};
+
+  /**
+   * Pool of the category, if its memory type is one of the given ones.
+   * VMA doesn't check the memory type of a pool against the requirements of the resource.
+   */
+  [[nodiscard]] VmaPool FindPool(MemoryCategory category, VmaMemoryUsage usage, bool image,
+                                 uint32_t memoryTypeBits) const;
+
+public:
+  void Init(vk::Device device, VmaAllocator allocator, MemoryTracker *memoryTracker,
+            const std::array<PoolPolicy, POOL_TYPE_COUNT> &policies = DEFAULT_POOL_POLICIES);
+  /** The allocations of the pools must have been freed */
+  void Destroy();
+
+  /** Creates a buffer in the pool of its category, or in the default pools. Throws if it fails. */
+  AllocatedBuffer CreateBuffer(const vk::BufferCreateInfo &createInfo, VmaMemoryUsage usage,
+                               MemoryCategory category, VmaAllocationCreateFlags flags = 0);
+  /** Creates an image in the pool of its category, or in the default pools. Throws if it fails. */
+  AllocatedImage CreateImage(const vk::ImageCreateInfo &createInfo, VmaMemoryUsage usage,
+                             MemoryCategory category);
+
+  [[nodiscard]] VmaPool GetPool(PoolType type) const;
+  [[nodiscard]] const PoolPolicy &GetPolicy(PoolType type) const;
+};
@@ -0,0 +1,143 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "MemoryTracker.h"
+#include <fstream>
+#include <sstream>
+
+namespace {
+void WriteCategories(std::ostringstream &json,
+                     const std::array<MemoryReport::Category, MEMORY_CATEGORY_COUNT> &categories,
+                     const char *indent) {
+  json << "{\n";
+  for (uint32_t c = 0; c < MEMORY_CATEGORY_COUNT; c++) {
+    json << indent << "  \"" << MemoryTracker::GetCategoryName(static_cast<MemoryCategory>(c))
+         << "\": {\"bytes\": " << categories[c].bytes << ", \"allocations\": " << categories[c].allocationCount
+         << "}" << (c + 1 < MEMORY_CATEGORY_COUNT ? ",\n" : "\n");
+  }
+  json << indent << "}";
+}
+} // namespace
+
+// ==== Report ====
+
+std::string MemoryReport::ToJson() const {
+  std::ostringstream json;
+  json << "{\n  \"budgetFromDriver\": " << (budgetFromDriver ? "true" : "false") << ",\n";
+  json << "  \"categories\": ";
+  WriteCategories(json, categories, "  ");
+  json << ",\n  \"heaps\": [\n";
+  for (uint32_t h = 0; h < heaps.size(); h++) {
+    const Heap &heap = heaps[h];
+    json << "    {\n"
+         << "      \"index\": " << h << ",\n"
+         << "      \"size\": " << heap.size << ",\n"
+         << "      \"deviceLocal\": " << (heap.deviceLocal ? "true" : "false") << ",\n"
+         << "      \"budget\": " << heap.budget << ",\n"
+         << "      \"usage\": " << heap.usage << ",\n"
+         << "      \"blockBytes\": " << heap.blockBytes << ",\n"
+         << "      \"allocationBytes\": " << heap.allocationBytes << ",\n"
+         << "      \"categories\": ";
+    WriteCategories(json, heap.categories, "      ");
+    json << "\n    }" << (h + 1 < heaps.size() ? ",\n" : "\n");
+  }
+  json << "  ]\n}\n";
+  return json.str();
+}
+
+// ==== Tracker ====
+
+void MemoryTracker::Init(VmaAllocator allocator, bool budgetFromDriver) {
+  _allocator = allocator;
+  _budgetFromDriver = budgetFromDriver;
+
+  const VkPhysicalDeviceMemoryProperties *memoryProperties;
+  vmaGetMemoryProperties(_allocator, &memoryProperties);
+  _heapUsage.resize(memoryProperties->memoryHeapCount);
+}
+
+void MemoryTracker::Track(VmaAllocation allocation, MemoryCategory category) {
+  if (!allocation)
+    return;
+
+  VmaAllocationInfo allocationInfo;
+  vmaGetAllocationInfo(_allocator, allocation, &allocationInfo);
+  const VkPhysicalDeviceMemoryProperties *memoryProperties;
+  vmaGetMemoryProperties(_allocator, &memoryProperties);
+
+  const TrackedAllocation tracked{
+      .category = category,
+      .size = allocationInfo.size,
+      .heapIndex = memoryProperties->memoryTypes[allocationInfo.memoryType].heapIndex,
+  };
+  _allocations[allocation] = tracked;
+  auto &usage = _heapUsage[tracked.heapIndex][static_cast<uint32_t>(category)];
+  usage.bytes += tracked.size;
+  usage.allocationCount++;
+}
+
+void MemoryTracker::Untrack(VmaAllocation allocation) {
+  auto tracked = _allocations.find(allocation);
+  if (tracked == _allocations.end())
+    return;
+
+  auto &usage = _heapUsage[tracked->second.heapIndex][static_cast<uint32_t>(tracked->second.category)];
+  usage.bytes -= tracked->second.size;
+  usage.allocationCount--;
+  _allocations.erase(tracked);
+}
+
+MemoryReport MemoryTracker::GetReport() const {
+  MemoryReport report;
+  report.budgetFromDriver = _budgetFromDriver;
+
+  const VkPhysicalDeviceMemoryProperties *memoryProperties;
+  vmaGetMemoryProperties(_allocator, &memoryProperties);
+  VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+  vmaGetBudget(_allocator, budgets);
+
+  report.heaps.resize(memoryProperties->memoryHeapCount);
+  for (uint32_t h = 0; h < memoryProperties->memoryHeapCount; h++) {
+    MemoryReport::Heap &heap = report.heaps[h];
+    heap.size = memoryProperties->memoryHeaps[h].size;
+    heap.deviceLocal = memoryProperties->memoryHeaps[h].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+    heap.budget = budgets[h].budget;
+    heap.usage = budgets[h].usage;
+    heap.blockBytes = budgets[h].blockBytes;
+    heap.allocationBytes = budgets[h].allocationBytes;
+    heap.categories = _heapUsage[h];
+
+    for (uint32_t c = 0; c < MEMORY_CATEGORY_COUNT; c++) {
+      report.categories[c].bytes += heap.categories[c].bytes;
+      report.categories[c].allocationCount += heap.categories[c].allocationCount;
+    }
+  }
+  return report;
+}
+
+bool MemoryTracker::DumpJson(const std::string &path) const {
+  std::ofstream file(path);
+  if (!file.is_open())
+    return false;
+  file << GetReport().ToJson();
+  return file.good();
+}
+
+size_t MemoryTracker::GetAllocationCount() const { return _allocations.size(); }
+
+const char *MemoryTracker::GetCategoryName(MemoryCategory category) {
+  switch (category) {
+  case MemoryCategory::eGeometry:
+    return "geometry";
+  case MemoryCategory::eTextures:
+    return "textures";
+  case MemoryCategory::ePerFrame:
+    return "perFrame";
+  case MemoryCategory::eStaging:
+    return "staging";
+  case MemoryCategory::eAttachments:
+    return "attachments";
+  }
+  return "unknown";
+}
@@ -0,0 +1,87 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include "vk_types.h"
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** What an allocation is used for */
+enum class MemoryCategory : uint32_t {
+  /** Vertices, indices and meshlets */
+  eGeometry,
+  /** Textures and the parameters of the materials */
+  eTextures,
+  /** Buffers written or read every frame, like the objects, the camera or the culling data */
+  ePerFrame,
+  /** Temporary buffers used to upload data to the GPU */
+  eStaging,
+  /** Render targets, like the depth image or the depth pyramid */
+  eAttachments,
+};
+constexpr uint32_t MEMORY_CATEGORY_COUNT = 5;
+
+/** Snapshot of the memory usage */
+struct MemoryReport {
+  struct Category {
+    vk::DeviceSize bytes = 0;
+    uint32_t allocationCount = 0;
+  };
+
+  struct Heap {
+    vk::DeviceSize size = 0;
+    bool deviceLocal = false;
+    /** Memory available to the application, estimated by the driver if VK_EXT_memory_budget is enabled */
+    vk::DeviceSize budget = 0;
+    /** Memory used by the application, including what wasn't allocated by VMA */
+    vk::DeviceSize usage = 0;
+    /** Memory blocks allocated by VMA, and the part of them that is used by allocations */
+    vk::DeviceSize blockBytes = 0;
+    vk::DeviceSize allocationBytes = 0;
+    std::array<Category, MEMORY_CATEGORY_COUNT> categories;
+  };
+
+  std::array<Category, MEMORY_CATEGORY_COUNT> categories;
+  std::vector<Heap> heaps;
+  /** Is the budget given by the driver, or only an estimation of VMA ? */
+  bool budgetFromDriver = false;
+
+  [[nodiscard]] std::string ToJson() const;
+};
+
+/**
+ * Accounts the VMA allocations per category and per heap. Allocations are tracked when they are created,
+ * and untracked before they are destroyed: the ones still tracked at shutdown are leaks.
+ */
+class MemoryTracker {
+private:
+  struct TrackedAllocation {
+    MemoryCategory category;
+    vk::DeviceSize size;
+    uint32_t heapIndex;
+  };
+
+  VmaAllocator _allocator = nullptr;
+  bool _budgetFromDriver = false;
+  std::unordered_map<VmaAllocation, TrackedAllocation> _allocations;
+  /** Usage of each category in each heap */
+  std::vector<std::array<MemoryReport::Category, MEMORY_CATEGORY_COUNT>> _heapUsage;
+
+public:
+  /** @param budgetFromDriver was the allocator created with VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT ? */
+  void Init(VmaAllocator allocator, bool budgetFromDriver);
+
+  void Track(VmaAllocation allocation, MemoryCategory category);
+  void Untrack(VmaAllocation allocation);
+
+  [[nodiscard]] MemoryReport GetReport() const;
+  /** Writes the report in a JSON file. Returns false if the file can't be written. */
+  bool DumpJson(const std::string &path) const;
+  [[nodiscard]] size_t GetAllocationCount() const;
+
+  [[nodiscard]] static const char *GetCategoryName(MemoryCategory category);
+};
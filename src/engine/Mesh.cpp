@@ -3,43 +3,53 @@
 //
 
 #include "Mesh.h"
+#include "MeshProcessing.h"
 #include "vk_engine.h"
+#include <algorithm>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
 #include <iostream>
+#include <numeric>
 #include <tiny_obj_loader.h>
+#include <unordered_map>
 
-Mesh::Mesh(std::vector<Vertex> &vertices) { _vertices = vertices; }
+namespace {
+/** Floats after the position of a vertex: normal, color and UV. Seams are kept in the LODs with them. */
+constexpr size_t VERTEX_ATTRIBUTE_COUNT = 8;
+static_assert(sizeof(Vertex) == sizeof(float) * (3 + VERTEX_ATTRIBUTE_COUNT));
 
-void Mesh::Upload(VmaAllocator allocator, DeletionQueue &deletionQueue) {
-  // Create the allocation
-  vk::BufferCreateInfo bufferCreateInfo{
-      .size = _vertices.size() * sizeof(Vertex),
-      .usage = vk::BufferUsageFlagBits::eVertexBuffer,
-  };
-
-  VmaAllocationCreateInfo allocationCreateInfo{
-      .usage = VMA_MEMORY_USAGE_CPU_TO_GPU,
-  };
+// Vertices are compared bit by bit to merge the duplicates of OBJ files
+struct VertexHasher {
+  size_t operator()(const Vertex &vertex) const {
+    // FNV-1a
+    const auto *bytes = reinterpret_cast<const uint8_t *>(&vertex);
+    size_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < sizeof(Vertex); i++) {
+      hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+  }
+};
+struct VertexEqual {
+  bool operator()(const Vertex &a, const Vertex &b) const { return memcmp(&a, &b, sizeof(Vertex)) == 0; }
+};
+} // namespace
 
-  auto result = vmaCreateBuffer(
-      allocator, (VkBufferCreateInfo *)&bufferCreateInfo, &allocationCreateInfo,
-      (VkBuffer *)&_vertexBuffer.buffer, &_vertexBuffer.allocation, nullptr);
-  if (result != 0)
-    throw std::runtime_error("Unable to create allocation for vertex buffer");
-
-  // Register the deletion
-  deletionQueue.PushFunction([this, allocator]() {
-    vmaDestroyBuffer(allocator, _vertexBuffer.buffer, _vertexBuffer.allocation);
-  });
-
-  // Copy vertex data
-  void *data = nullptr;
-  vmaMapMemory(allocator, _vertexBuffer.allocation, &data);
-  memcpy(data, _vertices.data(), _vertices.size() * sizeof(Vertex));
-  vmaUnmapMemory(allocator, _vertexBuffer.allocation);
+Mesh::Mesh(std::vector<Vertex> &vertices) {
+  _vertices = vertices;
+  // Each vertex is used once
+  _indices.resize(_vertices.size());
+  std::iota(_indices.begin(), _indices.end(), 0u);
+  _lods = {{.firstIndex = 0, .indexCount = static_cast<uint32_t>(_indices.size()), .error = 0}};
+  ComputeBounds();
 }
+
 vk::Buffer &Mesh::GetVertexBuffer() { return _vertexBuffer.buffer; }
+vk::Buffer &Mesh::GetIndexBuffer() { return _indexBuffer.buffer; }
+vk::Buffer &Mesh::GetMeshletBuffer() { return _meshletBuffer.buffer; }
 
 size_t Mesh::GetVertexCount() const { return _vertices.size(); }
+size_t Mesh::GetIndexCount() const { return _indices.size(); }
 
 bool Mesh::LoadFromObj(const char *filename) {
   // Attrib will contain the vertex arrays
@@ -73,6 +83,9 @@ bool Mesh::LoadFromObj(const char *filename) {
   // Hardcode the loading of triangles
   constexpr int32_t VERTEX_PER_FACE = 3;
 
+  // OBJ files index each attribute separately: vertices with the same attributes are merged
+  std::unordered_map<Vertex, uint32_t, VertexHasher, VertexEqual> uniqueVertices;
+
   // For each shape (separate object in the file)
   for (auto & shape : shapes) {
     size_t indexOffset = 0;
@@ -92,25 +105,129 @@ bool Mesh::LoadFromObj(const char *filename) {
         tinyobj::real_t nx = attrib.normals[3 * idx.normal_index + 0];
         tinyobj::real_t ny = attrib.normals[3 * idx.normal_index + 1];
         tinyobj::real_t nz = attrib.normals[3 * idx.normal_index + 2];
+        // vertex uv, if the file has some
+        tinyobj::real_t ux = 0;
+        tinyobj::real_t uy = 0;
+        if (idx.texcoord_index >= 0) {
+          ux = attrib.texcoords[2 * idx.texcoord_index + 0];
+          uy = attrib.texcoords[2 * idx.texcoord_index + 1];
+        }
 
         // Position
         Vertex newVertex{
             .position{vx, vy, vz},
             .normal{nx, ny, nz},
             .color{nx, ny, nz},
+            // Vulkan has the origin of textures at the top
+            .uv{ux, 1 - uy},
         };
 
-        _vertices.push_back(newVertex);
+        auto [it, inserted] = uniqueVertices.try_emplace(newVertex, static_cast<uint32_t>(_vertices.size()));
+        if (inserted) {
+          _vertices.push_back(newVertex);
+        }
+        _indices.push_back(it->second);
       }
 
       indexOffset += VERTEX_PER_FACE;
     }
   }
 
+  // Full resolution level
+  _lods = {{.firstIndex = 0, .indexCount = static_cast<uint32_t>(_indices.size()), .error = 0}};
+  ComputeBounds();
+
   return true;
 }
-std::vector<Vertex> Mesh::GetVertices() const { return _vertices; }
+
+void Mesh::ComputeBounds() {
+  if (_vertices.empty())
+    return;
+
+  // Center of the bounding box, and the farthest vertex from it
+  glm::vec3 min = _vertices[0].position;
+  glm::vec3 max = _vertices[0].position;
+  for (const auto &vertex : _vertices) {
+    min = glm::min(min, vertex.position);
+    max = glm::max(max, vertex.position);
+  }
+  _bounds.center = (min + max) * 0.5f;
+  _bounds.radius = 0;
+  for (const auto &vertex : _vertices) {
+    _bounds.radius = std::max(_bounds.radius, glm::distance(_bounds.center, vertex.position));
+  }
+}
+
+void Mesh::GenerateLods() {
+  if (_lods.empty() || _bounds.radius <= 0)
+    return;
+
+  // Each level is simplified from the full resolution mesh, to avoid accumulating errors
+  const std::vector<uint32_t> fullIndices(_indices.begin(), _indices.begin() + _lods[0].indexCount);
+  size_t targetIndexCount = fullIndices.size();
+
+  while (_lods.size() < MAX_LOD_COUNT) {
+    targetIndexCount /= 2;
+    if (targetIndexCount < MIN_LOD_TRIANGLE_COUNT * 3)
+      break;
+
+    float error = 0;
+    auto lodIndices =
+        meshutils::Simplify(fullIndices, &_vertices[0].position.x, _vertices.size(), sizeof(Vertex),
+                            targetIndexCount, &error, &_vertices[0].normal.x, VERTEX_ATTRIBUTE_COUNT);
+
+    // Stop if the mesh can't be simplified much more
+    if (lodIndices.empty() || lodIndices.size() > _lods.back().indexCount * 3 / 4)
+      break;
+
+    _lods.push_back({
+        .firstIndex = static_cast<uint32_t>(_indices.size()),
+        .indexCount = static_cast<uint32_t>(lodIndices.size()),
+        .error = error / _bounds.radius,
+    });
+    _indices.insert(_indices.end(), lodIndices.begin(), lodIndices.end());
+  }
+}
+
+void Mesh::GenerateMeshlets() {
+  if (_lods.empty())
+    return;
+
+  // The full resolution level is reordered so that each meshlet is a contiguous range of it
+  std::vector<uint32_t> fullIndices(_indices.begin(), _indices.begin() + _lods[0].indexCount);
+  _meshlets =
+      meshutils::BuildMeshlets(fullIndices, &_vertices[0].position.x, _vertices.size(), sizeof(Vertex));
+  std::copy(fullIndices.begin(), fullIndices.end(), _indices.begin());
+}
+
+uint32_t Mesh::SelectLod(float screenRadius, uint32_t currentLod) const {
+  // Coarsest levels that can be used, with and without hysteresis
+  uint32_t coarsestLod = 0;
+  uint32_t coarsestStableLod = 0;
+  for (uint32_t i = 1; i < _lods.size(); i++) {
+    float projectedError = _lods[i].error * screenRadius;
+    if (projectedError <= LOD_ERROR_THRESHOLD)
+      coarsestLod = i;
+    if (projectedError <= LOD_ERROR_THRESHOLD * LOD_HYSTERESIS)
+      coarsestStableLod = i;
+  }
+
+  // The current level is too coarse: refine right away
+  if (currentLod > coarsestLod)
+    return coarsestLod;
+  // Otherwise, only go coarser once the error is well below the threshold
+  return std::max(currentLod, coarsestStableLod);
+}
+
+const std::vector<Vertex> &Mesh::GetVertices() const { return _vertices; }
+const std::vector<uint32_t> &Mesh::GetIndices() const { return _indices; }
+const MeshLod &Mesh::GetLod(uint32_t lod) const { return _lods[lod]; }
+uint32_t Mesh::GetLodCount() const { return static_cast<uint32_t>(_lods.size()); }
+const BoundingSphere &Mesh::GetBounds() const { return _bounds; }
+const std::vector<meshutils::Meshlet> &Mesh::GetMeshlets() const { return _meshlets; }
 VmaAllocation &Mesh::GetAllocation() { return _vertexBuffer.allocation; }
+VmaAllocation &Mesh::GetIndexAllocation() { return _indexBuffer.allocation; }
+VmaAllocation &Mesh::GetMeshletAllocation() { return _meshletBuffer.allocation; }
 
 VertexInputDescription Vertex::GetVertexDescription() {
 
@@ -148,6 +265,14 @@ VertexInputDescription Vertex::GetVertexDescription() {
       .offset = static_cast<uint32_t>(offsetof(Vertex, color)),
   };
   description.attributes.push_back(colorAttribute);
+  // Vertex uv attribute: location 3
+  vk::VertexInputAttributeDescription uvAttribute{
+      .location = 3,
+      .binding = 0,
+      .format = vk::Format::eR32G32Sfloat,
+      .offset = static_cast<uint32_t>(offsetof(Vertex, uv)),
+  };
+  description.attributes.push_back(uvAttribute);
 
   // Create the final struct
   return description;
@@ -4,8 +4,10 @@
 
 #pragma once
 
+#include "MeshProcessing.h"
 #include "vk_types.h"
 #include <vector>
+#include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 
 struct VertexInputDescription {
@@ -19,21 +21,83 @@ struct Vertex {
   glm::vec3 position;
   glm::vec3 normal;
   glm::vec3 color;
+  glm::vec2 uv;
 
   static VertexInputDescription GetVertexDescription();
 };
 
+/** Maximum number of levels of detail of a mesh, including the full resolution one */
+constexpr uint32_t MAX_LOD_COUNT = 6;
+/** Levels with less triangles than this are not generated */
+constexpr uint32_t MIN_LOD_TRIANGLE_COUNT = 16;
+/** A level is chosen if its simplification error, projected on the screen, is below this many pixels */
+constexpr float LOD_ERROR_THRESHOLD = 1.0f;
+/**
+ * A coarser level is only chosen if its projected error is below this fraction of the threshold.
+ * Prevents objects near a switch distance from changing level every frame.
+ */
+constexpr float LOD_HYSTERESIS = 0.75f;
+
+/** Range of the index buffer used by a level of detail */
+struct MeshLod {
+  uint32_t firstIndex;
+  uint32_t indexCount;
+  /** Largest distance between this level and the full resolution mesh, relative to the bounding radius */
+  float error;
+};
+
+struct BoundingSphere {
+  glm::vec3 center;
+  float radius;
+};
+
 class Mesh {
 private:
   std::vector<Vertex> _vertices;
+  /** Indices of every level of detail, one after the other */
+  std::vector<uint32_t> _indices;
+  /** Levels of detail, from the most detailed to the coarsest */
+  std::vector<MeshLod> _lods;
+  /** Clusters of the full resolution level, which is ordered meshlet by meshlet */
+  std::vector<meshutils::Meshlet> _meshlets;
+  BoundingSphere _bounds{};
   AllocatedBuffer _vertexBuffer;
+  AllocatedBuffer _indexBuffer;
+  AllocatedBuffer _meshletBuffer;
+
+  void ComputeBounds();
 public:
   Mesh() = default;
   explicit Mesh(std::vector<Vertex>& vertices);
-  [[nodiscard]] std::vector<Vertex> GetVertices() const;
+  [[nodiscard]] const std::vector<Vertex> &GetVertices() const;
+  [[nodiscard]] const std::vector<uint32_t> &GetIndices() const;
   bool LoadFromObj(const char* filename);
+  /**
+   * Simplifies the mesh to create its levels of detail. They share the vertices of the full resolution mesh,
+   * only new indices are added. Must be called before the upload.
+   */
+  void GenerateLods();
+  /**
+   * Splits the full resolution level in meshlets, which can be culled individually on the GPU.
+   * Must be called before the upload.
+   */
+  void GenerateMeshlets();
+  /**
+   * Chooses the level of detail to use this frame.
+   * @param screenRadius radius of the bounding sphere of the object, projected on the screen, in pixels
+   * @param currentLod level used by the object in the previous frame
+   */
+  [[nodiscard]] uint32_t SelectLod(float screenRadius, uint32_t currentLod) const;
+  [[nodiscard]] const MeshLod &GetLod(uint32_t lod) const;
+  [[nodiscard]] uint32_t GetLodCount() const;
+  [[nodiscard]] const BoundingSphere &GetBounds() const;
+  [[nodiscard]] const std::vector<meshutils::Meshlet> &GetMeshlets() const;
   [[nodiscard]] vk::Buffer &GetVertexBuffer();
+  [[nodiscard]] vk::Buffer &GetIndexBuffer();
+  [[nodiscard]] vk::Buffer &GetMeshletBuffer();
   [[nodiscard]] size_t GetVertexCount() const;
+  [[nodiscard]] size_t GetIndexCount() const;
   [[nodiscard]] VmaAllocation &GetAllocation();
-  void Upload(VmaAllocator allocator, class DeletionQueue& deletionQueue);
+  [[nodiscard]] VmaAllocation &GetIndexAllocation();
+  [[nodiscard]] VmaAllocation &GetMeshletAllocation();
 };
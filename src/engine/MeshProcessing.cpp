@@ -0,0 +1,541 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "MeshProcessing.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+// ==== Small vector helpers, to keep this file independent from the renderer ====
+
+struct Vec3 {
+  double x, y, z;
+};
+
+Vec3 Sub(const Vec3 &a, const Vec3 &b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+Vec3 Cross(const Vec3 &a, const Vec3 &b) {
+  return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+double Dot(const Vec3 &a, const Vec3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+double Length(const Vec3 &a) { return std::sqrt(Dot(a, a)); }
+
+/** Weight of the planes keeping the borders of open meshes in place */
+constexpr double BORDER_WEIGHT = 10.0;
+/** Fraction of the edges (1 / PASS_FRACTION) that can be collapsed in a single pass */
+constexpr size_t PASS_FRACTION = 6;
+/** Minimum cosine between the normal of a triangle and the average normal of the meshlet it joins */
+constexpr double MESHLET_MIN_ALIGNMENT = 0.7;
+
+/**
+ * Symmetric 4x4 matrix accumulating squared distances to planes, plus the total weight of these planes
+ */
+struct Quadric {
+  double xx = 0, xy = 0, xz = 0, xw = 0, yy = 0, yz = 0, yw = 0, zz = 0, zw = 0, ww = 0;
+  double weight = 0;
+
+  void AddPlane(const Vec3 &normal, double d, double planeWeight) {
+    xx += planeWeight * normal.x * normal.x;
+    xy += planeWeight * normal.x * normal.y;
+    xz += planeWeight * normal.x * normal.z;
+    xw += planeWeight * normal.x * d;
+    yy += planeWeight * normal.y * normal.y;
+    yz += planeWeight * normal.y * normal.z;
+    yw += planeWeight * normal.y * d;
+    zz += planeWeight * normal.z * normal.z;
+    zw += planeWeight * normal.z * d;
+    ww += planeWeight * d * d;
+    weight += planeWeight;
+  }
+
+  void Add(const Quadric &other) {
+    xx += other.xx;
+    xy += other.xy;
+    xz += other.xz;
+    xw += other.xw;
+    yy += other.yy;
+    yz += other.yz;
+    yw += other.yw;
+    zz += other.zz;
+    zw += other.zw;
+    ww += other.ww;
+    weight += other.weight;
+  }
+
+  /** Weighted sum of squared distances from p to the planes */
+  [[nodiscard]] double Evaluate(const Vec3 &p) const {
+    double result = xx * p.x * p.x + yy * p.y * p.y + zz * p.z * p.z + ww;
+    result += 2 * (xy * p.x * p.y + xz * p.x * p.z + yz * p.y * p.z);
+    result += 2 * (xw * p.x + yw * p.y + zw * p.z);
+    return std::max(result, 0.0);
+  }
+};
+
+struct Collapse {
+  uint32_t from;
+  uint32_t to;
+  double cost;
+};
+
+uint64_t EdgeKey(uint32_t a, uint32_t b) {
+  if (a > b)
+    std::swap(a, b);
+  return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+/**
+ * Finds the vertices sharing their position with another one.
+ * @return for each vertex, the index of the first vertex with the same position
+ */
+std::vector<uint32_t> WeldPositions(const float *positions, size_t vertexCount, size_t vertexStride,
+                                    std::vector<Vec3> &outPositions) {
+  struct PositionKey {
+    uint32_t bits[3];
+    bool operator==(const PositionKey &other) const { return memcmp(bits, other.bits, sizeof(bits)) == 0; }
+  };
+  struct PositionHasher {
+    size_t operator()(const PositionKey &key) const {
+      return (key.bits[0] * 73856093u) ^ (key.bits[1] * 19349663u) ^ (key.bits[2] * 83492791u);
+    }
+  };
+  std::unordered_map<PositionKey, uint32_t, PositionHasher> firstVertexWithPosition;
+  firstVertexWithPosition.reserve(vertexCount);
+
+  std::vector<uint32_t> remap(vertexCount);
+  outPositions.resize(vertexCount);
+  const auto *bytes = reinterpret_cast<const uint8_t *>(positions);
+  for (uint32_t i = 0; i < vertexCount; i++) {
+    float position[3];
+    memcpy(position, bytes + i * vertexStride, sizeof(position));
+    outPositions[i] = {position[0], position[1], position[2]};
+
+    PositionKey key{};
+    memcpy(key.bits, position, sizeof(position));
+    remap[i] = firstVertexWithPosition.emplace(key, i).first->second;
+  }
+  return remap;
+}
+
+/**
+ * Would moving "from" to the position of "to" flip one of the triangles around "from" ?
+ */
+bool CollapseFlipsTriangle(const std::vector<uint32_t> &triangles,
+                           const std::vector<uint32_t> &adjacencyOffsets, const std::vector<uint32_t> &adjacency,
+                           const std::vector<Vec3> &positions, uint32_t from, uint32_t to) {
+  for (uint32_t a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1]; a++) {
+    const uint32_t *triangle = &triangles[adjacency[a] * 3];
+
+    // Triangles with both vertices disappear
+    if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+      continue;
+
+    Vec3 before[3], after[3];
+    for (uint32_t v = 0; v < 3; v++) {
+      before[v] = positions[triangle[v]];
+      after[v] = triangle[v] == from ? positions[to] : before[v];
+    }
+    Vec3 normalBefore = Cross(Sub(before[1], before[0]), Sub(before[2], before[0]));
+    Vec3 normalAfter = Cross(Sub(after[1], after[0]), Sub(after[2], after[0]));
+    if (Dot(normalBefore, normalAfter) <= 0)
+      return true;
+  }
+  return false;
+}
+} // namespace
+
+std::vector<uint32_t> meshutils::Simplify(const std::vector<uint32_t> &indices, const float *positions,
+                                          size_t vertexCount, size_t vertexStride, size_t targetIndexCount,
+                                          float *outError, const float *attributes, size_t attributeCount) {
+  // Weld vertices sharing a position: the topology is computed on the welded mesh
+  std::vector<Vec3> weldedPositions;
+  std::vector<uint32_t> remap = WeldPositions(positions, vertexCount, vertexStride, weldedPositions);
+
+  // Original vertices of each welded vertex, to find the one to use on each side of the UV and normal seams
+  std::vector<uint32_t> weldedOffsets(vertexCount + 1, 0);
+  for (uint32_t welded : remap) {
+    weldedOffsets[welded + 1]++;
+  }
+  for (size_t v = 0; v < vertexCount; v++) {
+    weldedOffsets[v + 1] += weldedOffsets[v];
+  }
+  std::vector<uint32_t> weldedVertices(vertexCount);
+  {
+    std::vector<uint32_t> fill(weldedOffsets.begin(), weldedOffsets.end() - 1);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+      weldedVertices[fill[remap[v]]++] = v;
+    }
+  }
+  const auto *attributeBytes = reinterpret_cast<const uint8_t *>(attributes);
+  auto attributeDistance = [&](uint32_t a, uint32_t b) {
+    const auto *attributesA = reinterpret_cast<const float *>(attributeBytes + a * vertexStride);
+    const auto *attributesB = reinterpret_cast<const float *>(attributeBytes + b * vertexStride);
+    float distance = 0;
+    for (size_t i = 0; i < attributeCount; i++) {
+      distance += (attributesA[i] - attributesB[i]) * (attributesA[i] - attributesB[i]);
+    }
+    return distance;
+  };
+  // Original vertex at the position of a welded vertex whose attributes are the closest to the source one
+  auto findMatchingVertex = [&](uint32_t welded, uint32_t source) {
+    uint32_t best = weldedVertices[weldedOffsets[welded]];
+    if (attributes == nullptr)
+      return best;
+    float bestDistance = attributeDistance(best, source);
+    for (uint32_t i = weldedOffsets[welded] + 1; i < weldedOffsets[welded + 1]; i++) {
+      const float distance = attributeDistance(weldedVertices[i], source);
+      if (distance < bestDistance) {
+        best = weldedVertices[i];
+        bestDistance = distance;
+      }
+    }
+    return best;
+  };
+
+  // Triangles of the welded mesh, without the degenerate ones.
+  // Each corner also keeps the original vertex it is drawn with.
+  std::vector<uint32_t> triangles;
+  std::vector<uint32_t> corners;
+  triangles.reserve(indices.size());
+  corners.reserve(indices.size());
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    uint32_t a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+    if (a != b && b != c && a != c) {
+      triangles.insert(triangles.end(), {a, b, c});
+      corners.insert(corners.end(), {indices[i], indices[i + 1], indices[i + 2]});
+    }
+  }
+
+  // Quadric of each vertex: planes of the triangles around it, weighted by their area
+  std::vector<Quadric> quadrics(vertexCount);
+  std::unordered_map<uint64_t, uint32_t> edgeUseCount;
+  for (size_t t = 0; t < triangles.size(); t += 3) {
+    const Vec3 &p0 = weldedPositions[triangles[t]];
+    const Vec3 &p1 = weldedPositions[triangles[t + 1]];
+    const Vec3 &p2 = weldedPositions[triangles[t + 2]];
+    Vec3 normal = Cross(Sub(p1, p0), Sub(p2, p0));
+    double doubleArea = Length(normal);
+    if (doubleArea > 0) {
+      normal = {normal.x / doubleArea, normal.y / doubleArea, normal.z / doubleArea};
+      for (uint32_t v = 0; v < 3; v++) {
+        quadrics[triangles[t + v]].AddPlane(normal, -Dot(normal, p0), doubleArea * 0.5);
+      }
+    }
+    for (uint32_t e = 0; e < 3; e++) {
+      edgeUseCount[EdgeKey(triangles[t + e], triangles[t + (e + 1) % 3])]++;
+    }
+  }
+
+  // Border edges get a plane perpendicular to their triangle, so that the outline of the mesh is preserved
+  for (size_t t = 0; t < triangles.size(); t += 3) {
+    const Vec3 &p0 = weldedPositions[triangles[t]];
+    const Vec3 &p1 = weldedPositions[triangles[t + 1]];
+    const Vec3 &p2 = weldedPositions[triangles[t + 2]];
+    Vec3 normal = Cross(Sub(p1, p0), Sub(p2, p0));
+
+    for (uint32_t e = 0; e < 3; e++) {
+      uint32_t a = triangles[t + e];
+      uint32_t b = triangles[t + (e + 1) % 3];
+      if (edgeUseCount[EdgeKey(a, b)] != 1)
+        continue;
+
+      Vec3 edge = Sub(weldedPositions[b], weldedPositions[a]);
+      Vec3 borderNormal = Cross(edge, normal);
+      double length = Length(borderNormal);
+      if (length <= 0)
+        continue;
+      borderNormal = {borderNormal.x / length, borderNormal.y / length, borderNormal.z / length};
+      double d = -Dot(borderNormal, weldedPositions[a]);
+      double weight = BORDER_WEIGHT * Dot(edge, edge);
+      quadrics[a].AddPlane(borderNormal, d, weight);
+      quadrics[b].AddPlane(borderNormal, d, weight);
+    }
+  }
+
+  // Collapse edges by passes, cheapest first, until the target is reached
+  double maxError = 0;
+  std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+  std::vector<uint32_t> adjacency;
+  std::vector<Collapse> collapses;
+  std::vector<uint32_t> collapseTarget(vertexCount);
+  std::vector<bool> locked(vertexCount);
+
+  while (triangles.size() > targetIndexCount) {
+    // Triangles around each vertex
+    std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+    for (uint32_t index : triangles) {
+      adjacencyOffsets[index + 1]++;
+    }
+    for (size_t v = 0; v < vertexCount; v++) {
+      adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+    }
+    adjacency.resize(triangles.size());
+    {
+      std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+      for (size_t i = 0; i < triangles.size(); i++) {
+        adjacency[fill[triangles[i]]++] = static_cast<uint32_t>(i / 3);
+      }
+    }
+
+    // Cost of every edge, in its cheapest direction
+    collapses.clear();
+    for (size_t t = 0; t < triangles.size(); t += 3) {
+      for (uint32_t e = 0; e < 3; e++) {
+        uint32_t a = triangles[t + e];
+        uint32_t b = triangles[t + (e + 1) % 3];
+        // Each edge is seen from both of its triangles: only keep one
+        if (a > b && edgeUseCount[EdgeKey(a, b)] > 1)
+          continue;
+
+        Quadric merged = quadrics[a];
+        merged.Add(quadrics[b]);
+        double costToB = merged.Evaluate(weldedPositions[b]);
+        double costToA = merged.Evaluate(weldedPositions[a]);
+        double normalization = merged.weight > 0 ? merged.weight : 1;
+        if (costToB <= costToA) {
+          collapses.push_back({a, b, costToB / normalization});
+        } else {
+          collapses.push_back({b, a, costToA / normalization});
+        }
+      }
+    }
+    std::sort(collapses.begin(), collapses.end(),
+              [](const Collapse &x, const Collapse &y) { return x.cost < y.cost; });
+
+    // Each collapse removes about 2 triangles
+    const size_t triangleCount = triangles.size() / 3;
+    const size_t targetTriangleCount = targetIndexCount / 3;
+    const size_t collapseBudget = (triangleCount - targetTriangleCount) / 2 + 1;
+
+    // Apply the cheapest ones. A collapse locks the vertices around it, so that the flip test of the other
+    // collapses of this pass stays valid. Only the cheapest part of the list is considered in a pass: the
+    // locked vertices would otherwise push it to collapse costly edges before cheaper ones become available.
+    const double passErrorLimit = collapses[std::min(collapseBudget, collapses.size() / PASS_FRACTION)].cost;
+    std::iota(collapseTarget.begin(), collapseTarget.end(), 0u);
+    std::fill(locked.begin(), locked.end(), false);
+    size_t collapseCount = 0;
+    for (const Collapse &collapse : collapses) {
+      if (collapseCount >= collapseBudget || (collapse.cost > passErrorLimit && collapseCount > 0))
+        break;
+      if (locked[collapse.from] || locked[collapse.to])
+        continue;
+      if (CollapseFlipsTriangle(triangles, adjacencyOffsets, adjacency, weldedPositions, collapse.from,
+                                collapse.to))
+        continue;
+
+      collapseTarget[collapse.from] = collapse.to;
+      quadrics[collapse.to].Add(quadrics[collapse.from]);
+      for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1]; a++) {
+        for (uint32_t v = 0; v < 3; v++) {
+          locked[triangles[adjacency[a] * 3 + v]] = true;
+        }
+      }
+      maxError = std::max(maxError, collapse.cost);
+      collapseCount++;
+    }
+
+    // Nothing can be collapsed anymore
+    if (collapseCount == 0)
+      break;
+
+    // Update the triangles and drop the ones that became degenerate
+    size_t writeIndex = 0;
+    for (size_t t = 0; t < triangles.size(); t += 3) {
+      uint32_t a = collapseTarget[triangles[t]];
+      uint32_t b = collapseTarget[triangles[t + 1]];
+      uint32_t c = collapseTarget[triangles[t + 2]];
+      if (a != b && b != c && a != c) {
+        // Moved corners use the vertex of the new position matching the attributes of their previous one
+        for (uint32_t v = 0; v < 3; v++) {
+          const uint32_t welded = collapseTarget[triangles[t + v]];
+          const uint32_t corner = corners[t + v];
+          corners[writeIndex] = welded == triangles[t + v] ? corner : findMatchingVertex(welded, corner);
+          triangles[writeIndex++] = welded;
+        }
+      }
+    }
+    triangles.resize(writeIndex);
+    corners.resize(writeIndex);
+
+    // Border information of the new edges
+    edgeUseCount.clear();
+    for (size_t t = 0; t < triangles.size(); t += 3) {
+      for (uint32_t e = 0; e < 3; e++) {
+        edgeUseCount[EdgeKey(triangles[t + e], triangles[t + (e + 1) % 3])]++;
+      }
+    }
+  }
+
+  if (outError != nullptr) {
+    *outError = static_cast<float>(std::sqrt(maxError));
+  }
+  return corners;
+}
+
+std::vector<meshutils::Meshlet> meshutils::BuildMeshlets(std::vector<uint32_t> &indices,
+                                                         const float *positions, size_t vertexCount,
+                                                         size_t vertexStride) {
+  std::vector<Vec3> weldedPositions;
+  std::vector<uint32_t> remap = WeldPositions(positions, vertexCount, vertexStride, weldedPositions);
+  const size_t triangleCount = indices.size() / 3;
+
+  // Area weighted normal of each triangle
+  std::vector<Vec3> normals(triangleCount);
+  for (size_t t = 0; t < triangleCount; t++) {
+    const Vec3 &p0 = weldedPositions[indices[t * 3]];
+    normals[t] =
+        Cross(Sub(weldedPositions[indices[t * 3 + 1]], p0), Sub(weldedPositions[indices[t * 3 + 2]], p0));
+  }
+
+  // Triangles around each welded vertex, to grow the meshlets across UV and normal seams
+  std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+  for (size_t i = 0; i < triangleCount * 3; i++) {
+    adjacencyOffsets[remap[indices[i]] + 1]++;
+  }
+  for (size_t v = 0; v < vertexCount; v++) {
+    adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+  }
+  std::vector<uint32_t> adjacency(triangleCount * 3);
+  {
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t i = 0; i < triangleCount * 3; i++) {
+      adjacency[fill[remap[indices[i]]]++] = static_cast<uint32_t>(i / 3);
+    }
+  }
+
+  std::vector<Meshlet> meshlets;
+  std::vector<uint32_t> meshletIndices;
+  meshletIndices.reserve(triangleCount * 3);
+  std::vector<bool> assigned(triangleCount, false);
+  // Meshlet using each vertex, to count the unique vertices
+  std::vector<uint32_t> vertexMeshlet(vertexCount, ~0u);
+  std::vector<uint32_t> weldedMeshlet(vertexCount, ~0u);
+  std::vector<uint32_t> meshletWeldedVertices;
+
+  for (size_t seed = 0; seed < triangleCount; seed++) {
+    if (assigned[seed])
+      continue;
+
+    const auto meshletId = static_cast<uint32_t>(meshlets.size());
+    Meshlet meshlet{};
+    meshlet.firstIndex = static_cast<uint32_t>(meshletIndices.size());
+    uint32_t meshletVertexCount = 0;
+    uint32_t meshletTriangleCount = 0;
+    Vec3 normalSum{0, 0, 0};
+    meshletWeldedVertices.clear();
+
+    auto addTriangle = [&](size_t t) {
+      assigned[t] = true;
+      for (uint32_t v = 0; v < 3; v++) {
+        uint32_t index = indices[t * 3 + v];
+        if (vertexMeshlet[index] != meshletId) {
+          vertexMeshlet[index] = meshletId;
+          meshletVertexCount++;
+        }
+        uint32_t welded = remap[index];
+        if (weldedMeshlet[welded] != meshletId) {
+          weldedMeshlet[welded] = meshletId;
+          meshletWeldedVertices.push_back(welded);
+        }
+        meshletIndices.push_back(index);
+      }
+      normalSum = {normalSum.x + normals[t].x, normalSum.y + normals[t].y, normalSum.z + normals[t].z};
+      meshletTriangleCount++;
+    };
+    addTriangle(seed);
+
+    // Grow the meshlet with the neighbour adding the least vertices and facing the same way as the others
+    while (meshletTriangleCount < MESHLET_MAX_TRIANGLES) {
+      double normalLength = Length(normalSum);
+      int64_t best = -1;
+      double bestScore = 0;
+      for (uint32_t welded : meshletWeldedVertices) {
+        for (uint32_t a = adjacencyOffsets[welded]; a < adjacencyOffsets[welded + 1]; a++) {
+          uint32_t t = adjacency[a];
+          if (assigned[t])
+            continue;
+
+          uint32_t newVertexCount = 0;
+          for (uint32_t v = 0; v < 3; v++) {
+            newVertexCount += vertexMeshlet[indices[t * 3 + v]] != meshletId;
+          }
+          if (meshletVertexCount + newVertexCount > MESHLET_MAX_VERTICES)
+            continue;
+
+          double triangleNormalLength = Length(normals[t]);
+          double alignment = normalLength > 0 && triangleNormalLength > 0
+                                 ? Dot(normals[t], normalSum) / (triangleNormalLength * normalLength)
+                                 : 0;
+          // Triangles facing too far away would make the cone too wide to be culled
+          if (alignment < MESHLET_MIN_ALIGNMENT)
+            continue;
+          double score = 0.5 * (3 - newVertexCount) + alignment;
+          if (best < 0 || score > bestScore) {
+            best = t;
+            bestScore = score;
+          }
+        }
+      }
+      if (best < 0)
+        break;
+      addTriangle(best);
+    }
+    meshlet.indexCount = meshletTriangleCount * 3;
+
+    // Bounding sphere around the center of the bounding box
+    const uint32_t *meshletRange = &meshletIndices[meshlet.firstIndex];
+    Vec3 min = weldedPositions[meshletRange[0]];
+    Vec3 max = min;
+    for (uint32_t i = 0; i < meshlet.indexCount; i++) {
+      const Vec3 &p = weldedPositions[meshletRange[i]];
+      min = {std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z)};
+      max = {std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z)};
+    }
+    Vec3 center{(min.x + max.x) * 0.5, (min.y + max.y) * 0.5, (min.z + max.z) * 0.5};
+    double radius = 0;
+    for (uint32_t i = 0; i < meshlet.indexCount; i++) {
+      radius = std::max(radius, Length(Sub(weldedPositions[meshletRange[i]], center)));
+    }
+    meshlet.center[0] = static_cast<float>(center.x);
+    meshlet.center[1] = static_cast<float>(center.y);
+    meshlet.center[2] = static_cast<float>(center.z);
+    meshlet.radius = static_cast<float>(radius);
+
+    // Normal cone: average direction, and the widest angle between it and a triangle
+    std::vector<Vec3> unitNormals;
+    unitNormals.reserve(meshletTriangleCount);
+    Vec3 axis{0, 0, 0};
+    for (uint32_t i = 0; i < meshlet.indexCount; i += 3) {
+      const Vec3 &p0 = weldedPositions[meshletRange[i]];
+      Vec3 normal =
+          Cross(Sub(weldedPositions[meshletRange[i + 1]], p0), Sub(weldedPositions[meshletRange[i + 2]], p0));
+      double length = Length(normal);
+      if (length > 0) {
+        normal = {normal.x / length, normal.y / length, normal.z / length};
+        unitNormals.push_back(normal);
+        axis = {axis.x + normal.x, axis.y + normal.y, axis.z + normal.z};
+      }
+    }
+    double minDot = -1;
+    double axisLength = Length(axis);
+    if (axisLength > 0) {
+      axis = {axis.x / axisLength, axis.y / axisLength, axis.z / axisLength};
+      minDot = 1;
+      for (const Vec3 &normal : unitNormals) {
+        minDot = std::min(minDot, Dot(normal, axis));
+      }
+    }
+    meshlet.coneAxis[0] = static_cast<float>(axis.x);
+    meshlet.coneAxis[1] = static_cast<float>(axis.y);
+    meshlet.coneAxis[2] = static_cast<float>(axis.z);
+    // Cones wider than a half space can't be culled
+    meshlet.coneCutoff = minDot <= 0 ? 1.0f : static_cast<float>(std::sqrt(1 - minDot * minDot));
+
+    meshlets.push_back(meshlet);
+  }
+
+  indices = std::move(meshletIndices);
+  return meshlets;
+}
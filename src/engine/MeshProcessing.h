@@ -0,0 +1,69 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace meshutils {
+/** Maximum number of unique vertices of a meshlet */
+constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+/** Maximum number of triangles of a meshlet */
+constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+/**
+ * Cluster of triangles that is culled as a whole. The layout matches the one of the culling shader (std430).
+ */
+struct Meshlet {
+  /** Bounding sphere of the cluster */
+  float center[3];
+  float radius;
+  /**
+   * Normal cone of the triangles: the whole cluster faces away from a viewer at position p if
+   * dot(center - p, coneAxis) >= coneCutoff * length(center - p) + radius.
+   * A cutoff of 1 disables the test.
+   */
+  float coneAxis[3];
+  float coneCutoff;
+  /** Range of the cluster in the index list */
+  uint32_t firstIndex;
+  uint32_t indexCount;
+  uint32_t padding[2];
+};
+
+/**
+ * Simplifies an indexed triangle list by collapsing edges in the order given by quadric error metrics.
+ * Vertices are not moved: the result only uses a subset of the original vertices, so it can be drawn with the
+ * same vertex buffer. Vertices sharing a position are welded together during the process. Each corner of the
+ * result then uses the original vertex at its position whose attributes are the closest to the ones of the
+ * corner it comes from, so that UV and normal seams are kept.
+ *
+ * @param positions pointer to the position (3 floats) of the first vertex
+ * @param vertexStride number of bytes between two positions
+ * @param targetIndexCount the simplification stops when the result has this many indices or less
+ * @param outError if not null, receives the largest error introduced, as a distance in the mesh units
+ * @param attributes if not null, pointer to the attributes of the first vertex, with the same stride as the
+ * positions. Without them, the first vertex at each position is used.
+ * @param attributeCount number of floats of the attributes
+ * @return the indices of the simplified mesh. May have more indices than the target if the mesh can't be
+ * simplified further without breaking its topology.
+ */
+std::vector<uint32_t> Simplify(const std::vector<uint32_t> &indices, const float *positions,
+                               size_t vertexCount, size_t vertexStride, size_t targetIndexCount,
+                               float *outError = nullptr, const float *attributes = nullptr,
+                               size_t attributeCount = 0);
+
+/**
+ * Splits an indexed triangle list in meshlets of at most MESHLET_MAX_VERTICES vertices and
+ * MESHLET_MAX_TRIANGLES triangles. Triangles are grouped with their neighbours facing the same way, to keep
+ * the normal cones tight enough for back-facing clusters to be culled.
+ *
+ * @param indices the triangle list. Reordered so that the triangles of each meshlet are contiguous.
+ * @return the meshlets, with their range in the reordered list
+ */
+std::vector<Meshlet> BuildMeshlets(std::vector<uint32_t> &indices, const float *positions, size_t vertexCount,
+                                   size_t vertexStride);
+} // namespace meshutils
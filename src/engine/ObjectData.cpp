@@ -0,0 +1,35 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "ObjectData.h"
+#include <algorithm>
+#include <glm/geometric.hpp>
+
+BoundingSphere GetWorldBounds(const RenderObject &object) {
+  const BoundingSphere &bounds = object.mesh->GetBounds();
+  const glm::mat4 &transform = object.transformMatrix;
+  float scale = std::max({glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])),
+                          glm::length(glm::vec3(transform[2]))});
+  return BoundingSphere{
+      .center = transform * glm::vec4(bounds.center, 1.0f),
+      .radius = bounds.radius * scale,
+  };
+}
+
+void WriteObjectData(RenderObject *first, uint32_t count, const glm::vec3 &cameraPosition, float projectionScale,
+                     GPUObjectData *objects, ObjectColor *colors) {
+  for (uint32_t i = 0; i < count; i++) {
+    RenderObject &object = first[i];
+
+    // Choose the level of detail from the size of the object on the screen
+    const auto [center, radius] = GetWorldBounds(object);
+    float distance = glm::distance(center, cameraPosition);
+    object.lod = distance <= radius ? 0 : object.mesh->SelectLod(radius * projectionScale / distance, object.lod);
+
+    objects[i].modelMatrix = object.transformMatrix;
+    objects[i].materialData.x = object.material->materialIndex;
+    objects[i].boundingSphere = glm::vec4(center, radius);
+    colors[i].albedo = object.albedo;
+  }
+}
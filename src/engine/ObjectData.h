@@ -0,0 +1,19 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include "vk_engine.h"
+
+/** Bounding sphere of the mesh of an object, in world space */
+BoundingSphere GetWorldBounds(const RenderObject &object);
+
+/**
+ * Chooses the level of detail of the objects, and writes their data in the object buffers.
+ * Doesn't touch the GPU: the buffers only have to be mapped.
+ * @param cameraPosition position of the camera in world space
+ * @param projectionScale size in pixels of a sphere of radius 1 at a distance of 1
+ */
+void WriteObjectData(RenderObject *first, uint32_t count, const glm::vec3 &cameraPosition, float projectionScale,
+                     GPUObjectData *objects, ObjectColor *colors);
@@ -0,0 +1,400 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "OcclusionCuller.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+
+// The AVX2 kernels are compiled for AVX2 on their own and only called when the CPU supports it, so that the
+// rest of the program still runs on x86-64 CPUs without it
+#if defined(ENABLE_AVX2) && (defined(__x86_64__) || defined(_M_X64))
+#define OCCLUSION_AVX2
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define OCCLUSION_AVX2_TARGET
+#else
+#define OCCLUSION_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+/** Vertices closer than this to the camera plane can't be projected. Their triangles are skipped. */
+constexpr float MIN_W = 1e-3f;
+/** Depth of the cleared buffer: nothing is hidden behind it */
+constexpr float FAR_DEPTH = 1.0f;
+constexpr uint32_t TILE_SIZE = OcclusionCuller::TILE_WIDTH * OcclusionCuller::TILE_HEIGHT;
+
+void MultiplyMatrices(const float *a, const float *b, float *result) {
+  for (uint32_t column = 0; column < 4; column++) {
+    for (uint32_t row = 0; row < 4; row++) {
+      float sum = 0.0f;
+      for (uint32_t k = 0; k < 4; k++) {
+        sum += a[k * 4 + row] * b[column * 4 + k];
+      }
+      result[column * 4 + row] = sum;
+    }
+  }
+}
+
+void Transform(const float *matrix, const float *position, float *result) {
+  for (uint32_t row = 0; row < 4; row++) {
+    result[row] = matrix[row] * position[0] + matrix[4 + row] * position[1] + matrix[8 + row] * position[2] +
+                  matrix[12 + row];
+  }
+}
+
+/**
+ * Keeps the closest depth of the pixels of a row inside of the triangle.
+ * @param row first pixel of the row in the first tile of the buffer
+ * @param rowEdges values of the edge equations at x = 0
+ */
+void RasterizeRow(float *row, const float (&edges)[3][3], const float (&rowEdges)[3], float depthX,
+                  float rowDepth, int32_t minX, int32_t maxX) {
+  for (int32_t x = minX; x <= maxX; x++) {
+    const float centerX = static_cast<float>(x) + 0.5f;
+    if (edges[0][0] * centerX + rowEdges[0] < 0.0f || edges[1][0] * centerX + rowEdges[1] < 0.0f ||
+        edges[2][0] * centerX + rowEdges[2] < 0.0f)
+      continue;
+
+    float &pixel = row[static_cast<size_t>(x / OcclusionCuller::TILE_WIDTH) * TILE_SIZE +
+                       x % OcclusionCuller::TILE_WIDTH];
+    pixel = std::min(pixel, depthX * centerX + rowDepth);
+  }
+}
+
+float GetTileMaxDepth(const float *depth) { return *std::max_element(depth, depth + TILE_SIZE); }
+
+#ifdef OCCLUSION_AVX2
+bool CpuSupportsAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 1);
+  // AVX needs the OS to save the YMM registers
+  const bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+  if (!osSavesYmm || (info[2] & (1 << 28)) == 0)
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+
+/**
+ * Same as RasterizeRow, one row of a tile at a time.
+ * Pixels outside of the bounds are outside of the triangle as well.
+ */
+OCCLUSION_AVX2_TARGET void RasterizeRowAvx2(float *row, const float (&edges)[3][3],
+                                            const float (&rowEdges)[3], float depthX, float rowDepth,
+                                            int32_t minX, int32_t maxX) {
+  constexpr auto tileWidth = static_cast<int32_t>(OcclusionCuller::TILE_WIDTH);
+  const __m256 offsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+  const __m256 zero = _mm256_setzero_ps();
+  const int32_t lastTileX = maxX / tileWidth;
+  for (int32_t tileX = minX / tileWidth; tileX <= lastTileX; tileX++) {
+    const __m256 centerX = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(tileX * tileWidth)), offsets);
+    __m256 inside = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+    for (uint32_t e = 0; e < 3; e++) {
+      __m256 edge =
+          _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(edges[e][0]), centerX), _mm256_set1_ps(rowEdges[e]));
+      inside = _mm256_and_ps(inside, _mm256_cmp_ps(edge, zero, _CMP_GE_OQ));
+    }
+    if (_mm256_movemask_ps(inside) == 0)
+      continue;
+
+    // Keep the closest depth of the pixels inside of the triangle
+    float *pixels = row + static_cast<size_t>(tileX) * TILE_SIZE;
+    const __m256 pixelDepth =
+        _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(depthX), centerX), _mm256_set1_ps(rowDepth));
+    const __m256 current = _mm256_loadu_ps(pixels);
+    _mm256_storeu_ps(pixels, _mm256_blendv_ps(current, _mm256_min_ps(current, pixelDepth), inside));
+  }
+}
+
+OCCLUSION_AVX2_TARGET float GetTileMaxDepthAvx2(const float *depth) {
+  __m256 rows = _mm256_max_ps(_mm256_max_ps(_mm256_loadu_ps(depth), _mm256_loadu_ps(depth + 8)),
+                              _mm256_max_ps(_mm256_loadu_ps(depth + 16), _mm256_loadu_ps(depth + 24)));
+  __m128 half = _mm_max_ps(_mm256_castps256_ps128(rows), _mm256_extractf128_ps(rows, 1));
+  half = _mm_max_ps(half, _mm_movehl_ps(half, half));
+  half = _mm_max_ss(half, _mm_shuffle_ps(half, half, 1));
+  return _mm_cvtss_f32(half);
+}
+#endif
+} // namespace
+
+OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height, JobSystem *jobSystem)
+    : _tilesX((width + TILE_WIDTH - 1) / TILE_WIDTH), _tilesY((height + TILE_HEIGHT - 1) / TILE_HEIGHT),
+      _jobSystem(jobSystem) {
+  _width = _tilesX * TILE_WIDTH;
+  _height = _tilesY * TILE_HEIGHT;
+  _depth.resize(static_cast<size_t>(_width) * _height, FAR_DEPTH);
+  _tileMaxDepth.resize(static_cast<size_t>(_tilesX) * _tilesY, FAR_DEPTH);
+}
+
+template <class F> void OcclusionCuller::ParallelFor(size_t count, size_t minRangeSize, F &&function) const {
+  const size_t workerCount = _jobSystem != nullptr ? _jobSystem->GetWorkerCount() : 0;
+  const size_t rangeCount = std::clamp<size_t>((count + minRangeSize - 1) / minRangeSize, 1, workerCount + 1);
+  const size_t rangeSize = (count + rangeCount - 1) / rangeCount;
+
+  // The ranges are claimed by the calling thread and the workers. The job queue is shared with the asset
+  // loading, so the calling thread runs the ranges that no worker has started instead of waiting behind it.
+  // The state outlives the call, since a worker may only get to its job once every range is done.
+  struct Ranges {
+    std::atomic<size_t> next = 0;
+    std::atomic<size_t> done = 0;
+  };
+  auto ranges = std::make_shared<Ranges>();
+  auto runRanges = [ranges, &function, rangeCount, rangeSize, count]() {
+    for (size_t range = ranges->next++; range < rangeCount; range = ranges->next++) {
+      const size_t first = range * rangeSize;
+      function(first, std::min(first + rangeSize, count));
+      if (++ranges->done == rangeCount)
+        ranges->done.notify_all();
+    }
+  };
+  for (size_t i = 1; i < rangeCount; i++) {
+    _jobSystem->Submit(runRanges);
+  }
+  runRanges();
+
+  // Wait for the ranges still running on the workers
+  for (size_t done = ranges->done; done < rangeCount; done = ranges->done) {
+    ranges->done.wait(done);
+  }
+}
+
+void OcclusionCuller::BeginFrame(const float *viewProj) {
+  std::copy(viewProj, viewProj + 16, _viewProj);
+  _occluders.clear();
+}
+
+void OcclusionCuller::AddOccluder(const float *positions, size_t vertexCount, size_t vertexStride,
+                                  const uint32_t *indices, size_t indexCount, const float *model) {
+  Occluder occluder{};
+  occluder.positions = positions;
+  occluder.vertexCount = vertexCount;
+  occluder.vertexStride = vertexStride;
+  occluder.indices = indices;
+  occluder.indexCount = indexCount;
+  MultiplyMatrices(_viewProj, model, occluder.modelViewProj);
+  _occluders.push_back(occluder);
+}
+
+void OcclusionCuller::Rasterize() {
+  // Project the triangles once, then each band rasterizes the ones that overlap it
+  _triangles.clear();
+  for (const auto &occluder : _occluders) {
+    SetupTriangles(occluder);
+  }
+
+  ParallelFor(_tilesY, 2, [this](size_t first, size_t end) {
+    RasterizeBand(static_cast<uint32_t>(first), static_cast<uint32_t>(end));
+  });
+}
+
+void OcclusionCuller::SetupTriangles(const Occluder &occluder) {
+  // Vertices in pixel coordinates, with their depth and clip space w
+  _screenVertices.resize(occluder.vertexCount * 4);
+  const auto *bytes = reinterpret_cast<const uint8_t *>(occluder.positions);
+  for (size_t v = 0; v < occluder.vertexCount; v++) {
+    const auto *position = reinterpret_cast<const float *>(bytes + v * occluder.vertexStride);
+    float clip[4];
+    Transform(occluder.modelViewProj, position, clip);
+
+    float *screen = &_screenVertices[v * 4];
+    screen[3] = clip[3];
+    if (clip[3] < MIN_W)
+      continue;
+    screen[0] = (clip[0] / clip[3] * 0.5f + 0.5f) * static_cast<float>(_width);
+    screen[1] = (clip[1] / clip[3] * 0.5f + 0.5f) * static_cast<float>(_height);
+    screen[2] = clip[2] / clip[3];
+  }
+
+  for (size_t i = 0; i + 2 < occluder.indexCount; i += 3) {
+    const float *v[3] = {
+        &_screenVertices[occluder.indices[i] * 4],
+        &_screenVertices[occluder.indices[i + 1] * 4],
+        &_screenVertices[occluder.indices[i + 2] * 4],
+    };
+    // Skipping a triangle only makes the culling less effective, so the ones crossing the camera plane are
+    // not clipped
+    if (v[0][3] < MIN_W || v[1][3] < MIN_W || v[2][3] < MIN_W)
+      continue;
+
+    // Both faces are rasterized: orient the triangle so that the inside is on the positive side of the edges
+    float area = (v[1][0] - v[0][0]) * (v[2][1] - v[0][1]) - (v[1][1] - v[0][1]) * (v[2][0] - v[0][0]);
+    if (std::abs(area) < 1e-6f)
+      continue;
+    if (area < 0) {
+      std::swap(v[1], v[2]);
+      area = -area;
+    }
+
+    ScreenTriangle triangle{};
+    triangle.minX = std::max(static_cast<int32_t>(std::floor(std::min({v[0][0], v[1][0], v[2][0]}))), 0);
+    triangle.minY = std::max(static_cast<int32_t>(std::floor(std::min({v[0][1], v[1][1], v[2][1]}))), 0);
+    triangle.maxX = std::min(static_cast<int32_t>(std::ceil(std::max({v[0][0], v[1][0], v[2][0]}))),
+                             static_cast<int32_t>(_width) - 1);
+    triangle.maxY = std::min(static_cast<int32_t>(std::ceil(std::max({v[0][1], v[1][1], v[2][1]}))),
+                             static_cast<int32_t>(_height) - 1);
+    if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+      continue;
+
+    // Edge e goes from vertex e to the next one. It is 0 on the opposite vertex, so the barycentric
+    // coordinate of a vertex is the value of the edge opposite to it, divided by the area.
+    for (uint32_t e = 0; e < 3; e++) {
+      const float *a = v[e];
+      const float *b = v[(e + 1) % 3];
+      triangle.edges[e][0] = a[1] - b[1];
+      triangle.edges[e][1] = b[0] - a[0];
+      triangle.edges[e][2] = -(triangle.edges[e][0] * a[0] + triangle.edges[e][1] * a[1]);
+    }
+    for (uint32_t k = 0; k < 3; k++) {
+      triangle.depth[k] = (triangle.edges[1][k] * v[0][2] + triangle.edges[2][k] * v[1][2] +
+                           triangle.edges[0][k] * v[2][2]) /
+                          area;
+    }
+    _triangles.push_back(triangle);
+  }
+}
+
+void OcclusionCuller::RasterizeBand(uint32_t firstTileRow, uint32_t endTileRow) {
+  const int32_t firstY = static_cast<int32_t>(firstTileRow * TILE_HEIGHT);
+  const int32_t lastY = static_cast<int32_t>(endTileRow * TILE_HEIGHT) - 1;
+
+  // Clear the band
+  std::fill(_depth.begin() + static_cast<size_t>(firstTileRow) * _tilesX * TILE_SIZE,
+            _depth.begin() + static_cast<size_t>(endTileRow) * _tilesX * TILE_SIZE, FAR_DEPTH);
+
+  for (const auto &triangle : _triangles) {
+    if (triangle.maxY < firstY || triangle.minY > lastY)
+      continue;
+    RasterizeTriangle(triangle, std::max(triangle.minY, firstY), std::min(triangle.maxY, lastY));
+  }
+
+  // Farthest depth of each tile
+  auto getTileMaxDepth = GetTileMaxDepth;
+#ifdef OCCLUSION_AVX2
+  if (UsesAvx2())
+    getTileMaxDepth = GetTileMaxDepthAvx2;
+#endif
+  const size_t endTile = static_cast<size_t>(endTileRow) * _tilesX;
+  for (size_t tile = static_cast<size_t>(firstTileRow) * _tilesX; tile < endTile; tile++) {
+    _tileMaxDepth[tile] = getTileMaxDepth(&_depth[tile * TILE_SIZE]);
+  }
+}
+
+void OcclusionCuller::RasterizeTriangle(const ScreenTriangle &triangle, int32_t minY, int32_t maxY) {
+  const auto &edges = triangle.edges;
+  const auto &depth = triangle.depth;
+  auto rasterizeRow = RasterizeRow;
+#ifdef OCCLUSION_AVX2
+  if (UsesAvx2())
+    rasterizeRow = RasterizeRowAvx2;
+#endif
+
+  for (int32_t y = minY; y <= maxY; y++) {
+    // Everything is evaluated at the center of the pixels
+    const float centerY = static_cast<float>(y) + 0.5f;
+    const float rowEdges[3] = {
+        edges[0][1] * centerY + edges[0][2],
+        edges[1][1] * centerY + edges[1][2],
+        edges[2][1] * centerY + edges[2][2],
+    };
+    const float rowDepth = depth[1] * centerY + depth[2];
+    float *row =
+        &_depth[static_cast<size_t>(y / TILE_HEIGHT) * _tilesX * TILE_SIZE + (y % TILE_HEIGHT) * TILE_WIDTH];
+    rasterizeRow(row, edges, rowEdges, depth[0], rowDepth, triangle.minX, triangle.maxX);
+  }
+}
+
+bool OcclusionCuller::IsVisible(const OcclusionBox &box) const {
+  // Screen bounds and closest depth of the corners
+  float minX = INFINITY;
+  float minY = INFINITY;
+  float maxX = -INFINITY;
+  float maxY = -INFINITY;
+  float minDepth = INFINITY;
+  for (uint32_t corner = 0; corner < 8; corner++) {
+    const float position[3] = {
+        corner & 1 ? box.max[0] : box.min[0],
+        corner & 2 ? box.max[1] : box.min[1],
+        corner & 4 ? box.max[2] : box.min[2],
+    };
+    float clip[4];
+    Transform(_viewProj, position, clip);
+    if (clip[3] < MIN_W)
+      return true;
+
+    const float x = (clip[0] / clip[3] * 0.5f + 0.5f) * static_cast<float>(_width);
+    const float y = (clip[1] / clip[3] * 0.5f + 0.5f) * static_cast<float>(_height);
+    minX = std::min(minX, x);
+    minY = std::min(minY, y);
+    maxX = std::max(maxX, x);
+    maxY = std::max(maxY, y);
+    minDepth = std::min(minDepth, clip[2] / clip[3]);
+  }
+
+  if (maxX < 0 || maxY < 0 || minX >= static_cast<float>(_width) || minY >= static_cast<float>(_height))
+    return false;
+  const auto x0 = static_cast<uint32_t>(std::max(minX, 0.0f));
+  const auto y0 = static_cast<uint32_t>(std::max(minY, 0.0f));
+  const uint32_t x1 = std::min(static_cast<uint32_t>(maxX), _width - 1);
+  const uint32_t y1 = std::min(static_cast<uint32_t>(maxY), _height - 1);
+
+  // Visible as soon as a pixel under the box is farther than its closest point
+  for (uint32_t tileY = y0 / TILE_HEIGHT; tileY <= y1 / TILE_HEIGHT; tileY++) {
+    for (uint32_t tileX = x0 / TILE_WIDTH; tileX <= x1 / TILE_WIDTH; tileX++) {
+      const size_t tile = static_cast<size_t>(tileY) * _tilesX + tileX;
+      if (_tileMaxDepth[tile] < minDepth)
+        continue;
+
+      // The box may only cover a part of the tile
+      const float *depth = &_depth[tile * TILE_SIZE];
+      const uint32_t lastY = std::min(y1, tileY * TILE_HEIGHT + TILE_HEIGHT - 1);
+      const uint32_t lastX = std::min(x1, tileX * TILE_WIDTH + TILE_WIDTH - 1);
+      for (uint32_t y = std::max(y0, tileY * TILE_HEIGHT); y <= lastY; y++) {
+        for (uint32_t x = std::max(x0, tileX * TILE_WIDTH); x <= lastX; x++) {
+          if (depth[(y % TILE_HEIGHT) * TILE_WIDTH + x % TILE_WIDTH] >= minDepth)
+            return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+void OcclusionCuller::TestBoxes(const OcclusionBox *boxes, size_t count, uint8_t *visible) const {
+  ParallelFor(count, 256, [this, boxes, visible](size_t first, size_t end) {
+    TestBoxRange(boxes + first, end - first, visible + first);
+  });
+}
+
+void OcclusionCuller::TestBoxRange(const OcclusionBox *boxes, size_t count, uint8_t *visible) const {
+  for (size_t i = 0; i < count; i++) {
+    visible[i] = IsVisible(boxes[i]) ? 1 : 0;
+  }
+}
+
+uint32_t OcclusionCuller::GetWidth() const { return _width; }
+
+uint32_t OcclusionCuller::GetHeight() const { return _height; }
+
+float OcclusionCuller::GetDepth(uint32_t x, uint32_t y) const {
+  const size_t tile = static_cast<size_t>(y / TILE_HEIGHT) * _tilesX + x / TILE_WIDTH;
+  return _depth[tile * TILE_SIZE + (y % TILE_HEIGHT) * TILE_WIDTH + x % TILE_WIDTH];
+}
+
+bool OcclusionCuller::UsesAvx2() {
+#ifdef OCCLUSION_AVX2
+  static const bool supported = CpuSupportsAvx2();
+  return supported;
+#else
+  return false;
+#endif
+}
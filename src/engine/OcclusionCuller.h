@@ -0,0 +1,117 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include "JobSystem.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** Axis aligned box, in world space */
+struct OcclusionBox {
+  float min[3];
+  float max[3];
+};
+
+/**
+ * Software occlusion culling, for when the GPU can't cull the objects itself.
+ * A few large occluders are rasterized in a small depth buffer, then the bounding boxes of the objects are
+ * tested against it. The depth buffer is split in tiles of 8x4 pixels, so that a row of a tile fits in an
+ * AVX2 register. The AVX2 kernels are only used when the CPU supports them.
+ *
+ * Matrices are column major like glm ones, and depths are the ones of the given projection (z / w).
+ * Work is split in bands of tiles between the calling thread and the workers of the job system, if any.
+ */
+class OcclusionCuller {
+public:
+  static constexpr uint32_t TILE_WIDTH = 8;
+  static constexpr uint32_t TILE_HEIGHT = 4;
+
+private:
+  struct Occluder {
+    const float *positions;
+    size_t vertexCount;
+    size_t vertexStride;
+    const uint32_t *indices;
+    size_t indexCount;
+    float modelViewProj[16];
+  };
+
+  /** Triangle in pixel coordinates, with its edge equations and depth plane: value = a * x + b * y + c */
+  struct ScreenTriangle {
+    float edges[3][3];
+    float depth[3];
+    int32_t minX;
+    int32_t minY;
+    int32_t maxX;
+    int32_t maxY;
+  };
+
+  uint32_t _width;
+  uint32_t _height;
+  uint32_t _tilesX;
+  uint32_t _tilesY;
+  JobSystem *_jobSystem;
+
+  float _viewProj[16] = {};
+  std::vector<Occluder> _occluders;
+  std::vector<ScreenTriangle> _triangles;
+  /** Projected vertices of the occluder being set up: x, y, depth and clip space w */
+  std::vector<float> _screenVertices;
+  /** Depth of each pixel, tile after tile */
+  std::vector<float> _depth;
+  /** Farthest depth of each tile, to reject boxes without looking at the pixels */
+  std::vector<float> _tileMaxDepth;
+
+  void SetupTriangles(const Occluder &occluder);
+  void RasterizeBand(uint32_t firstTileRow, uint32_t endTileRow);
+  void RasterizeTriangle(const ScreenTriangle &triangle, int32_t minY, int32_t maxY);
+  void TestBoxRange(const OcclusionBox *boxes, size_t count, uint8_t *visible) const;
+
+  /**
+   * Runs the function on ranges of [0, count[, on the workers and the calling thread. The calling thread runs
+   * the ranges that the workers haven't started, so it never waits behind the other jobs of the queue.
+   */
+  template <class F> void ParallelFor(size_t count, size_t minRangeSize, F &&function) const;
+
+public:
+  /**
+   * @param width, height size of the depth buffer, rounded up to whole tiles. It doesn't need to match the
+   * window: a few hundred pixels wide is usually enough.
+   * @param jobSystem if not null, its workers share the rasterization and the tests
+   */
+  OcclusionCuller(uint32_t width, uint32_t height, JobSystem *jobSystem = nullptr);
+
+  /** Clears the occluders and the depth buffer, and sets the camera used until the next frame */
+  void BeginFrame(const float *viewProj);
+
+  /**
+   * Registers an occluder for this frame. The geometry is only read by Rasterize, and must stay alive until
+   * then.
+   * @param vertexStride number of bytes between two positions
+   * @param model model matrix of the occluder
+   */
+  void AddOccluder(const float *positions, size_t vertexCount, size_t vertexStride, const uint32_t *indices,
+                   size_t indexCount, const float *model);
+
+  /** Rasterizes the registered occluders in the depth buffer */
+  void Rasterize();
+
+  /**
+   * Tests a box against the depth buffer. Boxes outside of the screen are not visible, and boxes crossing the
+   * near plane always are.
+   */
+  [[nodiscard]] bool IsVisible(const OcclusionBox &box) const;
+
+  /** Tests many boxes at once, and writes 1 in visible for each box that is visible, 0 otherwise */
+  void TestBoxes(const OcclusionBox *boxes, size_t count, uint8_t *visible) const;
+
+  [[nodiscard]] uint32_t GetWidth() const;
+  [[nodiscard]] uint32_t GetHeight() const;
+  /** Depth of a pixel, for debugging */
+  [[nodiscard]] float GetDepth(uint32_t x, uint32_t y) const;
+  /** Is the rasterization done with AVX2 instructions ? Depends on the CPU, checked once. */
+  [[nodiscard]] static bool UsesAvx2();
+};
@@ -0,0 +1,77 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "PerformanceOverlay.h"
+#include <algorithm>
+#include <imgui.h>
+
+namespace {
+
+/** Reads a time of the history, for ImGui::PlotLines */
+template <float RenderStats::*time> float GetTime(void *history, int32_t index) {
+  return static_cast<const RenderStatsHistory *>(history)->Get(index).*time;
+}
+
+} // namespace
+
+void PerformanceOverlay::Build(const RenderStatsHistory &history, float frameTime,
+                               const MemoryTracker &memoryTracker) {
+  if (++_framesSinceMemoryReport >= OVERLAY_MEMORY_REFRESH_FRAMES) {
+    _memoryReport = memoryTracker.GetReport();
+    _framesSinceMemoryReport = 0;
+  }
+
+  ImGui::SetNextWindowPos(ImVec2(10.0f, 10.0f), ImGuiCond_Always);
+  ImGui::SetNextWindowBgAlpha(0.7f);
+  constexpr ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
+                                     ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoFocusOnAppearing |
+                                     ImGuiWindowFlags_NoNav;
+  if (ImGui::Begin("Performance", nullptr, flags)) {
+    ImGui::Text("%.2f ms (%.0f FPS)", frameTime, frameTime > 0.0f ? 1000.0f / frameTime : 0.0f);
+
+    // Both graphs share the same scale, so that they can be compared
+    const RenderStats &stats = history.GetLatest();
+    const float maxTime =
+        std::max(history.GetMax(&RenderStats::cpuTime), history.GetMax(&RenderStats::gpuTime));
+    const float scaleMax = std::max(maxTime * 1.1f, 1.0f);
+    const ImVec2 graphSize(static_cast<float>(RENDER_STATS_HISTORY_SIZE), 40.0f);
+    auto *historyData = const_cast<RenderStatsHistory *>(&history);
+    const auto frameCount = static_cast<int32_t>(history.GetSize());
+    ImGui::Text("CPU %.2f ms", stats.cpuTime);
+    ImGui::PlotLines("##cpu", GetTime<&RenderStats::cpuTime>, historyData, frameCount, 0, nullptr, 0.0f,
+                     scaleMax, graphSize);
+    if (stats.gpuTime > 0.0f) {
+      ImGui::Text("GPU %.2f ms", stats.gpuTime);
+      ImGui::PlotLines("##gpu", GetTime<&RenderStats::gpuTime>, historyData, frameCount, 0, nullptr, 0.0f,
+                       scaleMax, graphSize);
+    } else {
+      ImGui::TextDisabled("GPU timestamps not supported");
+    }
+
+    ImGui::Separator();
+    ImGui::Text("Draw calls: %u (max %u), %u instances", stats.drawCalls,
+                history.GetMax(&RenderStats::drawCalls), stats.instances);
+    ImGui::Text("Triangles: %llu", static_cast<unsigned long long>(stats.triangles));
+    ImGui::Text("Objects: %u visible, %u culled", stats.visibleObjects, stats.culledObjects);
+    ImGui::Text("Binds: %u pipelines, %u descriptor sets, %u vertex buffers", stats.pipelineBinds,
+                stats.descriptorBinds, stats.vertexBufferBinds);
+    ImGui::Text("Push constants: %u, uploaded: %.1f KiB", stats.pushConstantCalls,
+                static_cast<float>(stats.bytesUploaded) / 1024.0f);
+
+    ImGui::Separator();
+    constexpr float MIB = 1024.0f * 1024.0f;
+    for (size_t i = 0; i < _memoryReport.heaps.size(); i++) {
+      const MemoryReport::Heap &heap = _memoryReport.heaps[i];
+      if (heap.blockBytes == 0)
+        continue;
+      const float usage = static_cast<float>(heap.usage) / MIB;
+      const float budget = static_cast<float>(heap.budget) / MIB;
+      const float blocks = static_cast<float>(heap.blockBytes) / MIB;
+      ImGui::Text("Heap %zu%s: %.1f / %.1f MiB, %.1f MiB in VMA blocks", i,
+                  heap.deviceLocal ? " (device)" : "", usage, budget, blocks);
+      ImGui::ProgressBar(budget > 0.0f ? usage / budget : 0.0f, ImVec2(-1.0f, 0.0f), "");
+    }
+  }
+  ImGui::End();
+}
@@ -0,0 +1,29 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include "MemoryTracker.h"
+#include "RenderStats.h"
+
+/** The memory report allocates, so it is only refreshed every few frames */
+constexpr uint32_t OVERLAY_MEMORY_REFRESH_FRAMES = 30;
+
+/**
+ * ImGui window showing the frame times and the counters of the renderer.
+ * Builds the widgets only: the engine renders the ImGui draw data.
+ */
+class PerformanceOverlay {
+private:
+  MemoryReport _memoryReport;
+  uint32_t _framesSinceMemoryReport = OVERLAY_MEMORY_REFRESH_FRAMES;
+
+public:
+  /**
+   * Builds the window. Must be called between ImGui::NewFrame and ImGui::Render.
+   * @param history stats of the last frames. The counters shown are the ones of the latest.
+   * @param frameTime time between the last two frames, in milliseconds
+   */
+  void Build(const RenderStatsHistory &history, float frameTime, const MemoryTracker &memoryTracker);
+};
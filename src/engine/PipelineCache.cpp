@@ -0,0 +1,107 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "PipelineCache.h"
+#include "vk_engine.h"
+#include "vk_init.h"
+#include <algorithm>
+#include <bit>
+#include <functional>
+
+// ==== Pipeline state ====
+
+PipelineState PipelineState::WithConstant(uint32_t id, uint32_t value) const {
+  PipelineState state = *this;
+  // Keep the constants sorted, so that the same constants set in another order give an equal state
+  auto it = std::lower_bound(
+      state.constants.begin(), state.constants.end(), id,
+      [](const SpecializationConstant &constant, uint32_t constantId) { return constant.id < constantId; });
+  if (it != state.constants.end() && it->id == id) {
+    it->value = value;
+  } else {
+    state.constants.insert(it, SpecializationConstant{.id = id, .value = value});
+  }
+  return state;
+}
+
+PipelineState PipelineState::WithConstant(uint32_t id, float value) const {
+  return WithConstant(id, std::bit_cast<uint32_t>(value));
+}
+
+size_t PipelineState::Hash() const {
+  size_t seed = std::hash<std::string>{}(vertexShader);
+  vkinit::HashCombine(seed, std::hash<std::string>{}(fragmentShader));
+  for (const auto &constant : constants) {
+    vkinit::HashCombine(seed, constant.id);
+    vkinit::HashCombine(seed, constant.value);
+  }
+  vkinit::HashCombine(seed, vkinit::HashHandle(layout));
+  vkinit::HashCombine(seed, static_cast<size_t>(polygonMode));
+  vkinit::HashCombine(seed, static_cast<size_t>(depthCompare));
+  vkinit::HashCombine(seed, (depthTest ? 1u : 0u) | (depthWrite ? 2u : 0u) | (alphaBlending ? 4u : 0u));
+  return seed;
+}
+
+// ==== Pipeline cache ====
+
+void PipelineCache::Init(vk::Device device, vk::RenderPass renderPass, vk::Extent2D extent,
+                         VertexInputDescription vertexInput) {
+  _device = device;
+  _renderPass = renderPass;
+  _extent = extent;
+  _vertexInput = std::move(vertexInput);
+}
+
+vk::ShaderModule PipelineCache::GetShaderModule(const std::string &path) {
+  auto it = _shaderModules.find(path);
+  if (it != _shaderModules.end()) {
+    return it->second;
+  }
+  vk::ShaderModule module = vkinit::LoadShaderModule(_device, path.c_str());
+  _shaderModules.emplace(path, module);
+  return module;
+}
+
+vk::Pipeline PipelineCache::GetPipeline(const PipelineState &state) {
+  // Return the existing pipeline if there is one
+  auto it = _pipelines.find(state);
+  if (it != _pipelines.end()) {
+    return it->second;
+  }
+
+  // Else, compile it
+  PROFILE_ZONE("CompilePipeline");
+  vk::ShaderModule vertexShader = GetShaderModule(state.vertexShader);
+  vk::ShaderModule fragmentShader = GetShaderModule(state.fragmentShader);
+  auto builder = PipelineBuilder()
+                     .WithPipelineLayout(state.layout)
+                     .GetDefaultsForExtent(_extent)
+                     .AddShaderStage(vk::ShaderStageFlagBits::eVertex, vertexShader)
+                     .AddShaderStage(vk::ShaderStageFlagBits::eFragment, fragmentShader)
+                     .WithVertexInput(_vertexInput)
+                     .WithPolygonMode(state.polygonMode)
+                     .WithDepthTestingSettings(state.depthTest, state.depthWrite, state.depthCompare);
+  if (state.alphaBlending) {
+    builder = builder.WithAlphaBlending();
+  }
+  for (const auto &constant : state.constants) {
+    builder = builder.WithSpecializationConstant(constant.id, constant.value);
+  }
+  vk::Pipeline pipeline = builder.Build(_device, _renderPass);
+  _pipelines.emplace(state, pipeline);
+  return pipeline;
+}
+
+size_t PipelineCache::GetPipelineCount() const { return _pipelines.size(); }
+
+void PipelineCache::Cleanup() {
+  for (auto &[state, pipeline] : _pipelines) {
+    _device.destroyPipeline(pipeline);
+  }
+  for (auto &[path, module] : _shaderModules) {
+    _device.destroyShaderModule(module);
+  }
+  _pipelines.clear();
+  _shaderModules.clear();
+}
@@ -0,0 +1,78 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include "Mesh.h"
+#include "vk_types.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** Value of a specialization constant of a shader, identified by its constant_id */
+struct SpecializationConstant {
+  uint32_t id;
+  /** Raw bits of the value. Floats are stored with their bit pattern. */
+  uint32_t value;
+
+  bool operator==(const SpecializationConstant &other) const = default;
+};
+
+/**
+ * Everything that makes a graphics pipeline: a shader template, the specialization constants chosen for it
+ * and the fixed-function state. Two materials with equal states share the same pipeline.
+ */
+struct PipelineState {
+  /** Paths of the compiled shaders */
+  std::string vertexShader;
+  std::string fragmentShader;
+  /** Constants of both stages, sorted by id. The ones that aren't set keep their default in the shader. */
+  std::vector<SpecializationConstant> constants;
+  vk::PipelineLayout layout = nullptr;
+  vk::PolygonMode polygonMode = vk::PolygonMode::eFill;
+  bool depthTest = true;
+  bool depthWrite = true;
+  vk::CompareOp depthCompare = vk::CompareOp::eLessOrEqual;
+  bool alphaBlending = false;
+
+  /** Sets the value of a specialization constant, replacing the previous one */
+  PipelineState WithConstant(uint32_t id, uint32_t value) const;
+  PipelineState WithConstant(uint32_t id, float value) const;
+
+  bool operator==(const PipelineState &other) const = default;
+  [[nodiscard]] size_t Hash() const;
+};
+
+/**
+ * Compiles the pipelines of the materials, once per unique state.
+ *
+ * Pipelines are only compiled the first time a state is requested, so that materials can be declared as
+ * variants of a few shader templates without paying for the ones that are never drawn. The shader modules are
+ * kept for the next variants. Every pipeline targets the same render pass and vertex input.
+ */
+class PipelineCache {
+private:
+  struct StateHasher {
+    size_t operator()(const PipelineState &state) const { return state.Hash(); }
+  };
+
+  vk::Device _device;
+  vk::RenderPass _renderPass;
+  vk::Extent2D _extent;
+  VertexInputDescription _vertexInput;
+  std::unordered_map<std::string, vk::ShaderModule> _shaderModules;
+  std::unordered_map<PipelineState, vk::Pipeline, StateHasher> _pipelines;
+
+  vk::ShaderModule GetShaderModule(const std::string &path);
+
+public:
+  void Init(vk::Device device, vk::RenderPass renderPass, vk::Extent2D extent,
+            VertexInputDescription vertexInput);
+  /** Returns the pipeline of the state, and compiles it if it is the first time it is requested */
+  vk::Pipeline GetPipeline(const PipelineState &state);
+  /** Number of unique pipelines compiled so far */
+  [[nodiscard]] size_t GetPipelineCount() const;
+  void Cleanup();
+};
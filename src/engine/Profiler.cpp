@@ -0,0 +1,118 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "Profiler.h"
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+struct ZoneEvent {
+  const char *name;
+  uint64_t start;
+  uint64_t end;
+};
+
+/** Ring of the zones of a thread. Only its thread writes to it. */
+struct ThreadBuffer {
+  uint32_t threadIndex;
+  std::string name;
+  /** Number of zones written since the start */
+  std::atomic<uint64_t> head{0};
+  std::array<ZoneEvent, PROFILER_RING_SIZE> events;
+};
+
+/** The buffers are never freed, so that the zones of finished threads can still be exported */
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> registry;
+thread_local ThreadBuffer *threadBuffer = nullptr;
+
+ThreadBuffer &GetThreadBuffer() {
+  if (threadBuffer == nullptr) {
+    std::lock_guard lock(registryMutex);
+    registry.push_back(std::make_unique<ThreadBuffer>());
+    threadBuffer = registry.back().get();
+    threadBuffer->threadIndex = static_cast<uint32_t>(registry.size() - 1);
+    threadBuffer->name = "Thread " + std::to_string(threadBuffer->threadIndex);
+  }
+  return *threadBuffer;
+}
+
+/** Reference point to convert the ticks to time: the conversion is measured over the whole run */
+struct ClockReference {
+  uint64_t ticks;
+  std::chrono::steady_clock::time_point time;
+};
+const ClockReference startReference{Profiler::Now(), std::chrono::steady_clock::now()};
+} // namespace
+
+std::atomic<bool> Profiler::_recording{PROFILER_ENABLED};
+std::atomic<uint64_t> Profiler::_recordingStart{0};
+
+void Profiler::Record(const char *name, uint64_t start, uint64_t end) {
+  ThreadBuffer &buffer = GetThreadBuffer();
+  const uint64_t head = buffer.head.load(std::memory_order_relaxed);
+  buffer.events[head % PROFILER_RING_SIZE] = ZoneEvent{name, start, end};
+  buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::SetThreadName(const char *name) { GetThreadBuffer().name = name; }
+
+void Profiler::StartRecording() {
+  _recordingStart.store(Now(), std::memory_order_relaxed);
+  _recording.store(true, std::memory_order_relaxed);
+}
+
+void Profiler::StopRecording() { _recording.store(false, std::memory_order_relaxed); }
+
+bool Profiler::WriteChromeTrace(const char *path) {
+  std::ofstream file(path);
+  if (!file.is_open())
+    return false;
+
+  const uint64_t elapsedTicks = Now() - startReference.ticks;
+  const auto elapsedTime = std::chrono::steady_clock::now() - startReference.time;
+  const double microsecondsPerTick =
+      elapsedTicks > 0
+          ? std::chrono::duration<double, std::micro>(elapsedTime).count() / static_cast<double>(elapsedTicks)
+          : 0.0;
+  const uint64_t recordingStart = _recordingStart.load(std::memory_order_relaxed);
+
+  file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+  bool first = true;
+  std::vector<ZoneEvent> events;
+  std::lock_guard lock(registryMutex);
+  for (const auto &buffer : registry) {
+    // Copy the ring, then drop the zones its thread may have overwritten in the meantime
+    const uint64_t head = buffer->head.load(std::memory_order_acquire);
+    const uint64_t begin = head > PROFILER_RING_SIZE ? head - PROFILER_RING_SIZE : 0;
+    events.clear();
+    for (uint64_t i = begin; i < head; i++) {
+      events.push_back(buffer->events[i % PROFILER_RING_SIZE]);
+    }
+    const uint64_t newHead = buffer->head.load(std::memory_order_acquire);
+    const uint64_t overwritten = newHead > PROFILER_RING_SIZE ? newHead - PROFILER_RING_SIZE : 0;
+    const size_t skipped = overwritten > begin ? std::min<size_t>(overwritten - begin, events.size()) : 0;
+
+    file << (first ? "" : ",\n") << R"({"name": "thread_name", "ph": "M", "pid": 0, "tid": )"
+         << buffer->threadIndex << R"(, "args": {"name": ")" << buffer->name << "\"}}";
+    first = false;
+    for (size_t i = skipped; i < events.size(); i++) {
+      const ZoneEvent &event = events[i];
+      if (event.start < recordingStart)
+        continue;
+      file << ",\n"
+           << R"({"name": ")" << event.name << R"(", "cat": "cpu", "ph": "X", "pid": 0, "tid": )"
+           << buffer->threadIndex << ", \"ts\": "
+           << static_cast<double>(event.start - startReference.ticks) * microsecondsPerTick
+           << ", \"dur\": " << static_cast<double>(event.end - event.start) * microsecondsPerTick << "}";
+    }
+  }
+  file << "\n]}\n";
+  return true;
+}
@@ -0,0 +1,97 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PROFILER_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_RDTSC
+#endif
+
+#ifdef ENABLE_PROFILER
+constexpr bool PROFILER_ENABLED = true;
+#else
+constexpr bool PROFILER_ENABLED = false;
+#endif
+
+/** Zones kept per thread. Once full, the oldest ones are overwritten. */
+constexpr uint32_t PROFILER_RING_SIZE = 1 << 16;
+
+/**
+ * CPU profiler recording timed zones.
+ *
+ * Each thread writes its zones in its own ring buffer, without locks: the only synchronization is the
+ * release store of the head of the ring, read by the export. Timestamps come from rdtsc when available,
+ * and are converted to microseconds when the trace is written, in the Chrome trace_event format.
+ *
+ * The zones are placed with PROFILE_ZONE and PROFILE_FUNCTION, which expand to nothing when ENABLE_PROFILER
+ * isn't defined.
+ */
+class Profiler {
+private:
+  static std::atomic<bool> _recording;
+  static std::atomic<uint64_t> _recordingStart;
+
+public:
+  /** Timestamp, in ticks of the counter used by the profiler */
+  static uint64_t Now() {
+#ifdef PROFILER_RDTSC
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+  }
+
+  static bool IsRecording() { return _recording.load(std::memory_order_relaxed); }
+  /** Adds a zone to the ring of the calling thread */
+  static void Record(const char *name, uint64_t start, uint64_t end);
+  /** Name of the calling thread in the trace */
+  static void SetThreadName(const char *name);
+
+  /** Starts a new capture. The zones recorded before it are left out of the trace. */
+  static void StartRecording();
+  static void StopRecording();
+  /** Writes the zones of the current or last capture that are still in the rings */
+  static bool WriteChromeTrace(const char *path);
+};
+
+/** Times the scope it lives in */
+class ProfileZone {
+private:
+  const char *_name;
+  uint64_t _start;
+
+public:
+  /** @param name must outlive the profiler, like a string literal */
+  explicit ProfileZone(const char *name) : _name(name), _start(Profiler::Now()) {}
+  ~ProfileZone() {
+    if (Profiler::IsRecording()) {
+      Profiler::Record(_name, _start, Profiler::Now());
+    }
+  }
+
+  ProfileZone(const ProfileZone &) = delete;
+  ProfileZone &operator=(const ProfileZone &) = delete;
+};
+
+#ifdef ENABLE_PROFILER
+#define PROFILER_CONCAT_IMPL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_IMPL(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILER_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_ZONE(__func__)
+#define PROFILE_THREAD(name) Profiler::SetThreadName(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
@@ -0,0 +1,653 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "RenderGraph.h"
+#include "vk_init.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+bool IsDepthFormat(vk::Format format) {
+  switch (format) {
+  case vk::Format::eD16Unorm:
+  case vk::Format::eD32Sfloat:
+  case vk::Format::eD16UnormS8Uint:
+  case vk::Format::eD24UnormS8Uint:
+  case vk::Format::eD32SfloatS8Uint:
+    return true;
+  default:
+    return false;
+  }
+}
+
+vk::ImageAspectFlags GetAspectFlags(vk::Format format) {
+  return IsDepthFormat(format) ? vk::ImageAspectFlagBits::eDepth : vk::ImageAspectFlagBits::eColor;
+}
+
+constexpr vk::PipelineStageFlags DEPTH_ATTACHMENT_STAGES =
+    vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+} // namespace
+
+// ==== Pass builder ====
+
+RenderGraph::PassBuilder::PassBuilder(RenderGraph *graph, uint32_t passIndex)
+    : _graph(graph), _passIndex(passIndex) {}
+
+RenderGraph::PassBuilder RenderGraph::PassBuilder::AddColorAttachment(Resource image,
+                                                                      vk::AttachmentLoadOp loadOp) {
+  Pass &pass = _graph->_passes[_passIndex];
+  pass.colorAttachments.push_back(image);
+  pass.colorLoadOps.push_back(loadOp);
+
+  // Loaded attachments are read as well, which keeps their previous writers
+  vk::AccessFlags access = vk::AccessFlagBits::eColorAttachmentWrite;
+  if (loadOp == vk::AttachmentLoadOp::eLoad) {
+    access |= vk::AccessFlagBits::eColorAttachmentRead;
+  }
+  _graph->AddUse(_passIndex, image,
+                 Access{
+                     .stage = vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                     .access = access,
+                     .layout = vk::ImageLayout::eColorAttachmentOptimal,
+                 },
+                 true);
+  _graph->_resources[image].usage |= vk::ImageUsageFlagBits::eColorAttachment;
+  return *this;
+}
+
+RenderGraph::PassBuilder RenderGraph::PassBuilder::SetDepthAttachment(Resource image,
+                                                                      vk::AttachmentLoadOp loadOp) {
+  Pass &pass = _graph->_passes[_passIndex];
+  pass.depthAttachment = image;
+  pass.depthLoadOp = loadOp;
+
+  _graph->AddUse(_passIndex, image,
+                 Access{
+                     .stage = DEPTH_ATTACHMENT_STAGES,
+                     .access = vk::AccessFlagBits::eDepthStencilAttachmentRead |
+                               vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+                     .layout = vk::ImageLayout::eDepthStencilAttachmentOptimal,
+                 },
+                 true);
+  _graph->_resources[image].usage |= vk::ImageUsageFlagBits::eDepthStencilAttachment;
+  return *this;
+}
+
+RenderGraph::PassBuilder RenderGraph::PassBuilder::ReadImage(Resource image, vk::PipelineStageFlags stage,
+                                                             vk::ImageLayout layout) {
+  _graph->AddUse(_passIndex, image,
+                 Access{
+                     .stage = stage,
+                     .access = vk::AccessFlagBits::eShaderRead,
+                     .layout = layout,
+                 },
+                 false);
+  _graph->_resources[image].usage |= vk::ImageUsageFlagBits::eSampled;
+  return *this;
+}
+
+RenderGraph::PassBuilder RenderGraph::PassBuilder::WriteImage(Resource image, vk::PipelineStageFlags stage) {
+  _graph->AddUse(_passIndex, image,
+                 Access{
+                     .stage = stage,
+                     .access = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+                     .layout = vk::ImageLayout::eGeneral,
+                 },
+                 true);
+  _graph->_resources[image].usage |= vk::ImageUsageFlagBits::eStorage;
+  return *this;
+}
+
+RenderGraph::PassBuilder RenderGraph::PassBuilder::ReadBuffer(Resource buffer, vk::PipelineStageFlags stage,
+                                                              vk::AccessFlags access) {
+  _graph->AddUse(_passIndex, buffer, Access{.stage = stage, .access = access}, false);
+  return *this;
+}
+
+RenderGraph::PassBuilder RenderGraph::PassBuilder::WriteBuffer(Resource buffer, vk::PipelineStageFlags stage,
+                                                               vk::AccessFlags access) {
+  _graph->AddUse(_passIndex, buffer, Access{.stage = stage, .access = access}, true);
+  return *this;
+}
+
+RenderGraph::PassBuilder RenderGraph::PassBuilder::SetExecute(ExecuteFunction execute) {
+  _graph->_passes[_passIndex].execute = std::move(execute);
+  return *this;
+}
+
+// ==== Declaration ====
+
+RenderGraph::Resource RenderGraph::CreateImage(const std::string &name, vk::Format format,
+                                               vk::Extent2D extent, uint32_t mipLevels) {
+  _resources.push_back(ResourceData{
+      .name = name,
+      .isImage = true,
+      .format = format,
+      .extent = extent,
+      .mipLevels = mipLevels,
+  });
+  return static_cast<Resource>(_resources.size() - 1);
+}
+
+RenderGraph::Resource RenderGraph::ImportImage(const std::string &name, vk::Format format,
+                                               vk::Extent2D extent, const Access &initialAccess,
+                                               vk::ImageLayout finalLayout) {
+  _resources.push_back(ResourceData{
+      .name = name,
+      .isImage = true,
+      .imported = true,
+      .format = format,
+      .extent = extent,
+      .finalLayout = finalLayout,
+      .initialState{
+          .layout = initialAccess.layout,
+          .writeStage = initialAccess.stage,
+          .writeAccess = initialAccess.access,
+      },
+  });
+  return static_cast<Resource>(_resources.size() - 1);
+}
+
+RenderGraph::Resource RenderGraph::AddBuffer(const std::string &name, bool imported,
+                                             const Access &initialAccess) {
+  _resources.push_back(ResourceData{
+      .name = name,
+      .imported = imported,
+      .initialState{
+          .writeStage = initialAccess.stage,
+          .writeAccess = initialAccess.access,
+      },
+  });
+  return static_cast<Resource>(_resources.size() - 1);
+}
+
+RenderGraph::PassBuilder RenderGraph::AddPass(const std::string &name, PassType type) {
+  if (_compiled)
+    throw std::runtime_error("Passes can't be added to a compiled render graph");
+
+  _passes.push_back(Pass{
+      .name = name,
+      .type = type,
+  });
+  return PassBuilder(this, static_cast<uint32_t>(_passes.size() - 1));
+}
+
+void RenderGraph::AddUse(uint32_t passIndex, Resource resource, const Access &access, bool write) {
+  Pass &pass = _passes[passIndex];
+
+  // A pass can only wait for the previous ones: several uses of a resource in a pass are merged
+  for (auto &use : pass.uses) {
+    if (use.resource != resource)
+      continue;
+    if (_resources[resource].isImage && use.access.layout != access.layout)
+      throw std::runtime_error("Image " + _resources[resource].name + " is used with two layouts in pass " +
+                               pass.name);
+    use.access.stage |= access.stage;
+    use.access.access |= access.access;
+    use.write = use.write || write;
+    return;
+  }
+  pass.uses.push_back(ResourceUse{
+      .resource = resource,
+      .access = access,
+      .write = write,
+  });
+}
+
+bool RenderGraph::Discards(const Pass &pass, Resource resource) {
+  if (pass.depthAttachment == resource)
+    return pass.depthLoadOp != vk::AttachmentLoadOp::eLoad;
+  for (uint32_t i = 0; i < pass.colorAttachments.size(); i++) {
+    if (pass.colorAttachments[i] == resource)
+      return pass.colorLoadOps[i] != vk::AttachmentLoadOp::eLoad;
+  }
+  return false;
+}
+
+// ==== Compilation ====
+
+void RenderGraph::Compile(vk::Device device, VmaAllocator allocator, MemoryTracker *memoryTracker) {
+  _device = device;
+  _allocator = allocator;
+  _memoryTracker = memoryTracker;
+
+  CullPasses();
+  ComputeLifetimes();
+  CreateImages();
+  for (auto &pass : _passes) {
+    if (!pass.culled && pass.type == PassType::eGraphics) {
+      CreateRenderPass(pass);
+    }
+  }
+  _compiled = true;
+}
+
+void RenderGraph::CullPasses() {
+  // Going backwards, a pass is needed if it writes an imported resource or a resource used by a needed pass
+  std::vector<bool> neededResources(_resources.size(), false);
+  for (auto pass = _passes.rbegin(); pass != _passes.rend(); pass++) {
+    pass->culled = std::none_of(pass->uses.begin(), pass->uses.end(), [&](const ResourceUse &use) {
+      return use.write && (_resources[use.resource].imported || neededResources[use.resource]);
+    });
+    if (pass->culled)
+      continue;
+
+    // Previous writers are needed unless the content is discarded
+    for (const auto &use : pass->uses) {
+      neededResources[use.resource] = !Discards(*pass, use.resource);
+    }
+  }
+}
+
+void RenderGraph::ComputeLifetimes() {
+  for (uint32_t p = 0; p < _passes.size(); p++) {
+    const Pass &pass = _passes[p];
+    if (pass.culled)
+      continue;
+    for (const auto &use : pass.uses) {
+      ResourceData &resource = _resources[use.resource];
+      if (!resource.firstUse) {
+        resource.firstUse = p;
+      }
+      resource.lastUse = p;
+      resource.lastAccess = use.access;
+      if (!use.write) {
+        resource.lastAccess.access = {};
+      }
+    }
+  }
+}
+
+void RenderGraph::CreateImages() {
+  std::vector<Resource> aliasedImages;
+  for (Resource r = 0; r < _resources.size(); r++) {
+    ResourceData &resource = _resources[r];
+    if (!resource.isImage || resource.imported || !resource.firstUse)
+      continue;
+
+    // Attachments that live in a single render pass never leave the tile memory of the GPUs that have one
+    const vk::ImageUsageFlags attachmentUsage =
+        vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment;
+    const bool attachmentOnly = !(resource.usage & ~attachmentUsage);
+    resource.transient = attachmentOnly && *resource.firstUse == resource.lastUse;
+    if (resource.transient) {
+      resource.usage |= vk::ImageUsageFlagBits::eTransientAttachment;
+    }
+
+    auto imageCreateInfo = vkinit::ImageCreateInfo(
+        resource.format, resource.usage,
+        vk::Extent3D{.width = resource.extent.width, .height = resource.extent.height, .depth = 1},
+        resource.mipLevels);
+    if (resource.transient) {
+      // Use lazily allocated memory if there is some, regular memory otherwise
+      VmaAllocationCreateInfo allocationCreateInfo{
+          .usage = VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED,
+      };
+      VkResult result =
+          vmaCreateImage(_allocator, (VkImageCreateInfo *)&imageCreateInfo, &allocationCreateInfo,
+                         (VkImage *)&resource.image, &resource.allocation, nullptr);
+      if (result != VK_SUCCESS) {
+        allocationCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+        vmaCreateImage(_allocator, (VkImageCreateInfo *)&imageCreateInfo, &allocationCreateInfo,
+                       (VkImage *)&resource.image, &resource.allocation, nullptr);
+      }
+      if (_memoryTracker) {
+        _memoryTracker->Track(resource.allocation, MemoryCategory::eAttachments);
+      }
+    } else {
+      resource.image = _device.createImage(imageCreateInfo);
+      aliasedImages.push_back(r);
+    }
+  }
+
+  // Put the biggest images first in the memory slots, and the smaller ones in the slots they fit in, as long
+  // as their lifetimes don't overlap with the ones already there
+  std::vector<vk::MemoryRequirements> requirements(_resources.size());
+  for (Resource r : aliasedImages) {
+    requirements[r] = _device.getImageMemoryRequirements(_resources[r].image);
+  }
+  std::sort(aliasedImages.begin(), aliasedImages.end(),
+            [&](Resource a, Resource b) { return requirements[a].size > requirements[b].size; });
+  for (Resource r : aliasedImages) {
+    const ResourceData &resource = _resources[r];
+    auto slot = std::find_if(_memorySlots.begin(), _memorySlots.end(), [&](const MemorySlot &candidate) {
+      if (!(candidate.requirements.memoryTypeBits & requirements[r].memoryTypeBits))
+        return false;
+      return std::none_of(candidate.images.begin(), candidate.images.end(), [&](Resource other) {
+        const ResourceData &otherResource = _resources[other];
+        return *otherResource.firstUse <= resource.lastUse && *resource.firstUse <= otherResource.lastUse;
+      });
+    });
+    if (slot == _memorySlots.end()) {
+      _memorySlots.push_back(MemorySlot{.requirements = requirements[r]});
+      slot = _memorySlots.end() - 1;
+    }
+    slot->requirements.size = std::max(slot->requirements.size, requirements[r].size);
+    slot->requirements.alignment = std::max(slot->requirements.alignment, requirements[r].alignment);
+    slot->requirements.memoryTypeBits &= requirements[r].memoryTypeBits;
+    slot->images.push_back(r);
+  }
+
+  for (auto &slot : _memorySlots) {
+    VmaAllocationCreateInfo allocationCreateInfo{
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+    };
+    VkMemoryRequirements slotRequirements = slot.requirements;
+    if (vmaAllocateMemory(_allocator, &slotRequirements, &allocationCreateInfo, &slot.allocation, nullptr) !=
+        VK_SUCCESS)
+      throw std::runtime_error("Unable to allocate the memory of the render graph images");
+    if (_memoryTracker) {
+      _memoryTracker->Track(slot.allocation, MemoryCategory::eAttachments);
+    }
+
+    std::sort(slot.images.begin(), slot.images.end(),
+              [&](Resource a, Resource b) { return *_resources[a].firstUse < *_resources[b].firstUse; });
+    for (uint32_t i = 0; i < slot.images.size(); i++) {
+      ResourceData &resource = _resources[slot.images[i]];
+      vmaBindImageMemory(_allocator, slot.allocation, resource.image);
+
+      // The memory is used by the previous image of the slot, or by the last one in the previous frame
+      const size_t previousIndex = (i + slot.images.size() - 1) % slot.images.size();
+      const ResourceData &previous = _resources[slot.images[previousIndex]];
+      resource.initialState.writeStage = previous.lastAccess.stage;
+      resource.initialState.writeAccess = previous.lastAccess.access;
+    }
+  }
+
+  // Transient images only wait for their own use in the previous frame
+  for (auto &resource : _resources) {
+    if (resource.transient) {
+      resource.initialState.writeStage = resource.lastAccess.stage;
+      resource.initialState.writeAccess = resource.lastAccess.access;
+    }
+    if (resource.image && !resource.imported) {
+      resource.view = _device.createImageView(vkinit::ImageViewCreateInfo(
+          resource.format, resource.image, GetAspectFlags(resource.format), resource.mipLevels));
+    }
+  }
+}
+
+void RenderGraph::CreateRenderPass(Pass &pass) {
+  std::vector<vk::AttachmentDescription> attachments;
+  std::vector<vk::AttachmentReference> colorReferences;
+  auto addAttachment = [&](Resource image, vk::AttachmentLoadOp loadOp, vk::ImageLayout layout) {
+    const ResourceData &resource = _resources[image];
+    // The content is only stored if someone uses it later
+    const bool store = resource.imported || resource.lastUse > static_cast<uint32_t>(&pass - _passes.data());
+    // Layout transitions are done by the barriers of the graph
+    attachments.push_back(vk::AttachmentDescription{
+        .format = resource.format,
+        .samples = vk::SampleCountFlagBits::e1,
+        .loadOp = loadOp,
+        .storeOp = store ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare,
+        .stencilLoadOp = vk::AttachmentLoadOp::eDontCare,
+        .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
+        .initialLayout = layout,
+        .finalLayout = layout,
+    });
+    pass.extent = resource.extent;
+  };
+
+  for (uint32_t i = 0; i < pass.colorAttachments.size(); i++) {
+    addAttachment(pass.colorAttachments[i], pass.colorLoadOps[i], vk::ImageLayout::eColorAttachmentOptimal);
+    colorReferences.push_back(vk::AttachmentReference{
+        .attachment = i,
+        .layout = vk::ImageLayout::eColorAttachmentOptimal,
+    });
+  }
+  vk::AttachmentReference depthReference{
+      .attachment = static_cast<uint32_t>(pass.colorAttachments.size()),
+      .layout = vk::ImageLayout::eDepthStencilAttachmentOptimal,
+  };
+  if (pass.depthAttachment) {
+    addAttachment(*pass.depthAttachment, pass.depthLoadOp, vk::ImageLayout::eDepthStencilAttachmentOptimal);
+  }
+
+  vk::SubpassDescription subpass{
+      .pipelineBindPoint = vk::PipelineBindPoint::eGraphics,
+      .colorAttachmentCount = static_cast<uint32_t>(colorReferences.size()),
+      .pColorAttachments = colorReferences.data(),
+      .pDepthStencilAttachment = pass.depthAttachment ? &depthReference : nullptr,
+  };
+  vk::RenderPassCreateInfo renderPassCreateInfo{
+      .attachmentCount = static_cast<uint32_t>(attachments.size()),
+      .pAttachments = attachments.data(),
+      .subpassCount = 1,
+      .pSubpasses = &subpass,
+  };
+  pass.renderPass = _device.createRenderPass(renderPassCreateInfo);
+}
+
+// ==== Execution ====
+
+void RenderGraph::Execute(vk::CommandBuffer cmd) {
+  std::vector<ResourceState> states(_resources.size());
+  for (uint32_t r = 0; r < _resources.size(); r++) {
+    states[r] = _resources[r].initialState;
+  }
+
+  for (auto &pass : _passes) {
+    if (pass.culled)
+      continue;
+
+    RecordBarriers(pass, states, cmd);
+
+    if (pass.type == PassType::eCompute) {
+      if (pass.execute) {
+        pass.execute(cmd);
+      }
+      continue;
+    }
+
+    std::vector<vk::ClearValue> clearValues;
+    for (Resource image : pass.colorAttachments) {
+      clearValues.push_back(_resources[image].clearValue);
+    }
+    if (pass.depthAttachment) {
+      clearValues.push_back(_resources[*pass.depthAttachment].clearValue);
+    }
+    vk::RenderPassBeginInfo renderPassBeginInfo{
+        .renderPass = pass.renderPass,
+        .framebuffer = GetFramebuffer(pass),
+        .renderArea =
+            {
+                .offset = {.x = 0, .y = 0},
+                .extent = pass.extent,
+            },
+        .clearValueCount = static_cast<uint32_t>(clearValues.size()),
+        .pClearValues = clearValues.data(),
+    };
+    cmd.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eInline);
+    if (pass.execute) {
+      pass.execute(cmd);
+    }
+    cmd.endRenderPass();
+  }
+
+  // Leave the imported images in the layout expected by their next user, like the presentation engine
+  std::vector<vk::ImageMemoryBarrier> finalBarriers;
+  vk::PipelineStageFlags srcStages;
+  for (uint32_t r = 0; r < _resources.size(); r++) {
+    const ResourceData &resource = _resources[r];
+    if (!resource.imported || !resource.isImage || resource.finalLayout == vk::ImageLayout::eUndefined ||
+        resource.finalLayout == states[r].layout)
+      continue;
+
+    srcStages |= states[r].writeStage | states[r].readStages;
+    finalBarriers.push_back(vk::ImageMemoryBarrier{
+        .srcAccessMask = states[r].writeAccess,
+        .dstAccessMask = {},
+        .oldLayout = states[r].layout,
+        .newLayout = resource.finalLayout,
+        .image = resource.image,
+        .subresourceRange{
+            .aspectMask = GetAspectFlags(resource.format),
+            .baseMipLevel = 0,
+            .levelCount = VK_REMAINING_MIP_LEVELS,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+    });
+  }
+  if (!finalBarriers.empty()) {
+    if (!srcStages) {
+      srcStages = vk::PipelineStageFlagBits::eTopOfPipe;
+    }
+    cmd.pipelineBarrier(srcStages, vk::PipelineStageFlagBits::eBottomOfPipe, {}, nullptr, nullptr,
+                        finalBarriers);
+  }
+}
+
+void RenderGraph::RecordBarriers(const Pass &pass, std::vector<ResourceState> &states,
+                                 vk::CommandBuffer cmd) const {
+  std::vector<vk::ImageMemoryBarrier> imageBarriers;
+  vk::MemoryBarrier memoryBarrier;
+  vk::PipelineStageFlags srcStages;
+  vk::PipelineStageFlags dstStages;
+
+  for (const auto &use : pass.uses) {
+    const ResourceData &resource = _resources[use.resource];
+    ResourceState &state = states[use.resource];
+    const bool layoutChange = resource.isImage && use.access.layout != state.layout;
+
+    vk::PipelineStageFlags waitedStages;
+    if (use.write || layoutChange) {
+      // Wait for the last write and for the reads that followed it
+      waitedStages = state.writeStage | state.readStages;
+    } else if (state.writeStage && (use.access.stage & ~state.readStages)) {
+      // First read of the last write in these stages
+      waitedStages = state.writeStage;
+    } else {
+      continue;
+    }
+
+    const bool discard = Discards(pass, use.resource);
+    if (resource.isImage) {
+      imageBarriers.push_back(vk::ImageMemoryBarrier{
+          .srcAccessMask = state.writeAccess,
+          .dstAccessMask = use.access.access,
+          .oldLayout = discard ? vk::ImageLayout::eUndefined : state.layout,
+          .newLayout = use.access.layout,
+          .image = resource.image,
+          .subresourceRange{
+              .aspectMask = GetAspectFlags(resource.format),
+              .baseMipLevel = 0,
+              .levelCount = VK_REMAINING_MIP_LEVELS,
+              .baseArrayLayer = 0,
+              .layerCount = 1,
+          },
+      });
+    } else {
+      memoryBarrier.srcAccessMask |= state.writeAccess;
+      memoryBarrier.dstAccessMask |= use.access.access;
+    }
+    srcStages |= waitedStages ? waitedStages : vk::PipelineStageFlagBits::eTopOfPipe;
+    dstStages |= use.access.stage;
+
+    // Update the state. A layout transition counts as a write, done before the stages of the use.
+    state.layout = resource.isImage ? use.access.layout : state.layout;
+    if (use.write) {
+      state.writeStage = use.access.stage;
+      state.writeAccess = use.access.access;
+      state.readStages = {};
+    } else if (layoutChange) {
+      state.writeStage = use.access.stage;
+      state.writeAccess = {};
+      state.readStages = use.access.stage;
+    } else {
+      state.readStages |= use.access.stage;
+    }
+  }
+
+  if (!dstStages)
+    return;
+  const bool hasMemoryBarrier = memoryBarrier.srcAccessMask || memoryBarrier.dstAccessMask;
+  cmd.pipelineBarrier(srcStages, dstStages, {}, hasMemoryBarrier ? 1 : 0, &memoryBarrier, 0, nullptr,
+                      static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+}
+
+vk::Framebuffer RenderGraph::GetFramebuffer(Pass &pass) {
+  std::vector<VkImageView> views;
+  for (Resource image : pass.colorAttachments) {
+    views.push_back(_resources[image].view);
+  }
+  if (pass.depthAttachment) {
+    views.push_back(_resources[*pass.depthAttachment].view);
+  }
+
+  auto framebuffer = pass.framebuffers.find(views);
+  if (framebuffer != pass.framebuffers.end())
+    return framebuffer->second;
+
+  vk::FramebufferCreateInfo framebufferCreateInfo{
+      .renderPass = pass.renderPass,
+      .attachmentCount = static_cast<uint32_t>(views.size()),
+      .pAttachments = reinterpret_cast<const vk::ImageView *>(views.data()),
+      .width = pass.extent.width,
+      .height = pass.extent.height,
+      .layers = 1,
+  };
+  vk::Framebuffer newFramebuffer = _device.createFramebuffer(framebufferCreateInfo);
+  pass.framebuffers[views] = newFramebuffer;
+  return newFramebuffer;
+}
+
+void RenderGraph::Destroy() {
+  for (auto &pass : _passes) {
+    for (auto &[views, framebuffer] : pass.framebuffers) {
+      _device.destroyFramebuffer(framebuffer);
+    }
+    if (pass.renderPass) {
+      _device.destroyRenderPass(pass.renderPass);
+    }
+  }
+  for (auto &resource : _resources) {
+    if (resource.imported || !resource.image)
+      continue;
+    _device.destroyImageView(resource.view);
+    if (resource.allocation) {
+      if (_memoryTracker) {
+        _memoryTracker->Untrack(resource.allocation);
+      }
+      vmaDestroyImage(_allocator, resource.image, resource.allocation);
+    } else {
+      _device.destroyImage(resource.image);
+    }
+  }
+  for (auto &slot : _memorySlots) {
+    if (_memoryTracker) {
+      _memoryTracker->Untrack(slot.allocation);
+    }
+    vmaFreeMemory(_allocator, slot.allocation);
+  }
+}
+
+// ==== Accessors ====
+
+void RenderGraph::SetImportedImage(Resource image, vk::Image handle, vk::ImageView view) {
+  _resources[image].image = handle;
+  _resources[image].view = view;
+}
+
+void RenderGraph::SetClearValue(Resource image, vk::ClearValue clearValue) {
+  _resources[image].clearValue = clearValue;
+}
+
+vk::ImageView RenderGraph::GetImageView(Resource image) const { return _resources[image].view; }
+
+vk::RenderPass RenderGraph::GetRenderPass(const std::string &passName) const {
+  for (const auto &pass : _passes) {
+    if (pass.name == passName)
+      return pass.renderPass;
+  }
+  return nullptr;
+}
+
+bool RenderGraph::IsCulled(const std::string &passName) const {
+  for (const auto &pass : _passes) {
+    if (pass.name == passName)
+      return pass.culled;
+  }
+  return true;
+}
@@ -0,0 +1,191 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include "MemoryTracker.h"
+#include "vk_types.h"
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * Describes the passes of a frame with the resources they read and write, then records them with the barriers
+ * and layout transitions they need.
+ *
+ * - Passes whose results are never used are culled.
+ * - Images owned by the graph are created from the way they are used. Attachments only used inside of one
+ *   render pass are transient: their content is never stored, and they are lazily allocated if possible.
+ *   Other images share memory when their lifetimes don't overlap.
+ * - Imported resources live outside of the graph, like the swapchain images or buffers kept between frames.
+ *   Their content is always kept.
+ *
+ * Buffers are only tracked to synchronize their accesses: passes bind the actual buffers themselves.
+ */
+class RenderGraph {
+public:
+  using Resource = uint32_t;
+  using ExecuteFunction = std::function<void(vk::CommandBuffer)>;
+
+  enum class PassType {
+    /** Recorded inside of a render pass created from its attachments */
+    eGraphics,
+    eCompute,
+  };
+
+  /** Way a resource is accessed. The layout is ignored for buffers. */
+  struct Access {
+    vk::PipelineStageFlags stage;
+    vk::AccessFlags access;
+    vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+  };
+
+  /** Declares the resources used by a pass */
+  class PassBuilder {
+  private:
+    RenderGraph *_graph;
+    uint32_t _passIndex;
+
+  public:
+    PassBuilder(RenderGraph *graph, uint32_t passIndex);
+
+    /**
+     * @param loadOp eLoad keeps the previous content of the attachment, eClear uses the clear value of the
+     * image
+     */
+    PassBuilder AddColorAttachment(Resource image, vk::AttachmentLoadOp loadOp);
+    PassBuilder SetDepthAttachment(Resource image, vk::AttachmentLoadOp loadOp);
+    /** Reads an image with a sampler */
+    PassBuilder ReadImage(Resource image, vk::PipelineStageFlags stage,
+                          vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal);
+    /** Writes an image as a storage image, in the general layout */
+    PassBuilder WriteImage(Resource image, vk::PipelineStageFlags stage);
+    PassBuilder ReadBuffer(Resource buffer, vk::PipelineStageFlags stage, vk::AccessFlags access);
+    PassBuilder WriteBuffer(Resource buffer, vk::PipelineStageFlags stage, vk::AccessFlags access);
+    PassBuilder SetExecute(ExecuteFunction execute);
+  };
+
+private:
+  struct ResourceUse {
+    Resource resource;
+    Access access;
+    bool write;
+  };
+
+  struct Pass {
+    std::string name;
+    PassType type;
+    std::vector<ResourceUse> uses;
+    std::vector<Resource> colorAttachments;
+    std::vector<vk::AttachmentLoadOp> colorLoadOps;
+    std::optional<Resource> depthAttachment;
+    vk::AttachmentLoadOp depthLoadOp = vk::AttachmentLoadOp::eDontCare;
+    ExecuteFunction execute;
+
+    bool culled = false;
+    vk::RenderPass renderPass = nullptr;
+    vk::Extent2D extent;
+    /** Framebuffers for each combination of image views, since imported images can change every frame */
+    std::map<std::vector<VkImageView>, vk::Framebuffer> framebuffers;
+  };
+
+  /** Synchronization state of a resource while the passes are recorded */
+  struct ResourceState {
+    vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+    /** Last write, or last layout transition */
+    vk::PipelineStageFlags writeStage;
+    vk::AccessFlags writeAccess;
+    /** Stages that can see the last write */
+    vk::PipelineStageFlags readStages;
+  };
+
+  struct ResourceData {
+    std::string name;
+    bool isImage = false;
+    bool imported = false;
+
+    // Images
+    vk::Format format = vk::Format::eUndefined;
+    vk::Extent2D extent;
+    uint32_t mipLevels = 1;
+    vk::ImageUsageFlags usage;
+    vk::ClearValue clearValue;
+    /** Layout of an imported image at the end of the graph, or undefined to leave it as is */
+    vk::ImageLayout finalLayout = vk::ImageLayout::eUndefined;
+    vk::Image image = nullptr;
+    vk::ImageView view = nullptr;
+    /** Own allocation of transient images. The other ones are bound to a memory slot */
+    VmaAllocation allocation = nullptr;
+    bool transient = false;
+
+    /** State at the start of the graph */
+    ResourceState initialState;
+    /** Lifetime, in indices of passes that are not culled */
+    std::optional<uint32_t> firstUse;
+    uint32_t lastUse = 0;
+    Access lastAccess;
+  };
+
+  /** Memory shared by images that are never used at the same time */
+  struct MemorySlot {
+    VmaAllocation allocation = nullptr;
+    vk::MemoryRequirements requirements;
+    /** Images sorted by first use */
+    std::vector<Resource> images;
+  };
+
+  vk::Device _device = nullptr;
+  VmaAllocator _allocator = nullptr;
+  MemoryTracker *_memoryTracker = nullptr;
+  std::vector<Pass> _passes;
+  std::vector<ResourceData> _resources;
+  std::vector<MemorySlot> _memorySlots;
+  bool _compiled = false;
+
+  void AddUse(uint32_t passIndex, Resource resource, const Access &access, bool write);
+  /** Does the pass overwrite the whole resource without reading it ? */
+  static bool Discards(const Pass &pass, Resource resource);
+  void CullPasses();
+  void ComputeLifetimes();
+  void CreateImages();
+  void CreateRenderPass(Pass &pass);
+  vk::Framebuffer GetFramebuffer(Pass &pass);
+  void RecordBarriers(const Pass &pass, std::vector<ResourceState> &states, vk::CommandBuffer cmd) const;
+
+public:
+  /** Declares an image created and owned by the graph */
+  Resource CreateImage(const std::string &name, vk::Format format, vk::Extent2D extent,
+                       uint32_t mipLevels = 1);
+  /**
+   * Declares an image that lives outside of the graph. Its handles can change at every frame.
+   * @param initialAccess last access to the image before the graph
+   * @param finalLayout layout to put the image in at the end of the graph, or undefined to leave it as is
+   */
+  Resource ImportImage(const std::string &name, vk::Format format, vk::Extent2D extent,
+                       const Access &initialAccess,
+                       vk::ImageLayout finalLayout = vk::ImageLayout::eUndefined);
+  /** Declares a buffer. Imported buffers are kept after the graph, and so are the passes writing them */
+  Resource AddBuffer(const std::string &name, bool imported, const Access &initialAccess = {});
+  PassBuilder AddPass(const std::string &name, PassType type);
+
+  /**
+   * Culls the passes, creates the images and the render passes. The graph can't be modified afterwards.
+   * @param memoryTracker if not null, the memory of the images is tracked as attachments
+   */
+  void Compile(vk::Device device, VmaAllocator allocator, MemoryTracker *memoryTracker = nullptr);
+  /** Records every pass that is not culled */
+  void Execute(vk::CommandBuffer cmd);
+  /** Destroys everything created by Compile */
+  void Destroy();
+
+  void SetImportedImage(Resource image, vk::Image handle, vk::ImageView view);
+  void SetClearValue(Resource image, vk::ClearValue clearValue);
+
+  [[nodiscard]] vk::ImageView GetImageView(Resource image) const;
+  /** Render pass of a graphics pass, to create compatible pipelines */
+  [[nodiscard]] vk::RenderPass GetRenderPass(const std::string &passName) const;
+  [[nodiscard]] bool IsCulled(const std::string &passName) const;
+};
@@ -0,0 +1,24 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "RenderStats.h"
+
+void RenderStatsHistory::Push(const RenderStats &stats) {
+  _frames[_next] = stats;
+  _next = (_next + 1) % RENDER_STATS_HISTORY_SIZE;
+  if (_size < RENDER_STATS_HISTORY_SIZE)
+    _size++;
+}
+
+size_t RenderStatsHistory::GetSize() const { return _size; }
+
+const RenderStats &RenderStatsHistory::Get(size_t index) const {
+  // Once the history is full, the oldest frame is the one about to be overwritten
+  const size_t oldest = _size < RENDER_STATS_HISTORY_SIZE ? 0 : _next;
+  return _frames[(oldest + index) % RENDER_STATS_HISTORY_SIZE];
+}
+
+const RenderStats &RenderStatsHistory::GetLatest() const {
+  return _frames[(_next + RENDER_STATS_HISTORY_SIZE - 1) % RENDER_STATS_HISTORY_SIZE];
+}
@@ -0,0 +1,79 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/** Frames kept in the history of the render stats */
+constexpr uint32_t RENDER_STATS_HISTORY_SIZE = 240;
+
+/** Work done by the CPU to render a frame, counted while it is recorded */
+struct RenderStats {
+  uint32_t drawCalls = 0;
+  /** Instances drawn by all the draw calls. Indirect draws count their maximum instance count. */
+  uint32_t instances = 0;
+  /** Triangles of the submitted draws, before the GPU culling */
+  uint64_t triangles = 0;
+  uint32_t pipelineBinds = 0;
+  uint32_t descriptorBinds = 0;
+  uint32_t vertexBufferBinds = 0;
+  uint32_t pushConstantCalls = 0;
+  /** Bytes written by the CPU in GPU visible memory: object data, uniforms, draw commands and overlay */
+  uint64_t bytesUploaded = 0;
+  /** Objects sent to the GPU, and objects hidden by the CPU culling. The GPU culling is not read back. */
+  uint32_t visibleObjects = 0;
+  uint32_t culledObjects = 0;
+
+  /** Time spent recording and submitting the frame, in milliseconds */
+  float cpuTime = 0.0f;
+  /**
+   * Time between the first and the last command of the frame on the GPU, in milliseconds. 0 if unknown.
+   * It is read when the frame slot is reused, so it is the one of the frame FRAME_OVERLAP frames earlier.
+   */
+  float gpuTime = 0.0f;
+};
+
+/** Rolling history of the stats of the last frames */
+class RenderStatsHistory {
+private:
+  std::array<RenderStats, RENDER_STATS_HISTORY_SIZE> _frames{};
+  /** Slot of the next frame, and number of frames kept */
+  uint32_t _next = 0;
+  uint32_t _size = 0;
+
+public:
+  void Push(const RenderStats &stats);
+
+  [[nodiscard]] size_t GetSize() const;
+  /** Stats of a kept frame, from 0 for the oldest to GetSize() - 1 for the latest */
+  [[nodiscard]] const RenderStats &Get(size_t index) const;
+  /** Stats of the last complete frame. Zeroes if no frame is complete yet. */
+  [[nodiscard]] const RenderStats &GetLatest() const;
+
+  /** Largest and mean value of a counter over the kept frames */
+  template <class T> [[nodiscard]] T GetMax(T RenderStats::*counter) const;
+  template <class T> [[nodiscard]] double GetAverage(T RenderStats::*counter) const;
+};
+
+template <class T> T RenderStatsHistory::GetMax(T RenderStats::*counter) const {
+  T max{};
+  for (size_t i = 0; i < _size; i++) {
+    if (_frames[i].*counter > max)
+      max = _frames[i].*counter;
+  }
+  return max;
+}
+
+template <class T> double RenderStatsHistory::GetAverage(T RenderStats::*counter) const {
+  if (_size == 0)
+    return 0.0;
+  double sum = 0.0;
+  for (size_t i = 0; i < _size; i++) {
+    sum += static_cast<double>(_frames[i].*counter);
+  }
+  return sum / _size;
+}
@@ -0,0 +1,62 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+
+// Layout of the cooked scene files produced by the asset_cook tool.
+// The file starts with a header, followed by the name tables, the chunk table and one array per instance
+// attribute (SoA). Instances are sorted by chunk, then by mesh and material, so that each chunk is a
+// contiguous range of every array and its instances can be drawn together.
+// Every table and array is aligned, so the file can be mapped and read in place.
+
+/** "BTVS" in little endian */
+constexpr uint32_t SCENE_CONTAINER_MAGIC = 0x53565442;
+constexpr uint32_t SCENE_CONTAINER_VERSION = 1;
+/** Alignment of every table and array in the file */
+constexpr uint32_t SCENE_CONTAINER_ALIGNMENT = 16;
+/** Size of an entry of the name tables, null terminator included */
+constexpr uint32_t SCENE_CONTAINER_NAME_SIZE = 32;
+
+/** The instance is rasterized by the CPU occlusion culling */
+constexpr uint8_t SCENE_INSTANCE_OCCLUDER = 1;
+
+struct SceneContainerHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t meshCount;
+  uint32_t materialCount;
+  uint32_t instanceCount;
+  uint32_t chunkCount;
+  /** Size of the chunks on the X and Z axes */
+  float chunkSize;
+  uint32_t reserved;
+
+  /** Offsets of the tables from the start of the file */
+  uint64_t meshNamesOffset;
+  uint64_t materialNamesOffset;
+  uint64_t chunksOffset;
+
+  /** Instance arrays: float[3], float[4] (x, y, z, w), float[3], RGBA8, uint16, uint16, uint8 */
+  uint64_t positionsOffset;
+  uint64_t rotationsOffset;
+  uint64_t scalesOffset;
+  uint64_t colorsOffset;
+  uint64_t meshIndicesOffset;
+  uint64_t materialIndicesOffset;
+  uint64_t flagsOffset;
+};
+
+/** Range of instances whose positions are in the same cell of the chunk grid */
+struct SceneContainerChunk {
+  /** Box around the positions of the instances. The size of their meshes is not included. */
+  float boundsMin[3];
+  uint32_t firstInstance;
+  float boundsMax[3];
+  uint32_t instanceCount;
+};
+
+static_assert(sizeof(SceneContainerHeader) == 112);
+static_assert(sizeof(SceneContainerChunk) == 32);
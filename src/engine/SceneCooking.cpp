@@ -0,0 +1,256 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "SceneCooking.h"
+#include "SceneContainer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+/** Instances in AoS layout while the scene is parsed */
+struct SourceInstance {
+  float position[3];
+  float rotation[4];
+  float scale[3];
+  uint32_t color;
+  uint16_t mesh;
+  uint16_t material;
+  uint8_t flags;
+};
+
+/** Name table, giving each new name the next index */
+class NameTable {
+private:
+  std::unordered_map<std::string, uint16_t> _indices;
+  std::vector<std::string> _names;
+
+public:
+  bool Add(const std::string &name, uint16_t &index) {
+    if (name.size() >= SCENE_CONTAINER_NAME_SIZE) {
+      std::cerr << "Name too long: " << name << '\n';
+      return false;
+    }
+    auto it = _indices.find(name);
+    if (it == _indices.end()) {
+      if (_names.size() > UINT16_MAX) {
+        std::cerr << "Too many names\n";
+        return false;
+      }
+      it = _indices.emplace(name, static_cast<uint16_t>(_names.size())).first;
+      _names.push_back(name);
+    }
+    index = it->second;
+    return true;
+  }
+
+  [[nodiscard]] const std::vector<std::string> &GetNames() const { return _names; }
+};
+
+uint32_t PackColor(float r, float g, float b, float a) {
+  auto toByte = [](float value) {
+    return static_cast<uint32_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+  };
+  return toByte(r) | toByte(g) << 8 | toByte(b) << 16 | toByte(a) << 24;
+}
+
+/** Rotation around the Y axis, as a quaternion */
+void SetYaw(float degrees, float rotation[4]) {
+  const float halfAngle = degrees * 3.14159265f / 360.0f;
+  rotation[0] = 0.0f;
+  rotation[1] = std::sin(halfAngle);
+  rotation[2] = 0.0f;
+  rotation[3] = std::cos(halfAngle);
+}
+
+size_t Align(size_t value) {
+  return (value + SCENE_CONTAINER_ALIGNMENT - 1) / SCENE_CONTAINER_ALIGNMENT * SCENE_CONTAINER_ALIGNMENT;
+}
+
+} // namespace
+
+namespace scenecook {
+
+bool CookScene(const char *sourcePath, std::vector<uint8_t> &container) {
+  std::ifstream source(sourcePath);
+  if (!source.is_open()) {
+    std::cerr << "Couldn't open " << sourcePath << '\n';
+    return false;
+  }
+
+  // Parse the commands
+  float chunkSize = DEFAULT_CHUNK_SIZE;
+  NameTable meshes;
+  NameTable materials;
+  std::vector<SourceInstance> instances;
+  std::string line;
+  for (uint32_t lineNumber = 1; std::getline(source, line); lineNumber++) {
+    std::istringstream stream(line);
+    std::string command;
+    if (!(stream >> command) || command[0] == '#')
+      continue;
+
+    bool valid = true;
+    if (command == "chunk_size") {
+      valid = static_cast<bool>(stream >> chunkSize) && chunkSize > 0.0f;
+    } else if (command == "instance") {
+      std::string mesh, material, flag;
+      float yaw, r, g, b;
+      SourceInstance instance{};
+      valid = static_cast<bool>(stream >> mesh >> material >> instance.position[0] >> instance.position[1] >>
+                                instance.position[2] >> instance.scale[0] >> yaw >> r >> g >> b) &&
+              meshes.Add(mesh, instance.mesh) && materials.Add(material, instance.material);
+      if (stream >> flag) {
+        valid = valid && flag == "occluder";
+        instance.flags = SCENE_INSTANCE_OCCLUDER;
+      }
+      instance.scale[1] = instance.scale[2] = instance.scale[0];
+      SetYaw(yaw, instance.rotation);
+      instance.color = PackColor(r, g, b, 1.0f);
+      instances.push_back(instance);
+    } else if (command == "grid") {
+      std::string mesh, material;
+      float origin[3], spacing, scale;
+      uint32_t countX, countZ;
+      SourceInstance instance{};
+      valid = static_cast<bool>(stream >> mesh >> material >> origin[0] >> origin[1] >> origin[2] >> countX >>
+                                countZ >> spacing >> scale) &&
+              meshes.Add(mesh, instance.mesh) && materials.Add(material, instance.material);
+      SetYaw(0.0f, instance.rotation);
+      instance.scale[0] = instance.scale[1] = instance.scale[2] = scale;
+      instances.reserve(instances.size() + static_cast<size_t>(countX) * countZ);
+      for (uint32_t x = 0; valid && x < countX; x++) {
+        for (uint32_t z = 0; z < countZ; z++) {
+          instance.position[0] = origin[0] + static_cast<float>(x) * spacing;
+          instance.position[1] = origin[1];
+          instance.position[2] = origin[2] + static_cast<float>(z) * spacing;
+          instance.color = PackColor(static_cast<float>(x) / static_cast<float>(std::max(countX - 1, 1u)),
+                                     static_cast<float>(z) / static_cast<float>(std::max(countZ - 1, 1u)),
+                                     0.1f, 1.0f);
+          instances.push_back(instance);
+        }
+      }
+    } else {
+      valid = false;
+    }
+
+    if (!valid) {
+      std::cerr << sourcePath << ':' << lineNumber << ": invalid line: " << line << '\n';
+      return false;
+    }
+  }
+
+  // Sort the instances by chunk, then by mesh and material so that the engine can draw them as instances
+  std::vector<uint64_t> chunkKeys(instances.size());
+  for (size_t i = 0; i < instances.size(); i++) {
+    const auto cellX = static_cast<int32_t>(std::floor(instances[i].position[0] / chunkSize));
+    const auto cellZ = static_cast<int32_t>(std::floor(instances[i].position[2] / chunkSize));
+    chunkKeys[i] = static_cast<uint64_t>(static_cast<uint32_t>(cellX)) << 32 | static_cast<uint32_t>(cellZ);
+  }
+  std::vector<uint32_t> order(instances.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    if (chunkKeys[a] != chunkKeys[b])
+      return chunkKeys[a] < chunkKeys[b];
+    if (instances[a].mesh != instances[b].mesh)
+      return instances[a].mesh < instances[b].mesh;
+    return instances[a].material < instances[b].material;
+  });
+
+  // Split the sorted instances in chunks
+  std::vector<SceneContainerChunk> chunks;
+  for (uint32_t i = 0; i < order.size(); i++) {
+    const float *position = instances[order[i]].position;
+    if (i == 0 || chunkKeys[order[i]] != chunkKeys[order[i - 1]]) {
+      chunks.push_back(SceneContainerChunk{
+          .boundsMin = {position[0], position[1], position[2]},
+          .firstInstance = i,
+          .boundsMax = {position[0], position[1], position[2]},
+          .instanceCount = 0,
+      });
+    }
+    SceneContainerChunk &chunk = chunks.back();
+    for (uint32_t axis = 0; axis < 3; axis++) {
+      chunk.boundsMin[axis] = std::min(chunk.boundsMin[axis], position[axis]);
+      chunk.boundsMax[axis] = std::max(chunk.boundsMax[axis], position[axis]);
+    }
+    chunk.instanceCount++;
+  }
+
+  // Compute the layout of the file
+  const auto instanceCount = static_cast<uint32_t>(instances.size());
+  SceneContainerHeader header{
+      .magic = SCENE_CONTAINER_MAGIC,
+      .version = SCENE_CONTAINER_VERSION,
+      .meshCount = static_cast<uint32_t>(meshes.GetNames().size()),
+      .materialCount = static_cast<uint32_t>(materials.GetNames().size()),
+      .instanceCount = instanceCount,
+      .chunkCount = static_cast<uint32_t>(chunks.size()),
+      .chunkSize = chunkSize,
+      .reserved = 0,
+      // The tables are placed below
+      .meshNamesOffset = 0,
+      .materialNamesOffset = 0,
+      .chunksOffset = 0,
+      .positionsOffset = 0,
+      .rotationsOffset = 0,
+      .scalesOffset = 0,
+      .colorsOffset = 0,
+      .meshIndicesOffset = 0,
+      .materialIndicesOffset = 0,
+      .flagsOffset = 0,
+  };
+  size_t offset = Align(sizeof(header));
+  auto place = [&offset](uint64_t &tableOffset, size_t size) {
+    tableOffset = offset;
+    offset = Align(offset + size);
+  };
+  place(header.meshNamesOffset, SCENE_CONTAINER_NAME_SIZE * header.meshCount);
+  place(header.materialNamesOffset, SCENE_CONTAINER_NAME_SIZE * header.materialCount);
+  place(header.chunksOffset, sizeof(SceneContainerChunk) * header.chunkCount);
+  place(header.positionsOffset, sizeof(float) * 3 * instanceCount);
+  place(header.rotationsOffset, sizeof(float) * 4 * instanceCount);
+  place(header.scalesOffset, sizeof(float) * 3 * instanceCount);
+  place(header.colorsOffset, sizeof(uint32_t) * instanceCount);
+  place(header.meshIndicesOffset, sizeof(uint16_t) * instanceCount);
+  place(header.materialIndicesOffset, sizeof(uint16_t) * instanceCount);
+  place(header.flagsOffset, sizeof(uint8_t) * instanceCount);
+
+  // Fill it
+  container.assign(offset, 0);
+  uint8_t *data = container.data();
+  memcpy(data, &header, sizeof(header));
+  for (size_t i = 0; i < meshes.GetNames().size(); i++) {
+    const std::string &name = meshes.GetNames()[i];
+    memcpy(data + header.meshNamesOffset + SCENE_CONTAINER_NAME_SIZE * i, name.data(), name.size());
+  }
+  for (size_t i = 0; i < materials.GetNames().size(); i++) {
+    const std::string &name = materials.GetNames()[i];
+    memcpy(data + header.materialNamesOffset + SCENE_CONTAINER_NAME_SIZE * i, name.data(), name.size());
+  }
+  memcpy(data + header.chunksOffset, chunks.data(), sizeof(SceneContainerChunk) * chunks.size());
+
+  // Scatter the instances in the arrays
+  for (uint32_t i = 0; i < instanceCount; i++) {
+    const SourceInstance &instance = instances[order[i]];
+    memcpy(data + header.positionsOffset + sizeof(float) * 3 * i, instance.position, sizeof(float) * 3);
+    memcpy(data + header.rotationsOffset + sizeof(float) * 4 * i, instance.rotation, sizeof(float) * 4);
+    memcpy(data + header.scalesOffset + sizeof(float) * 3 * i, instance.scale, sizeof(float) * 3);
+    memcpy(data + header.colorsOffset + sizeof(uint32_t) * i, &instance.color, sizeof(uint32_t));
+    memcpy(data + header.meshIndicesOffset + sizeof(uint16_t) * i, &instance.mesh, sizeof(uint16_t));
+    memcpy(data + header.materialIndicesOffset + sizeof(uint16_t) * i, &instance.material, sizeof(uint16_t));
+    data[header.flagsOffset + i] = instance.flags;
+  }
+
+  return true;
+}
+
+} // namespace scenecook
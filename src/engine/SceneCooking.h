@@ -0,0 +1,27 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace scenecook {
+/** Chunk size used when the source doesn't give one */
+constexpr float DEFAULT_CHUNK_SIZE = 16.0f;
+
+/**
+ * Converts a scene description to a scene container.
+ * The description is a text file with one command per line:
+ *
+ *   chunk_size <size>
+ *   instance <mesh> <material> <x> <y> <z> <scale> <yaw> <r> <g> <b> [occluder]
+ *   grid <mesh> <material> <x> <y> <z> <countX> <countZ> <spacing> <scale>
+ *
+ * Angles are in degrees and colors between 0 and 1. The instances of a grid get a color gradient.
+ * Empty lines and lines starting with # are ignored.
+ * @return false if the file can't be read or has an invalid line
+ */
+bool CookScene(const char *sourcePath, std::vector<uint8_t> &container);
+} // namespace scenecook
@@ -0,0 +1,164 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "SceneStreamer.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+/** Resident chunks are unloaded when they are further than the loading radius times this factor */
+constexpr float UNLOAD_RADIUS_FACTOR = 1.25f;
+
+bool SceneStreamer::Open(const char *filename) {
+  _ownedData.clear();
+  if (!_file.Open(filename))
+    return false;
+  _data = _file.GetData();
+  return Parse(_file.GetSize());
+}
+
+bool SceneStreamer::Open(std::vector<uint8_t> &&container) {
+  _ownedData = std::move(container);
+  _data = _ownedData.data();
+  return Parse(_ownedData.size());
+}
+
+bool SceneStreamer::Parse(size_t size) {
+  // Check header
+  if (size < sizeof(_header))
+    return false;
+  memcpy(&_header, _data, sizeof(_header));
+  if (_header.magic != SCENE_CONTAINER_MAGIC || _header.version != SCENE_CONTAINER_VERSION) {
+    std::cerr << "Invalid scene container\n";
+    return false;
+  }
+
+  // Check that every table and array is aligned and inside the file
+  const uint64_t instanceCount = _header.instanceCount;
+  const std::pair<uint64_t, uint64_t> ranges[] = {
+      {_header.meshNamesOffset, uint64_t{SCENE_CONTAINER_NAME_SIZE} * _header.meshCount},
+      {_header.materialNamesOffset, uint64_t{SCENE_CONTAINER_NAME_SIZE} * _header.materialCount},
+      {_header.chunksOffset, sizeof(SceneContainerChunk) * uint64_t{_header.chunkCount}},
+      {_header.positionsOffset, sizeof(float) * 3 * instanceCount},
+      {_header.rotationsOffset, sizeof(float) * 4 * instanceCount},
+      {_header.scalesOffset, sizeof(float) * 3 * instanceCount},
+      {_header.colorsOffset, sizeof(uint32_t) * instanceCount},
+      {_header.meshIndicesOffset, sizeof(uint16_t) * instanceCount},
+      {_header.materialIndicesOffset, sizeof(uint16_t) * instanceCount},
+      {_header.flagsOffset, sizeof(uint8_t) * instanceCount},
+  };
+  for (const auto &[offset, rangeSize] : ranges) {
+    if (offset % SCENE_CONTAINER_ALIGNMENT != 0 || offset > size || rangeSize > size - offset) {
+      std::cerr << "Invalid scene container\n";
+      return false;
+    }
+  }
+
+  _chunks = reinterpret_cast<const SceneContainerChunk *>(_data + _header.chunksOffset);
+  for (uint32_t i = 0; i < _header.chunkCount; i++) {
+    if (_chunks[i].firstInstance > _header.instanceCount ||
+        _chunks[i].instanceCount > _header.instanceCount - _chunks[i].firstInstance) {
+      std::cerr << "Invalid scene container\n";
+      return false;
+    }
+  }
+  _instances = SceneInstances{
+      .positions = reinterpret_cast<const float *>(_data + _header.positionsOffset),
+      .rotations = reinterpret_cast<const float *>(_data + _header.rotationsOffset),
+      .scales = reinterpret_cast<const float *>(_data + _header.scalesOffset),
+      .colors = reinterpret_cast<const uint32_t *>(_data + _header.colorsOffset),
+      .meshIndices = reinterpret_cast<const uint16_t *>(_data + _header.meshIndicesOffset),
+      .materialIndices = reinterpret_cast<const uint16_t *>(_data + _header.materialIndicesOffset),
+      .flags = _data + _header.flagsOffset,
+  };
+
+  // Names are stored in fixed size entries, padded with zeros
+  auto readNames = [this](uint64_t offset, uint32_t count, std::vector<std::string> &names) {
+    names.clear();
+    for (uint32_t i = 0; i < count; i++) {
+      const auto *name = reinterpret_cast<const char *>(_data + offset + SCENE_CONTAINER_NAME_SIZE * i);
+      names.emplace_back(name, strnlen(name, SCENE_CONTAINER_NAME_SIZE));
+    }
+  };
+  readNames(_header.meshNamesOffset, _header.meshCount, _meshNames);
+  readNames(_header.materialNamesOffset, _header.materialCount, _materialNames);
+
+  std::vector<Aabb> chunkBounds(_header.chunkCount);
+  for (uint32_t i = 0; i < _header.chunkCount; i++) {
+    chunkBounds[i].min = {_chunks[i].boundsMin[0], _chunks[i].boundsMin[1], _chunks[i].boundsMin[2]};
+    chunkBounds[i].max = {_chunks[i].boundsMax[0], _chunks[i].boundsMax[1], _chunks[i].boundsMax[2]};
+  }
+  _chunkBvh.Build(std::move(chunkBounds));
+
+  _resident.assign(_header.chunkCount, 0);
+  _residentInstanceCount = 0;
+  return true;
+}
+
+const std::vector<std::string> &SceneStreamer::GetMeshNames() const { return _meshNames; }
+
+const std::vector<std::string> &SceneStreamer::GetMaterialNames() const { return _materialNames; }
+
+uint32_t SceneStreamer::GetChunkCount() const { return _header.chunkCount; }
+
+const SceneContainerChunk &SceneStreamer::GetChunk(uint32_t chunk) const { return _chunks[chunk]; }
+
+const SceneInstances &SceneStreamer::GetInstances() const { return _instances; }
+
+uint32_t SceneStreamer::GetInstanceCount() const { return _header.instanceCount; }
+
+uint32_t SceneStreamer::GetResidentInstanceCount() const { return _residentInstanceCount; }
+
+void SceneStreamer::Update(const glm::vec3 &cameraPosition, float radius, uint32_t maxInstances,
+                           uint32_t maxLoads, std::vector<uint32_t> &chunksToLoad,
+                           std::vector<uint32_t> &chunksToUnload) {
+  chunksToLoad.clear();
+  chunksToUnload.clear();
+
+  // Distance from the camera to the box of each chunk close enough to be kept.
+  // Resident chunks are kept further away, so query the largest radius and filter the others.
+  _chunkBvh.QueryRadius(cameraPosition, radius * UNLOAD_RADIUS_FACTOR, _nearbyChunks);
+  _candidates.clear();
+  for (const uint32_t i : _nearbyChunks) {
+    const SceneContainerChunk &chunk = _chunks[i];
+    float squaredDistance = 0.0f;
+    for (uint32_t axis = 0; axis < 3; axis++) {
+      const float outside = std::max({chunk.boundsMin[axis] - cameraPosition[axis], 0.0f,
+                                      cameraPosition[axis] - chunk.boundsMax[axis]});
+      squaredDistance += outside * outside;
+    }
+    const float keepRadius = _resident[i] ? radius * UNLOAD_RADIUS_FACTOR : radius;
+    if (squaredDistance <= keepRadius * keepRadius) {
+      _candidates.emplace_back(squaredDistance, i);
+    }
+  }
+  std::sort(_candidates.begin(), _candidates.end());
+
+  // The closest chunks that fit in the budget are wanted. The others become free to unload.
+  uint32_t wantedInstanceCount = 0;
+  _wanted.assign(_header.chunkCount, 0);
+  for (const auto &[squaredDistance, chunk] : _candidates) {
+    if (wantedInstanceCount + _chunks[chunk].instanceCount > maxInstances)
+      break;
+    wantedInstanceCount += _chunks[chunk].instanceCount;
+    _wanted[chunk] = 1;
+  }
+
+  for (uint32_t i = 0; i < _header.chunkCount; i++) {
+    if (_resident[i] && !_wanted[i]) {
+      chunksToUnload.push_back(i);
+      _resident[i] = 0;
+      _residentInstanceCount -= _chunks[i].instanceCount;
+    }
+  }
+  for (const auto &[squaredDistance, chunk] : _candidates) {
+    if (chunksToLoad.size() == maxLoads)
+      break;
+    if (_wanted[chunk] && !_resident[chunk]) {
+      chunksToLoad.push_back(chunk);
+      _resident[chunk] = 1;
+      _residentInstanceCount += _chunks[chunk].instanceCount;
+    }
+  }
+}
@@ -0,0 +1,78 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include "Bvh.h"
+#include "MappedFile.h"
+#include "SceneContainer.h"
+#include <glm/vec3.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+/** Instance arrays of a scene container, read in place */
+struct SceneInstances {
+  const float *positions;
+  const float *rotations;
+  const float *scales;
+  const uint32_t *colors;
+  const uint16_t *meshIndices;
+  const uint16_t *materialIndices;
+  const uint8_t *flags;
+};
+
+/**
+ * Streams the chunks of a scene container in and out around the camera.
+ *
+ * Opening a scene only validates the header and the tables: the instances are read in place, chunk by chunk,
+ * when the camera gets close enough. The streamer only decides which chunks are resident. Their instances
+ * are turned into objects by the caller.
+ */
+class SceneStreamer {
+private:
+  MappedFile _file;
+  /** Container cooked in memory, when there is no file to map */
+  std::vector<uint8_t> _ownedData;
+  const uint8_t *_data = nullptr;
+  SceneContainerHeader _header{};
+  const SceneContainerChunk *_chunks = nullptr;
+  SceneInstances _instances{};
+  std::vector<std::string> _meshNames;
+  std::vector<std::string> _materialNames;
+  /** Tree over the boxes of the chunks, to find the ones around the camera without visiting all of them */
+  Bvh _chunkBvh;
+
+  std::vector<uint8_t> _resident;
+  uint32_t _residentInstanceCount = 0;
+  /** Chunks close to the camera sorted by distance, and chunks to keep. Reused between updates. */
+  std::vector<std::pair<float, uint32_t>> _candidates;
+  std::vector<uint32_t> _nearbyChunks;
+  std::vector<uint8_t> _wanted;
+
+  bool Parse(size_t size);
+
+public:
+  /** Maps a cooked scene file */
+  bool Open(const char *filename);
+  /** Uses a scene container built in memory */
+  bool Open(std::vector<uint8_t> &&container);
+
+  [[nodiscard]] const std::vector<std::string> &GetMeshNames() const;
+  [[nodiscard]] const std::vector<std::string> &GetMaterialNames() const;
+  [[nodiscard]] uint32_t GetChunkCount() const;
+  [[nodiscard]] const SceneContainerChunk &GetChunk(uint32_t chunk) const;
+  [[nodiscard]] const SceneInstances &GetInstances() const;
+  [[nodiscard]] uint32_t GetInstanceCount() const;
+  [[nodiscard]] uint32_t GetResidentInstanceCount() const;
+
+  /**
+   * Chooses the chunks to stream in and out. The caller must apply the changes before the next update.
+   * Chunks closer than radius are loaded, closest first, as long as the resident instances fit in the budget.
+   * Resident chunks are only unloaded a bit further, so that the ones at the border don't go back and forth.
+   * @param maxLoads chunks streamed in by this update at most, to spread the work over several frames
+   */
+  void Update(const glm::vec3 &cameraPosition, float radius, uint32_t maxInstances, uint32_t maxLoads,
+              std::vector<uint32_t> &chunksToLoad, std::vector<uint32_t> &chunksToUnload);
+};
@@ -0,0 +1,122 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+template <class T = void> class Task;
+
+namespace detail {
+
+struct TaskPromiseBase {
+  /** Coroutine awaiting the task, resumed when it finishes */
+  std::coroutine_handle<> continuation;
+  std::exception_ptr exception;
+
+  struct FinalAwaiter {
+    [[nodiscard]] bool await_ready() const noexcept { return false; }
+    template <class Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) const noexcept {
+      const std::coroutine_handle<> continuation = handle.promise().continuation;
+      return continuation ? continuation : std::noop_coroutine();
+    }
+    void await_resume() const noexcept {}
+  };
+
+  /** Tasks start right away, like a function call */
+  [[nodiscard]] std::suspend_never initial_suspend() const noexcept { return {}; }
+  /** The coroutine is kept until the task is destroyed, so that its result can still be read */
+  [[nodiscard]] FinalAwaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() { exception = std::current_exception(); }
+
+  void RethrowIfFailed() const {
+    if (exception)
+      std::rethrow_exception(exception);
+  }
+};
+
+template <class T> struct TaskPromise : TaskPromiseBase {
+  std::optional<T> value;
+
+  void return_value(T result) { value = std::move(result); }
+  T TakeResult() {
+    RethrowIfFailed();
+    return std::move(*value);
+  }
+};
+
+template <> struct TaskPromise<void> : TaskPromiseBase {
+  void return_void() {}
+  void TakeResult() const { RethrowIfFailed(); }
+};
+
+} // namespace detail
+
+/**
+ * Coroutine returned by the asynchronous functions of the engine.
+ *
+ * The coroutine runs right away, until it awaits something that isn't ready: a job, a GPU upload or another
+ * task. It is then resumed by the TaskScheduler on the main thread, so it can use the engine like any other
+ * function. The task owns the coroutine: it must be kept until IsDone returns true.
+ */
+template <class T> class Task {
+public:
+  struct promise_type : detail::TaskPromise<T> {
+    Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+  };
+
+private:
+  std::coroutine_handle<promise_type> _handle = nullptr;
+
+  explicit Task(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+
+public:
+  Task() = default;
+  ~Task() {
+    if (_handle)
+      _handle.destroy();
+  }
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+  Task(Task &&other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+  Task &operator=(Task &&other) noexcept {
+    if (this != &other) {
+      if (_handle)
+        _handle.destroy();
+      _handle = std::exchange(other._handle, nullptr);
+    }
+    return *this;
+  }
+
+  /** True when the coroutine has returned. Empty tasks are done. */
+  [[nodiscard]] bool IsDone() const { return !_handle || _handle.done(); }
+
+  /**
+   * Result of the coroutine. The task must be done. Rethrows the exception that ended the coroutine, if any.
+   * The result is moved out, so it can only be read once.
+   */
+  T GetResult() { return _handle.promise().TakeResult(); }
+
+  /** Awaiting a task resumes the coroutine when the task is done, with its result */
+  auto operator co_await() & noexcept {
+    struct Awaiter {
+      Task &task;
+
+      [[nodiscard]] bool await_ready() const noexcept { return task.IsDone(); }
+      void await_suspend(std::coroutine_handle<> handle) const noexcept {
+        task._handle.promise().continuation = handle;
+      }
+      T await_resume() const { return task.GetResult(); }
+    };
+    return Awaiter{*this};
+  }
+  auto operator co_await() && noexcept { return operator co_await(); }
+};
+
+/** Wraps a task whose result isn't needed, so that it can be kept with other ones until it is done */
+template <class T> Task<> DiscardResult(Task<T> task) { co_await task; }
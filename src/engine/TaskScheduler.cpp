@@ -0,0 +1,24 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "TaskScheduler.h"
+
+TaskScheduler::ConditionAwaiter TaskScheduler::WaitUntil(std::function<bool()> isReady) {
+  return ConditionAwaiter(this, std::move(isReady));
+}
+
+void TaskScheduler::Poll() {
+  // Resumed coroutines may wait again, which adds them to _waiting while it is being polled
+  _polled.swap(_waiting);
+  for (auto &task : _polled) {
+    if (task.isReady()) {
+      task.handle.resume();
+    } else {
+      _waiting.push_back(std::move(task));
+    }
+  }
+  _polled.clear();
+}
+
+bool TaskScheduler::HasWaitingTasks() const { return !_waiting.empty(); }
@@ -0,0 +1,87 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <functional>
+#include <future>
+#include <utility>
+#include <vector>
+
+/**
+ * Resumes the coroutines waiting for something to finish, once it is done.
+ *
+ * Nothing is resumed from another thread: Poll checks the waiting coroutines and resumes the ready ones on
+ * the calling thread. The engine polls once per frame, so a coroutine never blocks a frame to wait.
+ */
+class TaskScheduler {
+private:
+  struct WaitingTask {
+    std::coroutine_handle<> handle;
+    std::function<bool()> isReady;
+  };
+
+  std::vector<WaitingTask> _waiting;
+  /** Tasks checked by the current poll. Kept to reuse its memory. */
+  std::vector<WaitingTask> _polled;
+
+public:
+  /** Awaitable suspending the coroutine until isReady returns true */
+  class ConditionAwaiter {
+  private:
+    TaskScheduler *_scheduler;
+    std::function<bool()> _isReady;
+
+  public:
+    ConditionAwaiter(TaskScheduler *scheduler, std::function<bool()> isReady)
+        : _scheduler(scheduler), _isReady(std::move(isReady)) {}
+
+    [[nodiscard]] bool await_ready() const { return _isReady(); }
+    void await_suspend(std::coroutine_handle<> handle) {
+      _scheduler->_waiting.push_back(WaitingTask{handle, std::move(_isReady)});
+    }
+    void await_resume() const {}
+  };
+
+  /** Awaitable suspending the coroutine until a job is done, and returning its result */
+  template <class T> class FutureAwaiter {
+  private:
+    TaskScheduler *_scheduler;
+    std::future<T> _future;
+
+    [[nodiscard]] bool IsReady() const {
+      return _future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+  public:
+    FutureAwaiter(TaskScheduler *scheduler, std::future<T> future)
+        : _scheduler(scheduler), _future(std::move(future)) {}
+
+    [[nodiscard]] bool await_ready() const { return IsReady(); }
+    void await_suspend(std::coroutine_handle<> handle) {
+      // The awaiter lives in the coroutine frame, so it stays valid until the coroutine is resumed
+      _scheduler->_waiting.push_back(WaitingTask{handle, [this]() { return IsReady(); }});
+    }
+    T await_resume() { return _future.get(); }
+  };
+
+  TaskScheduler() = default;
+  TaskScheduler(const TaskScheduler &) = delete;
+  TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+  /** Suspends the coroutine until isReady returns true. It is checked right away, then at each poll. */
+  [[nodiscard]] ConditionAwaiter WaitUntil(std::function<bool()> isReady);
+  /** Suspends the coroutine until the future is ready, typically the one of a job of the JobSystem */
+  template <class T> [[nodiscard]] FutureAwaiter<T> WaitFor(std::future<T> &&future);
+
+  /** Resumes the coroutines that can continue. They run until they finish or wait again. */
+  void Poll();
+  [[nodiscard]] bool HasWaitingTasks() const;
+};
+
+template <class T> TaskScheduler::FutureAwaiter<T> TaskScheduler::WaitFor(std::future<T> &&future) {
+  return FutureAwaiter<T>(this, std::move(future));
+}
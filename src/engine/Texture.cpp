@@ -0,0 +1,68 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "Texture.h"
+#include "TextureContainer.h"
+#include <cstring>
+#include <iostream>
+
+bool ParseTextureContainer(const MappedFile &file, TextureUploadInfo &uploadInfo) {
+  // Check header
+  TextureContainerHeader header{};
+  if (file.GetSize() < sizeof(header))
+    return false;
+  memcpy(&header, file.GetData(), sizeof(header));
+  if (header.magic != TEXTURE_CONTAINER_MAGIC || header.version != TEXTURE_CONTAINER_VERSION ||
+      header.mipCount == 0) {
+    std::cerr << "Invalid texture container\n";
+    return false;
+  }
+
+  // Get format
+  switch (header.format) {
+  case TextureContainerFormat::RGBA8:
+    uploadInfo.format = vk::Format::eR8G8B8A8Unorm;
+    break;
+  case TextureContainerFormat::BC1:
+    uploadInfo.format = vk::Format::eBc1RgbaUnormBlock;
+    break;
+  case TextureContainerFormat::BC3:
+    uploadInfo.format = vk::Format::eBc3UnormBlock;
+    break;
+  case TextureContainerFormat::BC7:
+    uploadInfo.format = vk::Format::eBc7UnormBlock;
+    break;
+  default:
+    std::cerr << "Unknown texture container format\n";
+    return false;
+  }
+
+  // Check the mip table
+  const size_t tableEnd = sizeof(header) + sizeof(TextureContainerMip) * header.mipCount;
+  if (file.GetSize() < tableEnd)
+    return false;
+  std::vector<TextureContainerMip> mips(header.mipCount);
+  memcpy(mips.data(), file.GetData() + sizeof(header), sizeof(TextureContainerMip) * header.mipCount);
+
+  // Payloads are contiguous, so the whole range is given to the uploader with offsets relative to the first mip
+  const uint64_t firstOffset = mips[0].offset;
+  const uint64_t lastEnd = mips.back().offset + mips.back().size;
+  if (firstOffset < tableEnd || lastEnd > file.GetSize())
+    return false;
+
+  uploadInfo.data = file.GetData() + firstOffset;
+  uploadInfo.dataSize = lastEnd - firstOffset;
+  uploadInfo.mips.clear();
+  uploadInfo.mips.reserve(header.mipCount);
+  for (const auto &mip : mips) {
+    uploadInfo.mips.push_back(MipLevel{
+        .width = mip.width,
+        .height = mip.height,
+        .offset = mip.offset - firstOffset,
+        .size = mip.size,
+    });
+  }
+
+  return true;
+}
@@ -0,0 +1,38 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include "ImageProcessing.h"
+#include "MappedFile.h"
+#include "vk_types.h"
+#include <vector>
+
+/** Texture index meaning that there is no texture */
+constexpr uint32_t NO_TEXTURE = ~0u;
+
+struct Texture {
+  AllocatedImage image;
+  vk::ImageView imageView = nullptr;
+  vk::Format format = vk::Format::eUndefined;
+  uint32_t mipLevels = 1;
+  /** Index in the bindless texture array, if the bindless mode is enabled */
+  uint32_t bindlessIndex = NO_TEXTURE;
+};
+
+/** Everything needed to upload a texture and its mip chain through the staging path */
+struct TextureUploadInfo {
+  vk::Format format;
+  /** Pixels of every mip level. Offsets of the mips are relative to this pointer. */
+  const uint8_t *data;
+  size_t dataSize;
+  std::vector<MipLevel> mips;
+};
+
+/**
+ * Reads a mapped texture container made by asset_cook. The upload info points directly inside the mapping,
+ * so the file must stay mapped until the upload is done.
+ * @return false if the file is not a valid container
+ */
+bool ParseTextureContainer(const MappedFile &file, TextureUploadInfo &uploadInfo);
@@ -0,0 +1,48 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+
+// Layout of the cooked texture files produced by the asset_cook tool.
+// The file starts with a header, followed by one entry per mip level, followed by the payloads.
+// Payloads are already in the layout expected by vkCmdCopyBufferToImage, so they can be uploaded as-is.
+
+/** "BTVT" in little endian */
+constexpr uint32_t TEXTURE_CONTAINER_MAGIC = 0x54565442;
+constexpr uint32_t TEXTURE_CONTAINER_VERSION = 1;
+/** Alignment of every mip payload in the file */
+constexpr uint32_t TEXTURE_CONTAINER_ALIGNMENT = 16;
+
+enum class TextureContainerFormat : uint32_t {
+  RGBA8 = 0,
+  /** 4x4 blocks of 8 bytes, 1 bit alpha */
+  BC1 = 1,
+  /** 4x4 blocks of 16 bytes, BC1 color + interpolated alpha */
+  BC3 = 2,
+  /** 4x4 blocks of 16 bytes. Not produced by asset_cook, but accepted by the runtime */
+  BC7 = 3,
+};
+
+struct TextureContainerHeader {
+  uint32_t magic;
+  uint32_t version;
+  TextureContainerFormat format;
+  uint32_t width;
+  uint32_t height;
+  uint32_t mipCount;
+  uint32_t reserved[2];
+};
+
+struct TextureContainerMip {
+  uint32_t width;
+  uint32_t height;
+  /** Offset of the payload from the start of the file */
+  uint64_t offset;
+  uint64_t size;
+};
+
+static_assert(sizeof(TextureContainerHeader) == 32);
+static_assert(sizeof(TextureContainerMip) == 24);
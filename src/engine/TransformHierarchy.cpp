@@ -0,0 +1,350 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "TransformHierarchy.h"
+#include <algorithm>
+#include <cmath>
+
+// SSE only, since every x86-64 CPU has it. The build doesn't enable AVX for the whole program: a wider path
+// would need to be dispatched at runtime, like the occlusion culling kernels.
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define TRANSFORM_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace {
+constexpr uint32_t GROUP_SIZE = 4;
+
+/** Local matrices of a group of nodes, without their last row. Indexed by column, row, then node. */
+struct LocalGroup {
+  float columns[4][3][GROUP_SIZE];
+};
+
+const glm::mat4 IDENTITY{1.0f};
+} // namespace
+
+// ==== Local transforms ====
+
+template <class F> void TransformHierarchy::LocalTransforms::ForEachComponent(F &&function) {
+  for (auto *values : {&positionX, &positionY, &positionZ, &rotationX, &rotationY, &rotationZ}) {
+    function(*values, 0.0f);
+  }
+  for (auto *values : {&rotationW, &scaleX, &scaleY, &scaleZ}) {
+    function(*values, 1.0f);
+  }
+}
+
+void TransformHierarchy::LocalTransforms::Set(uint32_t index, const Transform &transform) {
+  positionX[index] = transform.position.x;
+  positionY[index] = transform.position.y;
+  positionZ[index] = transform.position.z;
+  rotationX[index] = transform.rotation.x;
+  rotationY[index] = transform.rotation.y;
+  rotationZ[index] = transform.rotation.z;
+  rotationW[index] = transform.rotation.w;
+  scaleX[index] = transform.scale.x;
+  scaleY[index] = transform.scale.y;
+  scaleZ[index] = transform.scale.z;
+}
+
+void TransformHierarchy::SetLocal(TransformId id, const Transform &local) {
+  const uint32_t index = _indices[id];
+  _current.Set(index, local);
+  _dirty[index] = 1;
+  _interpolated[index] = 1;
+}
+
+Transform TransformHierarchy::GetLocal(TransformId id) const {
+  const uint32_t index = _indices[id];
+  return Transform{
+      .position = glm::vec3(_current.positionX[index], _current.positionY[index], _current.positionZ[index]),
+      .rotation = glm::quat(_current.rotationW[index], _current.rotationX[index], _current.rotationY[index],
+                            _current.rotationZ[index]),
+      .scale = glm::vec3(_current.scaleX[index], _current.scaleY[index], _current.scaleZ[index]),
+  };
+}
+
+void TransformHierarchy::BeginTick() {
+  // Same sizes, so no allocation
+  _previous = _current;
+
+  // Nodes that moved during the last tick get a last update, at their final transform
+  for (size_t i = 0; i < _interpolated.size(); i++) {
+    _dirty[i] |= _interpolated[i];
+  }
+  std::fill(_interpolated.begin(), _interpolated.end(), 0);
+}
+
+// ==== Structure ====
+
+void TransformHierarchy::Resize(size_t nodeCount) {
+  // Padding nodes have an identity transform
+  const size_t paddedCount = (nodeCount + GROUP_SIZE - 1) / GROUP_SIZE * GROUP_SIZE;
+  auto resize = [paddedCount](std::vector<float> &values, float identity) {
+    values.resize(paddedCount, identity);
+  };
+  _current.ForEachComponent(resize);
+  _previous.ForEachComponent(resize);
+  _parents.resize(nodeCount, NO_TRANSFORM);
+  _depths.resize(nodeCount, 0);
+  _dirty.resize(nodeCount, 1);
+  _interpolated.resize(nodeCount, 0);
+  _worldMatrices.resize(nodeCount, IDENTITY);
+}
+
+TransformId TransformHierarchy::Add(const Transform &local, TransformId parent) {
+  const auto index = static_cast<uint32_t>(_ids.size());
+  const auto id = static_cast<TransformId>(_indices.size());
+  Resize(index + 1);
+  _ids.push_back(id);
+  _indices.push_back(index);
+
+  if (parent != NO_TRANSFORM) {
+    _parents[index] = _indices[parent];
+    _depths[index] = _depths[_parents[index]] + 1;
+  }
+  // It doesn't come from anywhere, so there is nothing to interpolate
+  _current.Set(index, local);
+  _previous.Set(index, local);
+  _structureChanged = true;
+  return id;
+}
+
+void TransformHierarchy::Sort() {
+  const auto count = static_cast<uint32_t>(_ids.size());
+
+  // Children of each node, in the current order
+  std::vector<uint32_t> childStarts(count + 1, 0);
+  for (uint32_t i = 0; i < count; i++) {
+    if (_parents[i] != NO_TRANSFORM) {
+      childStarts[_parents[i] + 1]++;
+    }
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    childStarts[i + 1] += childStarts[i];
+  }
+  std::vector<uint32_t> children(count);
+  std::vector<uint32_t> cursors(childStarts.begin(), childStarts.end() - 1);
+  for (uint32_t i = 0; i < count; i++) {
+    if (_parents[i] != NO_TRANSFORM) {
+      children[cursors[_parents[i]]++] = i;
+    }
+  }
+
+  // Breadth first order: the roots, then the children of each node in that order.
+  // Siblings stay next to each other, and so do the nodes they share as parent.
+  std::vector<uint32_t> order;
+  order.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    if (_parents[i] == NO_TRANSFORM) {
+      order.push_back(i);
+    }
+  }
+  for (size_t o = 0; o < order.size(); o++) {
+    for (uint32_t c = childStarts[order[o]]; c < childStarts[order[o] + 1]; c++) {
+      order.push_back(children[c]);
+    }
+  }
+
+  // Move every node to its new place
+  std::vector<uint32_t> newIndices(count);
+  for (uint32_t i = 0; i < count; i++) {
+    newIndices[order[i]] = i;
+  }
+  auto permute = [&order, count](auto &values, auto...) {
+    const auto oldValues = values;
+    for (uint32_t i = 0; i < count; i++) {
+      values[i] = oldValues[order[i]];
+    }
+  };
+  _current.ForEachComponent(permute);
+  _previous.ForEachComponent(permute);
+  permute(_depths);
+  permute(_dirty);
+  permute(_interpolated);
+  permute(_worldMatrices);
+  permute(_ids);
+  permute(_parents);
+  for (uint32_t i = 0; i < count; i++) {
+    if (_parents[i] != NO_TRANSFORM) {
+      _parents[i] = newIndices[_parents[i]];
+    }
+    _indices[_ids[i]] = i;
+  }
+
+  // Depths are increasing in breadth first order
+  _levelStarts.clear();
+  for (uint32_t i = 0; i < count; i++) {
+    while (_levelStarts.size() <= _depths[i]) {
+      _levelStarts.push_back(i);
+    }
+  }
+  _levelStarts.push_back(count);
+}
+
+// ==== World matrices ====
+
+void TransformHierarchy::Update(float alpha) {
+  if (_structureChanged) {
+    Sort();
+    _structureChanged = false;
+  }
+
+  for (size_t level = 0; level + 1 < _levelStarts.size(); level++) {
+    const uint32_t begin = _levelStarts[level];
+    const uint32_t end = _levelStarts[level + 1];
+
+    // A node moves with its parent, which is in the previous level
+    for (uint32_t i = begin; i < end; i++) {
+      _dirty[i] |= _interpolated[i];
+      if (_parents[i] != NO_TRANSFORM) {
+        _dirty[i] |= _dirty[_parents[i]];
+      }
+    }
+
+    // Groups are aligned in the SoA arrays, and may overlap the previous or the next level
+    for (uint32_t group = begin / GROUP_SIZE * GROUP_SIZE; group < end; group += GROUP_SIZE) {
+      const uint32_t groupBegin = std::max(group, begin);
+      const uint32_t groupEnd = std::min(group + GROUP_SIZE, end);
+      if (std::any_of(_dirty.begin() + groupBegin, _dirty.begin() + groupEnd, [](uint8_t d) { return d; })) {
+        ComputeGroup(group, groupBegin, groupEnd, alpha);
+      }
+    }
+  }
+  std::fill(_dirty.begin(), _dirty.end(), 0);
+}
+
+void TransformHierarchy::ComputeGroup(uint32_t first, uint32_t begin, uint32_t end, float alpha) {
+  LocalGroup local;
+
+#ifdef TRANSFORM_SSE
+  // Interpolate between the two ticks. Written so that alpha = 1 gives exactly the current transform.
+  const __m128 currentWeight = _mm_set1_ps(alpha);
+  const __m128 previousWeight = _mm_set1_ps(1.0f - alpha);
+  auto load = [first](const std::vector<float> &values) { return _mm_loadu_ps(&values[first]); };
+  auto lerp = [&](const __m128 previous, const __m128 current) {
+    return _mm_add_ps(_mm_mul_ps(previous, previousWeight), _mm_mul_ps(current, currentWeight));
+  };
+
+  // Rotations are interpolated along the shortest path, then normalized
+  const __m128 px = load(_previous.rotationX), py = load(_previous.rotationY);
+  const __m128 pz = load(_previous.rotationZ), pw = load(_previous.rotationW);
+  __m128 cx = load(_current.rotationX), cy = load(_current.rotationY);
+  __m128 cz = load(_current.rotationZ), cw = load(_current.rotationW);
+  const __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, cx), _mm_mul_ps(py, cy)),
+                                _mm_add_ps(_mm_mul_ps(pz, cz), _mm_mul_ps(pw, cw)));
+  const __m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+  cx = _mm_xor_ps(cx, flip);
+  cy = _mm_xor_ps(cy, flip);
+  cz = _mm_xor_ps(cz, flip);
+  cw = _mm_xor_ps(cw, flip);
+  __m128 x = lerp(px, cx), y = lerp(py, cy), z = lerp(pz, cz), w = lerp(pw, cw);
+  const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+                                               _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w))));
+  x = _mm_div_ps(x, length);
+  y = _mm_div_ps(y, length);
+  z = _mm_div_ps(z, length);
+  w = _mm_div_ps(w, length);
+
+  // Rotation matrix from the quaternions, scaled per column
+  const __m128 x2 = _mm_add_ps(x, x);
+  const __m128 y2 = _mm_add_ps(y, y);
+  const __m128 z2 = _mm_add_ps(z, z);
+  const __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+  const __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+  const __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 scaleX = lerp(load(_previous.scaleX), load(_current.scaleX));
+  const __m128 scaleY = lerp(load(_previous.scaleY), load(_current.scaleY));
+  const __m128 scaleZ = lerp(load(_previous.scaleZ), load(_current.scaleZ));
+
+  _mm_storeu_ps(local.columns[0][0], _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), scaleX));
+  _mm_storeu_ps(local.columns[0][1], _mm_mul_ps(_mm_add_ps(xy, wz), scaleX));
+  _mm_storeu_ps(local.columns[0][2], _mm_mul_ps(_mm_sub_ps(xz, wy), scaleX));
+  _mm_storeu_ps(local.columns[1][0], _mm_mul_ps(_mm_sub_ps(xy, wz), scaleY));
+  _mm_storeu_ps(local.columns[1][1], _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), scaleY));
+  _mm_storeu_ps(local.columns[1][2], _mm_mul_ps(_mm_add_ps(yz, wx), scaleY));
+  _mm_storeu_ps(local.columns[2][0], _mm_mul_ps(_mm_add_ps(xz, wy), scaleZ));
+  _mm_storeu_ps(local.columns[2][1], _mm_mul_ps(_mm_sub_ps(yz, wx), scaleZ));
+  _mm_storeu_ps(local.columns[2][2], _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), scaleZ));
+  _mm_storeu_ps(local.columns[3][0], lerp(load(_previous.positionX), load(_current.positionX)));
+  _mm_storeu_ps(local.columns[3][1], lerp(load(_previous.positionY), load(_current.positionY)));
+  _mm_storeu_ps(local.columns[3][2], lerp(load(_previous.positionZ), load(_current.positionZ)));
+
+  // World matrix of each node: parent * local, one column at a time
+  for (uint32_t i = begin; i < end; i++) {
+    const uint32_t lane = i - first;
+    const float *parent = &(_parents[i] == NO_TRANSFORM ? IDENTITY : _worldMatrices[_parents[i]])[0][0];
+    const __m128 p0 = _mm_loadu_ps(parent);
+    const __m128 p1 = _mm_loadu_ps(parent + 4);
+    const __m128 p2 = _mm_loadu_ps(parent + 8);
+    const __m128 p3 = _mm_loadu_ps(parent + 12);
+    float *world = &_worldMatrices[i][0][0];
+    for (uint32_t c = 0; c < 4; c++) {
+      __m128 column = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p0, _mm_set1_ps(local.columns[c][0][lane])),
+                                            _mm_mul_ps(p1, _mm_set1_ps(local.columns[c][1][lane]))),
+                                 _mm_mul_ps(p2, _mm_set1_ps(local.columns[c][2][lane])));
+      if (c == 3) {
+        column = _mm_add_ps(column, p3);
+      }
+      _mm_storeu_ps(world + c * 4, column);
+    }
+  }
+#else
+  auto lerp = [alpha](float previous, float current) { return previous * (1.0f - alpha) + current * alpha; };
+  for (uint32_t lane = 0; lane < GROUP_SIZE; lane++) {
+    const uint32_t i = first + lane;
+
+    // Rotations are interpolated along the shortest path, then normalized
+    const float dot = _previous.rotationX[i] * _current.rotationX[i] +
+                      _previous.rotationY[i] * _current.rotationY[i] +
+                      _previous.rotationZ[i] * _current.rotationZ[i] +
+                      _previous.rotationW[i] * _current.rotationW[i];
+    const float sign = dot < 0.0f ? -1.0f : 1.0f;
+    float x = lerp(_previous.rotationX[i], sign * _current.rotationX[i]);
+    float y = lerp(_previous.rotationY[i], sign * _current.rotationY[i]);
+    float z = lerp(_previous.rotationZ[i], sign * _current.rotationZ[i]);
+    float w = lerp(_previous.rotationW[i], sign * _current.rotationW[i]);
+    const float length = std::sqrt(x * x + y * y + z * z + w * w);
+    x /= length;
+    y /= length;
+    z /= length;
+    w /= length;
+
+    const float scaleX = lerp(_previous.scaleX[i], _current.scaleX[i]);
+    const float scaleY = lerp(_previous.scaleY[i], _current.scaleY[i]);
+    const float scaleZ = lerp(_previous.scaleZ[i], _current.scaleZ[i]);
+    local.columns[0][0][lane] = (1.0f - 2.0f * (y * y + z * z)) * scaleX;
+    local.columns[0][1][lane] = 2.0f * (x * y + w * z) * scaleX;
+    local.columns[0][2][lane] = 2.0f * (x * z - w * y) * scaleX;
+    local.columns[1][0][lane] = 2.0f * (x * y - w * z) * scaleY;
+    local.columns[1][1][lane] = (1.0f - 2.0f * (x * x + z * z)) * scaleY;
+    local.columns[1][2][lane] = 2.0f * (y * z + w * x) * scaleY;
+    local.columns[2][0][lane] = 2.0f * (x * z + w * y) * scaleZ;
+    local.columns[2][1][lane] = 2.0f * (y * z - w * x) * scaleZ;
+    local.columns[2][2][lane] = (1.0f - 2.0f * (x * x + y * y)) * scaleZ;
+    local.columns[3][0][lane] = lerp(_previous.positionX[i], _current.positionX[i]);
+    local.columns[3][1][lane] = lerp(_previous.positionY[i], _current.positionY[i]);
+    local.columns[3][2][lane] = lerp(_previous.positionZ[i], _current.positionZ[i]);
+  }
+
+  for (uint32_t i = begin; i < end; i++) {
+    const uint32_t lane = i - first;
+    const glm::mat4 &parent = _parents[i] == NO_TRANSFORM ? IDENTITY : _worldMatrices[_parents[i]];
+    glm::mat4 &world = _worldMatrices[i];
+    for (uint32_t c = 0; c < 4; c++) {
+      for (uint32_t r = 0; r < 4; r++) {
+        world[c][r] = parent[0][r] * local.columns[c][0][lane] + parent[1][r] * local.columns[c][1][lane] +
+                      parent[2][r] * local.columns[c][2][lane] + (c == 3 ? parent[3][r] : 0.0f);
+      }
+    }
+  }
+#endif
+}
+
+const glm::mat4 &TransformHierarchy::GetWorldMatrix(TransformId id) const {
+  return _worldMatrices[_indices[id]];
+}
+
+size_t TransformHierarchy::GetSize() const { return _ids.size(); }
@@ -0,0 +1,96 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <vector>
+
+/** Stable handle of a node of a TransformHierarchy */
+using TransformId = uint32_t;
+constexpr TransformId NO_TRANSFORM = ~0u;
+
+/** Transform of a node relative to its parent */
+struct Transform {
+  glm::vec3 position{0.0f};
+  glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
+  glm::vec3 scale{1.0f};
+};
+
+/**
+ * Parent/child hierarchy of transforms.
+ *
+ * Local transforms are stored as position, rotation and scale in SoA layout, with the nodes sorted breadth
+ * first: every level comes after the one of its parents, so a single pass computes the world matrices.
+ * The local matrices of 4 nodes are computed at once with SSE, and only the groups containing a node
+ * changed since the last update, or whose parent changed, are recomputed.
+ *
+ * The local transforms of the previous simulation tick are kept, so that the world matrices can be
+ * interpolated between two ticks.
+ */
+class TransformHierarchy {
+private:
+  /**
+   * Local transforms, indexed by position in the breadth first order.
+   * Padded to a multiple of 4 nodes with identity transforms, so that SIMD groups never read past the end.
+   */
+  struct LocalTransforms {
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+    std::vector<float> scaleX, scaleY, scaleZ;
+
+    /** Calls function(array, identityValue) for each component */
+    template <class F> void ForEachComponent(F &&function);
+    void Set(uint32_t index, const Transform &transform);
+  };
+
+  /** Transforms at the end of the current tick, and at its start */
+  LocalTransforms _current;
+  LocalTransforms _previous;
+  /** Index of the parent of each node, or NO_TRANSFORM for roots */
+  std::vector<uint32_t> _parents;
+  std::vector<uint32_t> _depths;
+  /** Was the local transform changed since the last update ? */
+  std::vector<uint8_t> _dirty;
+  /** Was the local transform changed during the current tick ? Its world matrix then depends on alpha. */
+  std::vector<uint8_t> _interpolated;
+  std::vector<glm::mat4> _worldMatrices;
+  /** First index of each level, followed by the node count */
+  std::vector<uint32_t> _levelStarts;
+
+  /** Index of each node from its id, and id of each node from its index */
+  std::vector<uint32_t> _indices;
+  std::vector<TransformId> _ids;
+  /** Were nodes added since the last sort ? */
+  bool _structureChanged = false;
+
+  void Resize(size_t nodeCount);
+  /** Sorts the nodes breadth first, and finds the levels */
+  void Sort();
+  /** Recomputes the world matrices of the nodes of the group starting at first that are in [begin, end) */
+  void ComputeGroup(uint32_t first, uint32_t begin, uint32_t end, float alpha);
+
+public:
+  /** Adds a node. Its parent must already exist. */
+  TransformId Add(const Transform &local, TransformId parent = NO_TRANSFORM);
+  /** Sets the local transform of a node. Its world matrix and the ones below it change in the next Update. */
+  void SetLocal(TransformId id, const Transform &local);
+  /** Local transform at the end of the current tick */
+  [[nodiscard]] Transform GetLocal(TransformId id) const;
+
+  /** Starts a simulation tick: the current transforms become the previous ones */
+  void BeginTick();
+  /**
+   * Recomputes the world matrices of the changed nodes and of their descendants.
+   * @param alpha position between the previous tick (0) and the current one (1)
+   */
+  void Update(float alpha = 1.0f);
+  /** World matrix of the node, as of the last update */
+  [[nodiscard]] const glm::mat4 &GetWorldMatrix(TransformId id) const;
+  [[nodiscard]] size_t GetSize() const;
+};
@@ -0,0 +1,40 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "UniformAllocator.h"
+#include <cstring>
+#include <stdexcept>
+
+void UniformAllocator::Init(VmaAllocator allocator, const AllocatedBuffer &buffer, vk::DeviceSize frameSize,
+                            vk::DeviceSize alignment) {
+  _buffer = buffer;
+  _frameSize = frameSize;
+  _alignment = alignment > 0 ? alignment : 1;
+
+  VmaAllocationInfo allocationInfo;
+  vmaGetAllocationInfo(allocator, _buffer.allocation, &allocationInfo);
+  _mappedData = static_cast<char *>(allocationInfo.pMappedData);
+  if (!_mappedData)
+    throw std::runtime_error("The uniform buffer must be persistently mapped");
+}
+
+void UniformAllocator::BeginFrame(uint32_t frameIndex) {
+  _frameStart = frameIndex * _frameSize;
+  _head = _frameStart;
+}
+
+uint32_t UniformAllocator::Push(const void *data, size_t size) {
+  // Dynamic offsets must be multiples of the alignment
+  const vk::DeviceSize offset = (_head + _alignment - 1) & ~(_alignment - 1);
+  if (offset + size > _frameStart + _frameSize)
+    throw std::runtime_error("Uniform buffer of the frame is full");
+
+  memcpy(_mappedData + offset, data, size);
+  _head = offset + size;
+  return static_cast<uint32_t>(offset);
+}
+
+vk::Buffer UniformAllocator::GetBuffer() const { return _buffer.buffer; }
+
+vk::DeviceSize UniformAllocator::GetUsedSize() const { return _head - _frameStart; }
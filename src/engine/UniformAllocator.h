@@ -0,0 +1,43 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include "vk_types.h"
+
+/**
+ * Linear allocator of uniform blocks, in a persistently mapped buffer split in one region per frame in
+ * flight.
+ *
+ * The blocks are bound with dynamic offsets, so a frame can write as many camera or scene blocks as it has
+ * views. The region of a frame is reset when the frame starts, once its fence has signaled.
+ */
+class UniformAllocator {
+private:
+  AllocatedBuffer _buffer;
+  char *_mappedData = nullptr;
+  vk::DeviceSize _alignment = 0;
+  vk::DeviceSize _frameSize = 0;
+  /** Start of the region of the current frame, and start of its free space */
+  vk::DeviceSize _frameStart = 0;
+  vk::DeviceSize _head = 0;
+
+public:
+  /**
+   * @param buffer uniform buffer of frameCount * frameSize bytes, created as mapped
+   * @param alignment minUniformBufferOffsetAlignment of the GPU
+   */
+  void Init(VmaAllocator allocator, const AllocatedBuffer &buffer, vk::DeviceSize frameSize,
+            vk::DeviceSize alignment);
+
+  /** Resets the region of the frame. Its fence must have signaled. */
+  void BeginFrame(uint32_t frameIndex);
+  /** Copies a block in the region of the current frame, and returns its dynamic offset. Throws if full. */
+  uint32_t Push(const void *data, size_t size);
+  template <class T> uint32_t Push(const T &data) { return Push(&data, sizeof(T)); }
+
+  [[nodiscard]] vk::Buffer GetBuffer() const;
+  /** Bytes written in the current frame, padding included */
+  [[nodiscard]] vk::DeviceSize GetUsedSize() const;
+};
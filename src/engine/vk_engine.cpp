@@ -3,14 +3,26 @@
 //
 
 #include "vk_engine.h"
+#include "ObjectData.h"
+#include "SceneCooking.h"
 
 #include <SDL.h>
 #include <SDL_vulkan.h>
 #include <VkBootstrap.h>
-#include <fstream>
+#include <algorithm>
+#include <array>
+#include <backends/imgui_impl_sdl.h>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <glm/gtc/packing.hpp>
 #include <glm/gtx/transform.hpp>
+#include <imgui.h>
 #include <iostream>
+#include <optional>
 #include <string>
+#include <thread>
 
 #include "vk_init.h"
 #include "vk_types.h"
@@ -20,7 +32,46 @@
 
 VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
 
+namespace {
+uint32_t PreviousPowerOfTwo(uint32_t value) {
+  uint32_t result = 1;
+  while (result * 2 <= value) {
+    result *= 2;
+  }
+  return result;
+}
+
+/**
+ * Extracts the planes of the frustum from the rows of the view projection matrix.
+ * They are normalized, so that the shaders can compute distances with them.
+ */
+void ComputeFrustumPlanes(const glm::mat4 &viewProj, glm::vec4 planes[6]) {
+  const glm::mat4 rows = glm::transpose(viewProj);
+  planes[0] = rows[3] + rows[0];
+  planes[1] = rows[3] - rows[0];
+  planes[2] = rows[3] + rows[1];
+  planes[3] = rows[3] - rows[1];
+  planes[4] = rows[3] + rows[2];
+  planes[5] = rows[3] - rows[2];
+  for (uint32_t p = 0; p < 6; p++) {
+    planes[p] /= glm::length(glm::vec3(planes[p]));
+  }
+}
+
+/** Box around the bounding sphere of the object, in world space */
+Aabb GetWorldBox(const RenderObject &object) {
+  const auto [center, radius] = GetWorldBounds(object);
+  return Aabb{
+      .min = center - glm::vec3(radius),
+      .max = center + glm::vec3(radius),
+  };
+}
+} // namespace
+
 void VulkanEngine::Init() {
+  PROFILE_THREAD("Main");
+  PROFILE_FUNCTION();
+
   // Initialize SDL
   SDL_Init(SDL_INIT_VIDEO);
 
@@ -29,6 +80,9 @@ void VulkanEngine::Init() {
   _window = SDL_CreateWindow("Back to Vulkan !", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
                              _windowExtent.width, _windowExtent.height, windowFlags);
 
+  // Start decoding textures on the worker threads, so that it overlaps with the rest of the initialization
+  StartTextureLoads();
+
   // Load the core Vulkan structures
   InitVulkan();
 
@@ -38,11 +92,8 @@ void VulkanEngine::Init() {
   // Initialize commands
   InitCommands();
 
-  // Initialize render pass
-  InitDefaultRenderPass();
-
-  // Initialize framebuffers
-  InitFramebuffers();
+  // Initialize the passes of the frame and their resources
+  InitRenderGraph();
 
   // Initialize synchronisation structures
   InitSyncStructures();
@@ -53,9 +104,21 @@ void VulkanEngine::Init() {
   // Initialize pipelines
   InitPipelines();
 
+  // Initialize the meshlet culling pass
+  InitMeshletCulling();
+
+  // Initialize the occlusion culling passes
+  InitOcclusionCulling();
+
   // Initialize meshes
   LoadMeshes();
 
+  // Upload the decoded textures
+  LoadTextures();
+
+  // Initialize the performance overlay
+  InitOverlay();
+
   // Initialize scene
   InitScene();
 
@@ -64,6 +127,7 @@ void VulkanEngine::Init() {
 }
 
 void VulkanEngine::InitVulkan() {
+  PROFILE_FUNCTION();
 
   // === Instance creation ===
 
@@ -120,10 +184,46 @@ void VulkanEngine::InitVulkan() {
   // Select a GPU
   // We want a GPU that can write to the SDL surface and supports Vulkan 1.1
   vkb::PhysicalDeviceSelector gpuSelector{vkbInstance};
-  auto vkbPhysicalDevice = gpuSelector.set_minimum_version(1, 1).set_surface(_surface).select().value();
+  // Descriptor indexing is used for the bindless mode if it is available
+  auto vkbPhysicalDevice = gpuSelector.set_minimum_version(1, 1)
+                               .set_surface(_surface)
+                               .add_desired_extension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)
+                               .add_desired_extension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)
+                               .select()
+                               .value();
+
+  // Enable the optional features that the GPU supports. The selection is done again to enable them.
+  // - Block compressed textures
+  // - Indirect draws with a first instance, to find the object of the draws written by the culling passes
+  // - Several draws in a single indirect call, to keep the instanced runs in one call with occlusion culling
+  auto supportedFeatures = vk::PhysicalDevice(vkbPhysicalDevice.physical_device).getFeatures();
+  _textureCompressionBC = supportedFeatures.textureCompressionBC;
+  _drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+  _multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+  if (_textureCompressionBC || _drawIndirectFirstInstance || _multiDrawIndirect) {
+    VkPhysicalDeviceFeatures requiredFeatures{};
+    requiredFeatures.textureCompressionBC = _textureCompressionBC;
+    requiredFeatures.drawIndirectFirstInstance = _drawIndirectFirstInstance;
+    requiredFeatures.multiDrawIndirect = _multiDrawIndirect;
+    vkbPhysicalDevice = gpuSelector.set_required_features(requiredFeatures).select().value();
+  }
+  _occlusionCulling = ENABLE_OCCLUSION_CULLING && _drawIndirectFirstInstance;
+
+  _bindless = ENABLE_BINDLESS && CheckBindlessSupport(vk::PhysicalDevice(vkbPhysicalDevice.physical_device));
 
   // Get logical device
   vkb::DeviceBuilder deviceBuilder{vkbPhysicalDevice};
+  // Enable the descriptor indexing features needed by the bindless mode
+  vk::PhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures{
+      .shaderSampledImageArrayNonUniformIndexing = true,
+      .descriptorBindingSampledImageUpdateAfterBind = true,
+      .descriptorBindingPartiallyBound = true,
+      .descriptorBindingVariableDescriptorCount = true,
+      .runtimeDescriptorArray = true,
+  };
+  if (_bindless) {
+    deviceBuilder.add_pNext(&descriptorIndexingFeatures);
+  }
   auto vkbDevice = deviceBuilder.build().value();
 
   // Save devices
@@ -165,7 +265,28 @@ void VulkanEngine::InitVulkan() {
       .pVulkanFunctions = &vulkanFunctions,
       .instance = _instance,
   };
+  // Let VMA ask the driver how much memory is available, if it can. Enabled by the GPU selection.
+  const bool memoryBudget = CheckExtensionSupport(_chosenGPU, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  if (memoryBudget) {
+    allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+    // Core in Vulkan 1.1
+    vulkanFunctions.vkGetPhysicalDeviceMemoryProperties2KHR =
+        VULKAN_HPP_DEFAULT_DISPATCHER.vkGetPhysicalDeviceMemoryProperties2;
+  }
   vmaCreateAllocator(&allocatorInfo, &_allocator);
+  _memoryTracker.Init(_allocator, memoryBudget);
+  _mainDeletionQueue.Init(_device, _allocator, &_memoryTracker);
+  _memoryPools.Init(_device, _allocator, &_memoryTracker);
+  // Pushed first so that the pools are destroyed after the resources allocated in them
+  _mainDeletionQueue.PushFunction([this]() { _memoryPools.Destroy(); });
+  std::vector<VmaPool> defragmentedPools;
+  for (uint32_t i = 0; i < POOL_TYPE_COUNT; i++) {
+    const auto type = static_cast<PoolType>(i);
+    if (_memoryPools.GetPolicy(type).defragmentable && _memoryPools.GetPool(type)) {
+      defragmentedPools.push_back(_memoryPools.GetPool(type));
+    }
+  }
+  _defragmenter.Init(_device, _allocator, &_mainDeletionQueue, std::move(defragmentedPools));
 
   // Get gpu properties
   _gpuProperties = _chosenGPU.getProperties();
@@ -173,9 +294,34 @@ void VulkanEngine::InitVulkan() {
             << _gpuProperties.limits.minUniformBufferOffsetAlignment << '\n';
 }
 
+bool VulkanEngine::CheckExtensionSupport(vk::PhysicalDevice physicalDevice, const char *extensionName) {
+  for (const auto &extension : physicalDevice.enumerateDeviceExtensionProperties()) {
+    if (strcmp(extension.extensionName, extensionName) == 0)
+      return true;
+  }
+  return false;
+}
+
+bool VulkanEngine::CheckBindlessSupport(vk::PhysicalDevice physicalDevice) {
+  // Check that the extension is available
+  if (!CheckExtensionSupport(physicalDevice, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))
+    return false;
+
+  // Check that the needed features are supported
+  auto features =
+      physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceDescriptorIndexingFeatures>();
+  auto &indexingFeatures = features.get<vk::PhysicalDeviceDescriptorIndexingFeatures>();
+  return indexingFeatures.shaderSampledImageArrayNonUniformIndexing &&
+         indexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+         indexingFeatures.descriptorBindingPartiallyBound &&
+         indexingFeatures.descriptorBindingVariableDescriptorCount && indexingFeatures.runtimeDescriptorArray;
+}
+
 void VulkanEngine::HandleSDLError() { std::cerr << "[SDL Error]\n" << SDL_GetError() << '\n'; }
 
 void VulkanEngine::InitSwapchain() {
+  PROFILE_FUNCTION();
+
   // Initialize swapchain with vkb
   vkb::SwapchainBuilder swapchainBuilder{_chosenGPU, _device, _surface};
   vk::SurfaceFormatKHR format{
@@ -222,37 +368,18 @@ void VulkanEngine::InitSwapchain() {
     _swapchainImageViews[i] = _device.createImageView(createInfo);
   }
 
-  // Create depth image
-  vk::Extent3D depthImageExtent = {
-      _windowExtent.width,
-      _windowExtent.height,
-      1,
-  };
+  // The depth image is created by the render graph
   _depthImageFormat = vk::Format::eD32Sfloat;
 
-  // Allocate image
-  auto imageCreateInfo = vkinit::ImageCreateInfo(
-      _depthImageFormat, vk::ImageUsageFlagBits::eDepthStencilAttachment, depthImageExtent);
-  VmaAllocationCreateInfo allocationCreateInfo{
-      .usage = VMA_MEMORY_USAGE_GPU_ONLY,
-      .requiredFlags = static_cast<VkMemoryPropertyFlags>(vk::MemoryPropertyFlagBits::eDeviceLocal),
-  };
-  vmaCreateImage(_allocator, (VkImageCreateInfo *)&imageCreateInfo, &allocationCreateInfo,
-                 (VkImage *)&_depthImage.image, &_depthImage.allocation, nullptr);
-
-  // Create image view for the depth image to use for rendering
-  auto imageViewCreateInfo =
-      vkinit::ImageViewCreateInfo(_depthImageFormat, _depthImage.image, vk::ImageAspectFlagBits::eDepth);
-  _depthImageView = _device.createImageView(imageViewCreateInfo);
-
   // Register deletion
-  _mainDeletionQueue.PushFunction([this]() {
-    _device.destroyImageView(_depthImageView);
-    vmaDestroyImage(_allocator, _depthImage.image, _depthImage.allocation);
-  });
+  for (auto view : _swapchainImageViews) {
+    _mainDeletionQueue.Push(view);
+  }
 }
 
 void VulkanEngine::InitCommands() {
+  PROFILE_FUNCTION();
+
   // Create a command pool
   vk::CommandPoolCreateInfo commandPoolCreateInfo{
       .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
@@ -270,120 +397,137 @@ void VulkanEngine::InitCommands() {
     };
     frame.mainCommandBuffer = _device.allocateCommandBuffers(commandBufferAllocateInfo)[0];
     // Register deletion
-    _mainDeletionQueue.PushFunction([this, frame]() { _device.destroyCommandPool(frame.commandPool); });
+    _mainDeletionQueue.Push(frame.commandPool);
   }
 
   // Init upload context
   _uploadContext.commandPool = _device.createCommandPool(commandPoolCreateInfo);
-  _mainDeletionQueue.PushFunction([this]() { _device.destroyCommandPool(_uploadContext.commandPool); });
-}
-
-void VulkanEngine::InitDefaultRenderPass() {
-  // Define the target
-  vk::AttachmentDescription colorAttachment{
-      // The attachment must use the same format as the swapchain
-      .format = _swapchainImageFormat,
-      // No multisampling, so 1 sample
-      .samples = vk::SampleCountFlagBits::e1,
-      // clear on load
-      .loadOp = vk::AttachmentLoadOp::eClear,
-      // Keep the attachment stored when the renderpass ends
-      .storeOp = vk::AttachmentStoreOp::eStore,
-      // No stencil
-      .stencilLoadOp = vk::AttachmentLoadOp::eDontCare,
-      .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
-      // Don't care about the starting layout of the attachment
-      .initialLayout = vk::ImageLayout::eUndefined,
-      // Once the renderpass ends, the image should be in a format ready for
-      // presenting
-      .finalLayout = vk::ImageLayout::ePresentSrcKHR,
-  };
-
-  // Reference to the attachment in the renderpass (sort of smart pointer)
-  vk::AttachmentReference colorAttachmentRef{
-      .attachment = 0, // Index of the colorAttachment in the renderpass
-      .layout = vk::ImageLayout::eColorAttachmentOptimal,
-  };
-
-  // Depth attachment
-  vk::AttachmentDescription depthAttachment{
-      // The attachment must use the same format as the swapchain
-      .format = _depthImageFormat,
-      // No multisampling, so 1 sample
-      .samples = vk::SampleCountFlagBits::e1,
-      .loadOp = vk::AttachmentLoadOp::eClear,
-      .storeOp = vk::AttachmentStoreOp::eStore,
-      .stencilLoadOp = vk::AttachmentLoadOp::eClear,
-      .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
-      // Don't care about the starting layout of the attachment
-      .initialLayout = vk::ImageLayout::eUndefined,
-      // Once the renderpass ends, the image should be in a format ready for
-      // presenting
-      .finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal,
-  };
-
-  // Reference to the attachment in the renderpass (sort of smart pointer)
-  vk::AttachmentReference depthAttachmentRef{
-      .attachment = 1, // Index of the colorAttachment in the renderpass
-      .layout = vk::ImageLayout::eDepthStencilAttachmentOptimal,
-  };
-
-  // Create the subpass
-  vk::SubpassDescription subpass{
-      .pipelineBindPoint = vk::PipelineBindPoint::eGraphics,
-      .colorAttachmentCount = 1,
-      .pColorAttachments = &colorAttachmentRef,
-      .pDepthStencilAttachment = &depthAttachmentRef,
-  };
-
-  // Create the render pass
-  vk::AttachmentDescription attachments[2] = {colorAttachment, depthAttachment};
-  vk::RenderPassCreateInfo renderPassCreateInfo{
-      .attachmentCount = 2,
-      .pAttachments = attachments,
-      .subpassCount = 1,
-      .pSubpasses = &subpass,
-  };
-  _renderPass = _device.createRenderPass(renderPassCreateInfo);
-
-  // Register deletion
-  _mainDeletionQueue.PushFunction([this]() { _device.destroyRenderPass(_renderPass); });
+  _mainDeletionQueue.Push(_uploadContext.commandPool);
+  _uploadContext.asyncCommandPool = _device.createCommandPool(commandPoolCreateInfo);
+  _mainDeletionQueue.Push(_uploadContext.asyncCommandPool);
 }
 
-void VulkanEngine::InitFramebuffers() {
-  // Create attachments
-  vk::ImageView attachments[2];
-  attachments[1] = _depthImageView;
+void VulkanEngine::InitRenderGraph() {
+  PROFILE_FUNCTION();
+
+  // Resources
+  _swapchainResource = _renderGraph.ImportImage(
+      "swapchain", _swapchainImageFormat, _windowExtent,
+      // The image is acquired before the color output, as the submission waits for it
+      RenderGraph::Access{
+          .stage = vk::PipelineStageFlagBits::eColorAttachmentOutput,
+          .access = {},
+          .layout = vk::ImageLayout::eUndefined,
+      },
+      vk::ImageLayout::ePresentSrcKHR);
+  _depthResource = _renderGraph.CreateImage("depth", _depthImageFormat, _windowExtent);
+  // Buffers of the current frame, written then read in the frame
+  const RenderGraph::Resource meshletDraws = _renderGraph.AddBuffer("meshlet draws and indices", false);
+  const RenderGraph::Resource occlusionDraws = _renderGraph.AddBuffer("occlusion draws", false);
+  constexpr vk::PipelineStageFlags drawStages =
+      vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput;
+  constexpr vk::AccessFlags drawAccess =
+      vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eIndexRead;
+  constexpr vk::AccessFlags cullAccess = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+
+  // Culling before the first render pass: compute can't run inside of it
+  const bool meshletCulling = ENABLE_MESHLET_CULLING && _drawIndirectFirstInstance;
+  if (meshletCulling) {
+    _renderGraph.AddPass("meshlet cull", RenderGraph::PassType::eCompute)
+        .WriteBuffer(meshletDraws, vk::PipelineStageFlagBits::eComputeShader,
+                     vk::AccessFlagBits::eShaderWrite)
+        .SetExecute([this](vk::CommandBuffer cmd) {
+          CullMeshlets(cmd, _renderables.data(), _renderables.size());
+        });
+  }
 
-  // Create the framebuffers
-  vk::FramebufferCreateInfo framebufferCreateInfo{
-      .renderPass = _renderPass,
-      .attachmentCount = 2,
-      .pAttachments = attachments,
-      .width = _windowExtent.width,
-      .height = _windowExtent.height,
-      .layers = 1,
-  };
+  RenderGraph::Resource visibility = 0;
+  if (_occlusionCulling) {
+    // The pyramid starts at the power of two below the window size, so that each level is exactly half of
+    // the previous one. The first level is built from a footprint of up to 3x3 depth texels.
+    _depthPyramidExtent = vk::Extent2D{
+        .width = PreviousPowerOfTwo(_windowExtent.width),
+        .height = PreviousPowerOfTwo(_windowExtent.height),
+    };
 
-  const uint32_t swapchainImageCount = _swapchainImages.size();
+    // Both are kept between frames, and were last used by the late culling of the previous frame
+    _depthPyramidResource = _renderGraph.ImportImage(
+        "depth pyramid", vk::Format::eR32Sfloat, _depthPyramidExtent,
+        RenderGraph::Access{
+            .stage = vk::PipelineStageFlagBits::eComputeShader,
+            .access = {},
+            .layout = vk::ImageLayout::eGeneral,
+        });
+    visibility = _renderGraph.AddBuffer("visibility", true,
+                                        RenderGraph::Access{
+                                            .stage = vk::PipelineStageFlagBits::eComputeShader,
+                                            .access = vk::AccessFlagBits::eShaderWrite,
+                                        });
+
+    // The early pass draws what was visible in the previous frame
+    _renderGraph.AddPass("early cull", RenderGraph::PassType::eCompute)
+        .ReadBuffer(visibility, vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead)
+        .WriteBuffer(occlusionDraws, vk::PipelineStageFlagBits::eComputeShader, cullAccess)
+        .SetExecute([this](vk::CommandBuffer cmd) {
+          CullObjects(cmd, _renderables.data(), _renderables.size(), DrawPass::eEarly);
+        });
+  }
 
-  // Init the framebuffers array
-  _framebuffers = std::vector<vk::Framebuffer>(swapchainImageCount);
-  for (uint32_t i = 0; i < swapchainImageCount; ++i) {
+  const DrawPass firstPass = _occlusionCulling ? DrawPass::eEarly : DrawPass::eAll;
+  auto mainPass =
+      _renderGraph.AddPass(_occlusionCulling ? "early" : "main", RenderGraph::PassType::eGraphics)
+          .AddColorAttachment(_swapchainResource, vk::AttachmentLoadOp::eClear)
+          .SetDepthAttachment(_depthResource, vk::AttachmentLoadOp::eClear)
+          .SetExecute([this, firstPass](vk::CommandBuffer cmd) {
+            DrawObjects(cmd, _renderables.data(), _renderables.size(), firstPass);
+          });
+  if (meshletCulling) {
+    mainPass.ReadBuffer(meshletDraws, drawStages, drawAccess);
+  }
 
-    // Link the corresponding image
-    attachments[0] = _swapchainImageViews[i];
-    // Create the framebuffer and store it in the array
-    _framebuffers[i] = _device.createFramebuffer(framebufferCreateInfo);
-    // Register deletion
-    _mainDeletionQueue.PushFunction([this, i]() {
-      _device.destroyFramebuffer(_framebuffers[i]);
-      _device.destroyImageView(_swapchainImageViews[i]);
-    });
+  // The late pass tests every object against the depth of the early pass, and draws the ones that were hidden
+  // in the previous frame but are now visible
+  if (_occlusionCulling) {
+    mainPass.ReadBuffer(occlusionDraws, drawStages, drawAccess);
+    _renderGraph.AddPass("depth pyramid", RenderGraph::PassType::eCompute)
+        .ReadImage(_depthResource, vk::PipelineStageFlagBits::eComputeShader)
+        .WriteImage(_depthPyramidResource, vk::PipelineStageFlagBits::eComputeShader)
+        .SetExecute([this](vk::CommandBuffer cmd) { BuildDepthPyramid(cmd); });
+    _renderGraph.AddPass("late cull", RenderGraph::PassType::eCompute)
+        .ReadImage(_depthPyramidResource, vk::PipelineStageFlagBits::eComputeShader,
+                   vk::ImageLayout::eGeneral)
+        .WriteBuffer(visibility, vk::PipelineStageFlagBits::eComputeShader, cullAccess)
+        .WriteBuffer(occlusionDraws, vk::PipelineStageFlagBits::eComputeShader, cullAccess)
+        .SetExecute([this](vk::CommandBuffer cmd) {
+          CullObjects(cmd, _renderables.data(), _renderables.size(), DrawPass::eLate);
+        });
+    _renderGraph.AddPass("late", RenderGraph::PassType::eGraphics)
+        .AddColorAttachment(_swapchainResource, vk::AttachmentLoadOp::eLoad)
+        .SetDepthAttachment(_depthResource, vk::AttachmentLoadOp::eLoad)
+        .ReadBuffer(occlusionDraws, drawStages, drawAccess)
+        .SetExecute([this](vk::CommandBuffer cmd) {
+          DrawObjects(cmd, _renderables.data(), _renderables.size(), DrawPass::eLate);
+        });
   }
+
+  // The overlay is drawn over the finished frame
+  _renderGraph.AddPass("overlay", RenderGraph::PassType::eGraphics)
+      .AddColorAttachment(_swapchainResource, vk::AttachmentLoadOp::eLoad)
+      .SetExecute([this](vk::CommandBuffer cmd) { DrawOverlay(cmd); });
+
+  _renderGraph.SetClearValue(_depthResource, vk::ClearValue(vk::ClearDepthStencilValue{1.0f}));
+  _renderGraph.Compile(_device, _allocator, &_memoryTracker);
+
+  // Both graphics passes are compatible, so the pipelines can be used in either of them
+  _renderPass = _renderGraph.GetRenderPass(_occlusionCulling ? "early" : "main");
+
+  // Register deletion
+  _mainDeletionQueue.PushFunction([this]() { _renderGraph.Destroy(); });
 }
 
 void VulkanEngine::InitSyncStructures() {
+  PROFILE_FUNCTION();
+
   // Create render fence
   vk::FenceCreateInfo fenceCreateInfo{
       .flags = vk::FenceCreateFlagBits::eSignaled,
@@ -396,25 +540,39 @@ void VulkanEngine::InitSyncStructures() {
     frame.renderFence = _device.createFence(fenceCreateInfo);
 
     // Register deletion
-    _mainDeletionQueue.PushFunction([this, frame]() { _device.destroyFence(frame.renderFence); });
+    _mainDeletionQueue.Push(frame.renderFence);
 
     // Create semaphores
     frame.presentSemaphore = _device.createSemaphore(semaphoreCreateInfo);
     frame.renderSemaphore = _device.createSemaphore(semaphoreCreateInfo);
 
     // Register deletion
-    _mainDeletionQueue.PushFunction([this, frame]() {
-      _device.destroySemaphore(frame.presentSemaphore);
-      _device.destroySemaphore(frame.renderSemaphore);
-    });
+    _mainDeletionQueue.Push(frame.presentSemaphore);
+    _mainDeletionQueue.Push(frame.renderSemaphore);
   }
 
   // Init upload context
   _uploadContext.uploadFence = _device.createFence(vk::FenceCreateInfo{});
-  _mainDeletionQueue.PushFunction([this]() { _device.destroyFence(_uploadContext.uploadFence); });
+  _mainDeletionQueue.Push(_uploadContext.uploadFence);
+
+  // Timestamps around the commands of each frame, to measure its GPU time
+  const auto queueFamilies = _chosenGPU.getQueueFamilyProperties();
+  if (queueFamilies[_graphicsQueueFamily].timestampValidBits > 0 &&
+      _gpuProperties.limits.timestampPeriod > 0.0f) {
+    _timestampPool = _device.createQueryPool(vk::QueryPoolCreateInfo{
+        .queryType = vk::QueryType::eTimestamp,
+        .queryCount = 2 * FRAME_OVERLAP,
+    });
+    _mainDeletionQueue.PushFunction([this]() { _device.destroyQueryPool(_timestampPool); });
+  }
 }
 
 void VulkanEngine::InitDescriptors() {
+  PROFILE_FUNCTION();
+
+  // Init layout cache. Its layouts are destroyed after everything that uses them
+  _layoutCache.Init(_device);
+  _mainDeletionQueue.PushFunction([this]() { _layoutCache.Cleanup(); });
 
   // Init layouts
   auto globalSetLayout =
@@ -422,57 +580,61 @@ void VulkanEngine::InitDescriptors() {
           .AddBinding(vk::ShaderStageFlagBits::eVertex, vk::DescriptorType::eUniformBufferDynamic)
           .AddBinding(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment,
                       vk::DescriptorType::eUniformBufferDynamic)
-          .Build(_device, _mainDeletionQueue);
+          .Build(_layoutCache);
   _globalSetLayout = globalSetLayout.layout;
   auto objectSetLayout =
       vkinit::DescriptorSetLayoutBuilder()
           .AddBinding(vk::ShaderStageFlagBits::eVertex, vk::DescriptorType::eStorageBuffer)
           .AddBinding(vk::ShaderStageFlagBits::eFragment, vk::DescriptorType::eStorageBuffer)
-          .Build(_device, _mainDeletionQueue);
+          .Build(_layoutCache);
   _objectSetLayout = objectSetLayout.layout;
+  _textureSetLayout =
+      vkinit::DescriptorSetLayoutBuilder()
+          .AddBinding(vk::ShaderStageFlagBits::eFragment, vk::DescriptorType::eCombinedImageSampler)
+          .Build(_layoutCache);
 
   // Create the descriptor pool
   std::vector<vk::DescriptorPoolSize> sizes{
       {vk::DescriptorType::eUniformBuffer, 10},
       {vk::DescriptorType::eUniformBufferDynamic, 10},
-      {vk::DescriptorType::eStorageBuffer, 10},
+      {vk::DescriptorType::eStorageBuffer, 48},
+      {vk::DescriptorType::eCombinedImageSampler, 32},
+      {vk::DescriptorType::eStorageImage, 16},
   };
   vk::DescriptorPoolCreateInfo descriptorPoolCreateInfo{
-      .maxSets = 10,
+      .maxSets = 64,
       .poolSizeCount = static_cast<uint32_t>(sizes.size()),
       .pPoolSizes = sizes.data(),
   };
   _descriptorPool = _device.createDescriptorPool(descriptorPoolCreateInfo);
 
   // Register deletion
-  _mainDeletionQueue.PushFunction([this]() { _device.destroyDescriptorPool(_descriptorPool); });
-
-  // Init the scene data buffer
-  const size_t sceneParamBufferSize = FRAME_OVERLAP * PadUniformBufferSize(sizeof(GPUSceneData));
-  _sceneDataBuffer = CreateBuffer(sceneParamBufferSize, vk::BufferUsageFlagBits::eUniformBuffer,
-                                  VMA_MEMORY_USAGE_CPU_TO_GPU);
-  // Init camera buffers
-  const size_t cameraBufferSize = FRAME_OVERLAP * PadUniformBufferSize(sizeof(GPUCameraData));
-  _cameraBuffer =
-      CreateBuffer(cameraBufferSize, vk::BufferUsageFlagBits::eUniformBuffer, VMA_MEMORY_USAGE_CPU_TO_GPU);
-
-  // Allocate and write
+  _mainDeletionQueue.Push(_descriptorPool);
+
+  // Init the uniform buffer holding the camera and scene blocks, mapped once for the whole run
+  auto uniformBuffer =
+      CreateBuffer(FRAME_OVERLAP * UNIFORM_FRAME_SIZE, vk::BufferUsageFlagBits::eUniformBuffer,
+                   VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::ePerFrame, VMA_ALLOCATION_CREATE_MAPPED_BIT);
+  _uniformAllocator.Init(_allocator, uniformBuffer, UNIFORM_FRAME_SIZE,
+                         _gpuProperties.limits.minUniformBufferOffsetAlignment);
+
+  // Allocate and write. Both bindings use the same buffer, at the offsets given when binding the set.
   vkinit::DescriptorSetAllocator(_descriptorPool)
       .AddSetWithLayout(globalSetLayout, &_globalDescriptor)
       .Allocate(_device)
-      .AddBuffer(0, 0, _cameraBuffer.buffer, sizeof(GPUCameraData))
-      .AddBuffer(0, 1, _sceneDataBuffer.buffer, sizeof(GPUSceneData))
+      .AddBuffer(0, 0, uniformBuffer.buffer, sizeof(GPUCameraData))
+      .AddBuffer(0, 1, uniformBuffer.buffer, sizeof(GPUSceneData))
       .Write(_device);
 
   for (auto &frame : _frames) {
 
     // Init object buffers
-    const uint32_t MAX_OBJECTS = 10000;
-    frame.objectBuffer = CreateBuffer(sizeof(GPUObjectData) * MAX_OBJECTS,
-                                      vk::BufferUsageFlagBits::eStorageBuffer, VMA_MEMORY_USAGE_CPU_TO_GPU);
+    frame.objectBuffer =
+        CreateBuffer(sizeof(GPUObjectData) * MAX_OBJECTS, vk::BufferUsageFlagBits::eStorageBuffer,
+                     VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::ePerFrame);
     frame.objectColorBuffer =
         CreateBuffer(sizeof(ObjectColor) * MAX_OBJECTS, vk::BufferUsageFlagBits::eStorageBuffer,
-                     VMA_MEMORY_USAGE_CPU_TO_GPU);
+                     VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::ePerFrame);
 
     // Allocate descriptor sets
     vkinit::DescriptorSetAllocator(_descriptorPool)
@@ -484,102 +646,491 @@ void VulkanEngine::InitDescriptors() {
         .AddBuffer(0, 1, frame.objectColorBuffer.buffer, sizeof(ObjectColor) * MAX_OBJECTS)
         .Write(_device);
   }
+
+  if (_bindless) {
+    InitBindlessDescriptors();
+  }
 }
 
-void VulkanEngine::InitPipelines() {
+void VulkanEngine::InitBindlessDescriptors() {
+  PROFILE_FUNCTION();
+
+  // Clamp the size of the texture array to what the GPU supports
+  auto properties = _chosenGPU.getProperties2<vk::PhysicalDeviceProperties2,
+                                              vk::PhysicalDeviceDescriptorIndexingProperties>();
+  _maxBindlessTextures =
+      std::min(MAX_BINDLESS_TEXTURES, properties.get<vk::PhysicalDeviceDescriptorIndexingProperties>()
+                                          .maxDescriptorSetUpdateAfterBindSampledImages);
+
+  // The set contains the material parameters and a large array of textures, that can be updated while bound.
+  // The texture array must be the last binding since it has a variable size.
+  auto bindlessSetLayout =
+      vkinit::DescriptorSetLayoutBuilder()
+          .WithFlags(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool)
+          .AddBinding(vk::ShaderStageFlagBits::eFragment, vk::DescriptorType::eStorageBuffer)
+          .AddBinding(vk::ShaderStageFlagBits::eFragment, vk::DescriptorType::eCombinedImageSampler,
+                      _maxBindlessTextures,
+                      vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+                          vk::DescriptorBindingFlagBits::ePartiallyBound |
+                          vk::DescriptorBindingFlagBits::eVariableDescriptorCount)
+          .Build(_layoutCache);
+  _bindlessSetLayout = bindlessSetLayout.layout;
+
+  // Create a pool allowing update after bind
+  std::vector<vk::DescriptorPoolSize> sizes{
+      {vk::DescriptorType::eStorageBuffer, 1},
+      {vk::DescriptorType::eCombinedImageSampler, _maxBindlessTextures},
+  };
+  vk::DescriptorPoolCreateInfo descriptorPoolCreateInfo{
+      .flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
+      .maxSets = 1,
+      .poolSizeCount = static_cast<uint32_t>(sizes.size()),
+      .pPoolSizes = sizes.data(),
+  };
+  _bindlessPool = _device.createDescriptorPool(descriptorPoolCreateInfo);
+  _mainDeletionQueue.Push(_bindlessPool);
 
-  // Load shaders
-  auto defaultLitFragShader = LoadShaderModule("../shaders/default_lit.frag.spv");
-  auto redTriangleFragShader = LoadShaderModule("../shaders/triangle.frag.spv");
-  auto meshVertShader = LoadShaderModule("../shaders/tri_mesh.vert.spv");
+  // Allocate the set with the variable texture count
+  vk::DescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo{
+      .descriptorSetCount = 1,
+      .pDescriptorCounts = &_maxBindlessTextures,
+  };
+  vk::DescriptorSetAllocateInfo setAllocInfo{
+      .pNext = &variableCountInfo,
+      .descriptorPool = _bindlessPool,
+      .descriptorSetCount = 1,
+      .pSetLayouts = &_bindlessSetLayout,
+  };
+  _bindlessDescriptor = _device.allocateDescriptorSets(setAllocInfo)[0];
+
+  // Create the material buffer and link it
+  _materialBuffer =
+      CreateBuffer(sizeof(GPUMaterialData) * MAX_MATERIALS, vk::BufferUsageFlagBits::eStorageBuffer,
+                   VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::eTextures);
+  vk::DescriptorBufferInfo materialBufferInfo{
+      .buffer = _materialBuffer.buffer,
+      .offset = 0,
+      .range = sizeof(GPUMaterialData) * MAX_MATERIALS,
+  };
+  vk::WriteDescriptorSet materialWrite{
+      .dstSet = _bindlessDescriptor,
+      .dstBinding = 0,
+      .descriptorCount = 1,
+      .descriptorType = vk::DescriptorType::eStorageBuffer,
+      .pBufferInfo = &materialBufferInfo,
+  };
+  _device.updateDescriptorSets(materialWrite, nullptr);
+}
+
+uint32_t VulkanEngine::RegisterBindlessTexture(vk::ImageView imageView, vk::Sampler sampler) {
+  if (_bindlessTextureCount >= _maxBindlessTextures)
+    throw std::runtime_error("Bindless texture array is full");
+
+  // Write the texture in the next free slot of the array. The set is update-after-bind, so this is
+  // allowed even if it is bound in a command buffer being recorded.
+  uint32_t index = _bindlessTextureCount++;
+  vk::DescriptorImageInfo imageInfo{
+      .sampler = sampler,
+      .imageView = imageView,
+      .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+  };
+  vk::WriteDescriptorSet write{
+      .dstSet = _bindlessDescriptor,
+      .dstBinding = 1,
+      .dstArrayElement = index,
+      .descriptorCount = 1,
+      .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+      .pImageInfo = &imageInfo,
+  };
+  _device.updateDescriptorSets(write, nullptr);
+  return index;
+}
 
-  // Create pipelines
+void VulkanEngine::InitPipelines() {
+  PROFILE_FUNCTION();
 
-  VertexInputDescription vertexDescription = Vertex::GetVertexDescription();
+  // Every material pipeline draws meshes in the first graphics pass
+  _pipelineCache.Init(_device, _renderPass, _windowExtent, Vertex::GetVertexDescription());
+  _mainDeletionQueue.PushFunction([this]() { _pipelineCache.Cleanup(); });
 
-  // Create the mesh pipeline layout
-  auto meshPipelineLayoutCreateInfo = vkinit::PipelineLayoutCreateInfo();
+  // Get the mesh pipeline layout from the cache
   constexpr vk::PushConstantRange pushConstants{
       .stageFlags = vk::ShaderStageFlagBits::eVertex,
       .offset = 0,
       .size = sizeof(MeshPushConstants),
   };
-  meshPipelineLayoutCreateInfo.pPushConstantRanges = &pushConstants;
-  meshPipelineLayoutCreateInfo.pushConstantRangeCount = 1;
-  vk::DescriptorSetLayout layouts[] = {_globalSetLayout, _objectSetLayout};
-  meshPipelineLayoutCreateInfo.pSetLayouts = layouts;
-  meshPipelineLayoutCreateInfo.setLayoutCount = 2;
-  auto meshPipelineLayout = _device.createPipelineLayout(meshPipelineLayoutCreateInfo);
-
-  // Create the mesh pipeline
-  auto meshPipeline = PipelineBuilder()
-                          .WithPipelineLayout(meshPipelineLayout)
-                          .GetDefaultsForExtent(_windowExtent)
-                          .AddShaderStage(vk::ShaderStageFlagBits::eVertex, meshVertShader)
-                          .AddShaderStage(vk::ShaderStageFlagBits::eFragment, defaultLitFragShader)
-                          .WithVertexInput(vertexDescription)
-                          .WithDepthTestingSettings(true, true, vk::CompareOp::eLessOrEqual)
-                          .Build(_device, _renderPass);
-
-  // Create the red mesh pipeline
-  auto redMeshPipeline = PipelineBuilder()
-                             .WithPipelineLayout(meshPipelineLayout)
-                             .GetDefaultsForExtent(_windowExtent)
-                             .AddShaderStage(vk::ShaderStageFlagBits::eVertex, meshVertShader)
-                             .AddShaderStage(vk::ShaderStageFlagBits::eFragment, redTriangleFragShader)
-                             .WithVertexInput(vertexDescription)
-                             .WithDepthTestingSettings(true, true, vk::CompareOp::eLessOrEqual)
-                             .Build(_device, _renderPass);
-
-  // Save materials
-  CreateMaterial(meshPipeline, meshPipelineLayout, "default");
-  CreateMaterial(redMeshPipeline, meshPipelineLayout, "red");
-
-  // Destroy the shader modules as they are not needed anymore
-  _device.destroyShaderModule(defaultLitFragShader);
-  _device.destroyShaderModule(meshVertShader);
-  _device.destroyShaderModule(redTriangleFragShader);
+  auto meshPipelineLayout =
+      _layoutCache.CreatePipelineLayout({_globalSetLayout, _objectSetLayout}, {pushConstants});
+
+  // Materials are variants of a few shader templates. Nothing is compiled here: the cache compiles each
+  // unique state the first time a material using it is drawn.
+  const PipelineState litState{
+      .vertexShader = "../shaders/tri_mesh.vert.spv",
+      .fragmentShader = "../shaders/default_lit.frag.spv",
+      .layout = meshPipelineLayout,
+  };
 
-  // Register deletion
-  _mainDeletionQueue.PushFunction([this, meshPipeline, redMeshPipeline, meshPipelineLayout]() {
-    // Destroy pipelines
-    _device.destroyPipeline(meshPipeline);
-    _device.destroyPipeline(redMeshPipeline);
+  // In bindless mode, both materials share the same pipeline and only differ by their parameters
+  if (_bindless) {
+    PipelineState bindlessState = litState;
+    bindlessState.fragmentShader = "../shaders/default_lit_bindless.frag.spv";
+    bindlessState.layout = _layoutCache.CreatePipelineLayout(
+        {_globalSetLayout, _objectSetLayout, _bindlessSetLayout}, {pushConstants});
+
+    // Save materials
+    CreateMaterial(bindlessState, "default");
+    CreateMaterial(bindlessState, "red",
+                   GPUMaterialData{
+                       .albedo = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f),
+                       .textures = {NO_TEXTURE, MATERIAL_FLAG_UNLIT, 0, 0},
+                   });
+  } else {
+    // The parameters are baked in the pipeline with specialization constants
+    CreateMaterial(litState, "default");
+    CreateMaterial(litState.WithConstant(MATERIAL_CONSTANT_FLAGS, MATERIAL_FLAG_UNLIT)
+                       .WithConstant(MATERIAL_CONSTANT_ALBEDO + 1, 0.0f)
+                       .WithConstant(MATERIAL_CONSTANT_ALBEDO + 2, 0.0f),
+                   "red");
+
+    // The textured pipeline has its texture in a third set. Its material is created once the textures are loaded
+    _texturedPipelineState = litState;
+    _texturedPipelineState.fragmentShader = "../shaders/textured_lit.frag.spv";
+    _texturedPipelineState.layout = _layoutCache.CreatePipelineLayout(
+        {_globalSetLayout, _objectSetLayout, _textureSetLayout.layout}, {pushConstants});
+  }
+}
+
+void VulkanEngine::InitMeshletCulling() {
+  PROFILE_FUNCTION();
+
+  if (!ENABLE_MESHLET_CULLING || !_drawIndirectFirstInstance)
+    return;
+
+  // Per frame set: objects, output indices and draw commands
+  _meshletFrameSetLayout =
+      vkinit::DescriptorSetLayoutBuilder()
+          .AddBinding(vk::ShaderStageFlagBits::eCompute, vk::DescriptorType::eStorageBuffer)
+          .AddBinding(vk::ShaderStageFlagBits::eCompute, vk::DescriptorType::eStorageBuffer)
+          .AddBinding(vk::ShaderStageFlagBits::eCompute, vk::DescriptorType::eStorageBuffer)
+          .Build(_layoutCache);
+  // Per mesh set: meshlets and their indices
+  _meshletMeshSetLayout =
+      vkinit::DescriptorSetLayoutBuilder()
+          .AddBinding(vk::ShaderStageFlagBits::eCompute, vk::DescriptorType::eStorageBuffer)
+          .AddBinding(vk::ShaderStageFlagBits::eCompute, vk::DescriptorType::eStorageBuffer)
+          .Build(_layoutCache);
+
+  constexpr vk::PushConstantRange pushConstants{
+      .stageFlags = vk::ShaderStageFlagBits::eCompute,
+      .offset = 0,
+      .size = sizeof(MeshletCullConstants),
+  };
+  _meshletCullPipelineLayout = _layoutCache.CreatePipelineLayout(
+      {_meshletFrameSetLayout.layout, _meshletMeshSetLayout.layout}, {pushConstants});
+
+  _meshletCullPipeline =
+      CreateComputePipeline("../shaders/meshlet_cull.comp.spv", _meshletCullPipelineLayout);
+
+  const size_t objectBufferSize = sizeof(GPUObjectData) * MAX_OBJECTS;
+  const size_t outputIndexBufferSize = sizeof(uint32_t) * MAX_MESHLET_OUTPUT_INDICES;
+  const size_t drawBufferSize = sizeof(vk::DrawIndexedIndirectCommand) * MAX_MESHLET_DRAWS;
+  for (auto &frame : _frames) {
+    // Only the GPU touches the indices, but the CPU writes the draw commands
+    frame.meshletIndexBuffer =
+        CreateBuffer(outputIndexBufferSize,
+                     vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndexBuffer,
+                     VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::ePerFrame);
+    frame.meshletDrawBuffer = CreateBuffer(
+        drawBufferSize, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer,
+        VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::ePerFrame);
+
+    vkinit::DescriptorSetAllocator(_descriptorPool)
+        .AddSetWithLayout(_meshletFrameSetLayout, &frame.meshletCullDescriptor)
+        .Allocate(_device)
+        .AddBuffer(0, 0, frame.objectBuffer.buffer, objectBufferSize)
+        .AddBuffer(0, 1, frame.meshletIndexBuffer.buffer, outputIndexBufferSize)
+        .AddBuffer(0, 2, frame.meshletDrawBuffer.buffer, drawBufferSize)
+        .Write(_device);
+  }
+
+  // Register deletion. The layouts are owned by the layout cache
+  _mainDeletionQueue.Push(_meshletCullPipeline);
+}
+
+void VulkanEngine::InitOcclusionCulling() {
+  PROFILE_FUNCTION();
+
+  if (!_occlusionCulling)
+    return;
+
+  // The extent of the pyramid was chosen with the render graph
+  _depthPyramidLevels = imgutils::GetMipLevelCount(_depthPyramidExtent.width, _depthPyramidExtent.height);
+
+  // Create the pyramid image. It always stays in the general layout, since its levels are read and written
+  vk::Extent3D pyramidExtent{
+      .width = _depthPyramidExtent.width,
+      .height = _depthPyramidExtent.height,
+      .depth = 1,
+  };
+  const vk::ImageUsageFlags pyramidUsage = vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled;
+  auto imageCreateInfo =
+      vkinit::ImageCreateInfo(vk::Format::eR32Sfloat, pyramidUsage, pyramidExtent, _depthPyramidLevels);
+  _depthPyramid =
+      _memoryPools.CreateImage(imageCreateInfo, VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::eAttachments);
+
+  // One view for the culling, and one per level to build them
+  _depthPyramidView = _device.createImageView(vkinit::ImageViewCreateInfo(
+      vk::Format::eR32Sfloat, _depthPyramid.image, vk::ImageAspectFlagBits::eColor, _depthPyramidLevels));
+  for (uint32_t level = 0; level < _depthPyramidLevels; level++) {
+    auto viewCreateInfo = vkinit::ImageViewCreateInfo(vk::Format::eR32Sfloat, _depthPyramid.image,
+                                                      vk::ImageAspectFlagBits::eColor);
+    viewCreateInfo.subresourceRange.baseMipLevel = level;
+    _depthPyramidMips.push_back(_device.createImageView(viewCreateInfo));
+  }
+  // The shaders fetch texels directly, the filter doesn't matter
+  _depthPyramidSampler = _device.createSampler(
+      vkinit::SamplerCreateInfo(vk::Filter::eNearest, vk::SamplerAddressMode::eClampToEdge));
+
+  // Layouts
+  _depthReduceSetLayout =
+      vkinit::DescriptorSetLayoutBuilder()
+          .AddBinding(vk::ShaderStageFlagBits::eCompute, vk::DescriptorType::eCombinedImageSampler)
+          .AddBinding(vk::ShaderStageFlagBits::eCompute, vk::DescriptorType::eStorageImage)
+          .Build(_layoutCache);
+  _occlusionCullSetLayout =
+      vkinit::DescriptorSetLayoutBuilder()
+          .AddBinding(vk::ShaderStageFlagBits::eCompute, vk::DescriptorType::eStorageBuffer)
+          .AddBinding(vk::ShaderStageFlagBits::eCompute, vk::DescriptorType::eStorageBuffer)
+          .AddBinding(vk::ShaderStageFlagBits::eCompute, vk::DescriptorType::eStorageBuffer)
+          .AddBinding(vk::ShaderStageFlagBits::eCompute, vk::DescriptorType::eUniformBuffer)
+          .AddBinding(vk::ShaderStageFlagBits::eCompute, vk::DescriptorType::eCombinedImageSampler)
+          .Build(_layoutCache);
+  constexpr vk::PushConstantRange cullPushConstants{
+      .stageFlags = vk::ShaderStageFlagBits::eCompute,
+      .offset = 0,
+      .size = sizeof(uint32_t),
+  };
+  _depthReducePipelineLayout = _layoutCache.CreatePipelineLayout({_depthReduceSetLayout.layout}, {});
+  _occlusionCullPipelineLayout =
+      _layoutCache.CreatePipelineLayout({_occlusionCullSetLayout.layout}, {cullPushConstants});
+
+  // Pipelines
+  _depthReducePipeline =
+      CreateComputePipeline("../shaders/depth_reduce.comp.spv", _depthReducePipelineLayout);
+  _occlusionCullPipeline =
+      CreateComputePipeline("../shaders/occlusion_cull.comp.spv", _occlusionCullPipelineLayout);
+
+  // Each level is built from the previous one
+  _depthReduceDescriptors.resize(_depthPyramidLevels);
+  const vk::ImageView depthView = _renderGraph.GetImageView(_depthResource);
+  for (uint32_t level = 0; level < _depthPyramidLevels; level++) {
+    vk::ImageView source = level == 0 ? depthView : _depthPyramidMips[level - 1];
+    vk::ImageLayout sourceLayout =
+        level == 0 ? vk::ImageLayout::eShaderReadOnlyOptimal : vk::ImageLayout::eGeneral;
+    vkinit::DescriptorSetAllocator(_descriptorPool)
+        .AddSetWithLayout(_depthReduceSetLayout, &_depthReduceDescriptors[level])
+        .Allocate(_device)
+        .AddImage(0, 0, _depthPyramidSampler, source, sourceLayout)
+        .AddImage(0, 1, nullptr, _depthPyramidMips[level], vk::ImageLayout::eGeneral)
+        .Write(_device);
+  }
+
+  // Visibility of the objects, kept between frames
+  _visibilityBuffer =
+      CreateBuffer(sizeof(uint32_t) * MAX_OBJECTS,
+                   vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                   VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::ePerFrame);
+
+  const size_t objectBufferSize = sizeof(GPUObjectData) * MAX_OBJECTS;
+  const size_t drawBufferSize = sizeof(vk::DrawIndexedIndirectCommand) * MAX_OBJECTS * 2;
+  for (auto &frame : _frames) {
+    frame.occlusionDrawBuffer = CreateBuffer(
+        drawBufferSize, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer,
+        VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::ePerFrame);
+    frame.cullDataBuffer = CreateBuffer(sizeof(GPUCullData), vk::BufferUsageFlagBits::eUniformBuffer,
+                                        VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::ePerFrame);
+
+    vkinit::DescriptorSetAllocator(_descriptorPool)
+        .AddSetWithLayout(_occlusionCullSetLayout, &frame.occlusionCullDescriptor)
+        .Allocate(_device)
+        .AddBuffer(0, 0, frame.objectBuffer.buffer, objectBufferSize)
+        .AddBuffer(0, 1, frame.occlusionDrawBuffer.buffer, drawBufferSize)
+        .AddBuffer(0, 2, _visibilityBuffer.buffer, sizeof(uint32_t) * MAX_OBJECTS)
+        .AddBuffer(0, 3, frame.cullDataBuffer.buffer, sizeof(GPUCullData))
+        .AddImage(0, 4, _depthPyramidSampler, _depthPyramidView, vk::ImageLayout::eGeneral)
+        .Write(_device);
+  }
 
-    // Destroy the layout
-    _device.destroyPipelineLayout(meshPipelineLayout);
+  // Nothing was visible before the first frame: it is entirely drawn by the late pass.
+  // Move the pyramid to its layout at the same time.
+  ImmediateSubmit([this](vk::CommandBuffer cmd) {
+    cmd.fillBuffer(_visibilityBuffer.buffer, 0, VK_WHOLE_SIZE, 0);
+
+    vk::ImageMemoryBarrier pyramidBarrier{
+        .srcAccessMask = {},
+        .dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+        .oldLayout = vk::ImageLayout::eUndefined,
+        .newLayout = vk::ImageLayout::eGeneral,
+        .image = _depthPyramid.image,
+        .subresourceRange{
+            .aspectMask = vk::ImageAspectFlagBits::eColor,
+            .baseMipLevel = 0,
+            .levelCount = _depthPyramidLevels,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+    };
+    vk::MemoryBarrier fillBarrier{
+        .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+    };
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe | vk::PipelineStageFlagBits::eTransfer,
+                        vk::PipelineStageFlagBits::eComputeShader, {}, fillBarrier, nullptr, pyramidBarrier);
   });
+  _renderGraph.SetImportedImage(_depthPyramidResource, _depthPyramid.image, _depthPyramidView);
+
+  // Register deletion. The layouts are owned by the layout cache
+  _mainDeletionQueue.Push(_depthReducePipeline);
+  _mainDeletionQueue.Push(_occlusionCullPipeline);
+  _mainDeletionQueue.Push(_depthPyramidSampler);
+  for (auto view : _depthPyramidMips) {
+    _mainDeletionQueue.Push(view);
+  }
+  _mainDeletionQueue.Push(_depthPyramidView);
+  _mainDeletionQueue.Push(_depthPyramid);
+}
+
+vk::Pipeline VulkanEngine::CreateComputePipeline(const char *shaderPath, vk::PipelineLayout layout) {
+  auto shader = LoadShaderModule(shaderPath);
+  vk::ComputePipelineCreateInfo pipelineCreateInfo{
+      .stage =
+          {
+              .stage = vk::ShaderStageFlagBits::eCompute,
+              .module = shader,
+              .pName = "main",
+          },
+      .layout = layout,
+  };
+  auto result = _device.createComputePipeline(nullptr, pipelineCreateInfo);
+  // The module is not needed once the pipeline is created
+  _device.destroyShaderModule(shader);
+
+  if (result.result != vk::Result::eSuccess)
+    throw std::runtime_error("Unable to create compute pipeline");
+  return result.value;
 }
 
 vk::ShaderModule VulkanEngine::LoadShaderModule(const char *filePath) {
-  // Load the binary file with the cursor at the end
-  std::ifstream file(filePath, std::ios::ate | std::ios::binary);
+  return vkinit::LoadShaderModule(_device, filePath);
+}
+
+void VulkanEngine::InitOverlay() {
+  PROFILE_FUNCTION();
+
+  ImGui::CreateContext();
+  ImGuiIO &io = ImGui::GetIO();
+  // Don't write imgui.ini next to the executable
+  io.IniFilename = nullptr;
+  ImGui_ImplSDL2_InitForVulkan(_window);
+  _mainDeletionQueue.PushFunction([]() {
+    ImGui_ImplSDL2_Shutdown();
+    ImGui::DestroyContext();
+  });
+
+  // Upload the font atlas like any other texture. It is the only texture of the overlay.
+  unsigned char *pixels = nullptr;
+  int32_t width = 0;
+  int32_t height = 0;
+  io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+  const size_t fontSize = static_cast<size_t>(width) * height * 4;
+  Texture *font = UploadTexture("overlay font", TextureUploadInfo{
+                                                    .format = vk::Format::eR8G8B8A8Unorm,
+                                                    .data = pixels,
+                                                    .dataSize = fontSize,
+                                                    .mips = {MipLevel{
+                                                        .width = static_cast<uint32_t>(width),
+                                                        .height = static_cast<uint32_t>(height),
+                                                        .offset = 0,
+                                                        .size = fontSize,
+                                                    }},
+                                                });
+  io.Fonts->ClearTexData();
+  vkinit::DescriptorSetAllocator(_descriptorPool)
+      .AddSetWithLayout(_textureSetLayout, &_overlayFontDescriptor)
+      .Allocate(_device)
+      .AddImage(0, 0, _defaultSampler, font->imageView)
+      .Write(_device);
 
-  if (!file.is_open()) {
-    // Display error
-    std::cerr << strerror(errno) << '\n';
-    throw std::runtime_error("Couldn't load shader " + std::string(filePath));
+  // Geometry buffers of each frame, mapped once for the whole run
+  for (auto &frame : _frames) {
+    frame.overlayVertexBuffer =
+        CreateBuffer(OVERLAY_MAX_VERTICES * sizeof(ImDrawVert), vk::BufferUsageFlagBits::eVertexBuffer,
+                     VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::ePerFrame,
+                     VMA_ALLOCATION_CREATE_MAPPED_BIT);
+    frame.overlayIndexBuffer =
+        CreateBuffer(OVERLAY_MAX_INDICES * sizeof(ImDrawIdx), vk::BufferUsageFlagBits::eIndexBuffer,
+                     VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::ePerFrame,
+                     VMA_ALLOCATION_CREATE_MAPPED_BIT);
+    VmaAllocationInfo allocationInfo;
+    vmaGetAllocationInfo(_allocator, frame.overlayVertexBuffer.allocation, &allocationInfo);
+    frame.overlayVertices = allocationInfo.pMappedData;
+    vmaGetAllocationInfo(_allocator, frame.overlayIndexBuffer.allocation, &allocationInfo);
+    frame.overlayIndices = allocationInfo.pMappedData;
   }
-  // Since the cursor is at the end, tellg gives the size of the file
-  size_t fileSize = file.tellg();
-  // Create a vector long enough to hold the content
-  std::vector<uint32_t> buffer(fileSize / sizeof(uint32_t));
-  // Cursor at the beginning
-  file.seekg(0);
-  // Load the file into the buffer
-  file.read((char *)buffer.data(), fileSize);
-  // Close the file
-  file.close();
 
-  // Create a shader module
-  vk::ShaderModuleCreateInfo shaderCreateInfo{
-      .codeSize = buffer.size() * sizeof(uint32_t),
-      .pCode = buffer.data(),
+  // Pipeline drawing the ImGui vertices, with the scissors given by ImGui
+  auto overlayVertShader = LoadShaderModule("../shaders/overlay.vert.spv");
+  auto overlayFragShader = LoadShaderModule("../shaders/overlay.frag.spv");
+  constexpr vk::PushConstantRange pushConstants{
+      .stageFlags = vk::ShaderStageFlagBits::eVertex,
+      .offset = 0,
+      .size = sizeof(glm::vec4),
+  };
+  _overlayPipelineLayout = _layoutCache.CreatePipelineLayout({_textureSetLayout.layout}, {pushConstants});
+  const VertexInputDescription vertexDescription{
+      .bindings = {{
+          .binding = 0,
+          .stride = sizeof(ImDrawVert),
+          .inputRate = vk::VertexInputRate::eVertex,
+      }},
+      .attributes = {
+          {
+              .location = 0,
+              .binding = 0,
+              .format = vk::Format::eR32G32Sfloat,
+              .offset = static_cast<uint32_t>(offsetof(ImDrawVert, pos)),
+          },
+          {
+              .location = 1,
+              .binding = 0,
+              .format = vk::Format::eR32G32Sfloat,
+              .offset = static_cast<uint32_t>(offsetof(ImDrawVert, uv)),
+          },
+          {
+              .location = 2,
+              .binding = 0,
+              .format = vk::Format::eR8G8B8A8Unorm,
+              .offset = static_cast<uint32_t>(offsetof(ImDrawVert, col)),
+          },
+      },
   };
-  return _device.createShaderModule(shaderCreateInfo);
+  _overlayPipeline = PipelineBuilder()
+                         .WithPipelineLayout(_overlayPipelineLayout)
+                         .GetDefaultsForExtent(_windowExtent)
+                         .AddShaderStage(vk::ShaderStageFlagBits::eVertex, overlayVertShader)
+                         .AddShaderStage(vk::ShaderStageFlagBits::eFragment, overlayFragShader)
+                         .WithVertexInput(vertexDescription)
+                         .WithAlphaBlending()
+                         .WithDynamicState(vk::DynamicState::eScissor)
+                         .Build(_device, _renderGraph.GetRenderPass("overlay"));
+  _mainDeletionQueue.Push(_overlayPipeline);
+  _device.destroyShaderModule(overlayVertShader);
+  _device.destroyShaderModule(overlayFragShader);
 }
 
 void VulkanEngine::LoadMeshes() {
+  PROFILE_FUNCTION();
+
   // Make the array 3 vertices long
   std::vector<Vertex> triangleVertices(3);
   // Triangle
@@ -595,11 +1146,228 @@ void VulkanEngine::LoadMeshes() {
   Mesh *triangleMesh = GetMesh("triangle");
   UploadMesh(*triangleMesh);
 
-  // Load the monkey
-  _meshes["monkey"] = Mesh();
-  Mesh *monkeyMesh = GetMesh("monkey");
-  monkeyMesh->LoadFromObj("../assets/monkey_smooth.obj");
-  UploadMesh(*monkeyMesh);
+  // Grey cube drawn in place of the meshes that are still loading
+  std::vector<Vertex> cubeVertices;
+  for (uint32_t axis = 0; axis < 3; axis++) {
+    for (float side : {-1.0f, 1.0f}) {
+      glm::vec3 normal(0.0f), tangent(0.0f), bitangent(0.0f);
+      normal[axis] = side;
+      tangent[(axis + 1) % 3] = 1.0f;
+      bitangent[(axis + 2) % 3] = 1.0f;
+      const glm::vec3 corners[] = {normal - tangent - bitangent, normal + tangent - bitangent,
+                                   normal + tangent + bitangent, normal - tangent + bitangent};
+      for (uint32_t corner : {0, 1, 2, 0, 2, 3}) {
+        cubeVertices.push_back(Vertex{
+            .position = corners[corner] * 0.5f,
+            .normal = normal,
+            .color = glm::vec3(0.5f),
+            .uv = glm::vec2(corner == 1 || corner == 2, corner >= 2),
+        });
+      }
+    }
+  }
+  _meshes["placeholder"] = Mesh(cubeVertices);
+  _placeholderMesh = GetMesh("placeholder");
+  UploadMesh(*_placeholderMesh);
+
+  // Load the monkey in the background
+  _loadingTasks.push_back(DiscardResult(LoadMeshAsync("monkey", "../assets/monkey_smooth.obj")));
+}
+
+Task<Mesh *> VulkanEngine::LoadMeshAsync(std::string name, std::string path) {
+  // The mesh is created right away, so that objects can already use it
+  Mesh *mesh = &_meshes[name];
+  _loadingMeshes.insert(mesh);
+
+  // Read the file and prepare the mesh on a worker
+  std::optional<Mesh> loadedMesh = co_await _taskScheduler.WaitFor(_jobSystem.Submit([path]() {
+    std::optional<Mesh> result{std::in_place};
+    if (!result->LoadFromObj(path.c_str()))
+      return std::optional<Mesh>();
+    if (ENABLE_MESHLET_CULLING) {
+      result->GenerateMeshlets();
+    }
+    result->GenerateLods();
+    return result;
+  }));
+  if (!loadedMesh) {
+    // The objects using it keep the placeholder
+    std::cerr << "[Loading] Can't load mesh " << path << '\n';
+    co_return nullptr;
+  }
+
+  // Upload it in its final place: the defragmenter keeps references to its buffers
+  *mesh = std::move(*loadedMesh);
+  co_await UploadMeshAsync(*mesh);
+
+  // Replace the placeholder. The objects got larger or smaller, so their bounds are refit.
+  _loadingMeshes.erase(mesh);
+  for (uint32_t i = 0; i < _renderables.size(); i++) {
+    if (_renderables[i].pendingMesh == mesh) {
+      _renderables[i].mesh = mesh;
+      _renderables[i].pendingMesh = nullptr;
+      _movedObjects.push_back(i);
+    }
+  }
+  co_return mesh;
+}
+
+void VulkanEngine::StartTextureLoads() {
+  const TextureSource textures[] = {
+      {
+          .name = "empire_diffuse",
+          .imagePath = "../assets/lost_empire-RGBA.png",
+          .cookedPath = "../assets/lost_empire-RGBA.tex",
+      },
+  };
+
+  for (const auto &texture : textures) {
+    // Cooked textures are mapped and uploaded as-is, they don't need any work
+    if (std::filesystem::exists(texture.cookedPath)) {
+      _cookedTextures.push_back(texture);
+    }
+    // Decoding and mip generation only need the CPU, so they can run before Vulkan is even initialized
+    else {
+      _pendingTextures.emplace_back(texture.name, DecodeTextureAsync(texture.imagePath));
+    }
+  }
+}
+
+std::future<ImageData> VulkanEngine::DecodeTextureAsync(const std::string &imagePath) {
+  return _jobSystem.Submit([imagePath]() {
+    ImageData image;
+    if (imgutils::LoadImage(imagePath.c_str(), image)) {
+      imgutils::GenerateMipChain(image);
+    }
+    return image;
+  });
+}
+
+Task<Texture *> VulkanEngine::UploadDecodedTextureAsync(std::string name,
+                                                        std::future<ImageData> pendingImage) {
+  const ImageData image = co_await _taskScheduler.WaitFor(std::move(pendingImage));
+  // The error was already printed by the decoding job
+  if (image.mips.empty())
+    co_return nullptr;
+
+  co_return co_await UploadTextureAsync(std::move(name), TextureUploadInfo{
+                                                             .format = vk::Format::eR8G8B8A8Unorm,
+                                                             .data = image.pixels.data(),
+                                                             .dataSize = image.pixels.size(),
+                                                             .mips = image.mips,
+                                                         });
+}
+
+Task<Texture *> VulkanEngine::LoadTextureAsync(TextureSource source) {
+  // Cooked textures are mapped and uploaded as-is, they don't need any work
+  if (std::filesystem::exists(source.cookedPath)) {
+    MappedFile file;
+    TextureUploadInfo uploadInfo{};
+    bool valid = file.Open(source.cookedPath.c_str()) && ParseTextureContainer(file, uploadInfo);
+    // Block compressed formats need a GPU feature
+    bool supported = valid && (uploadInfo.format == vk::Format::eR8G8B8A8Unorm || _textureCompressionBC);
+
+    // The data is copied to the staging buffer before the upload suspends, so the file can be closed after
+    if (supported)
+      co_return co_await UploadTextureAsync(std::move(source.name), uploadInfo);
+
+    // Fallback on the source image
+    std::cerr << "Can't use " << source.cookedPath << ", decoding " << source.imagePath << " instead\n";
+  }
+
+  co_return co_await UploadDecodedTextureAsync(std::move(source.name), DecodeTextureAsync(source.imagePath));
+}
+
+void VulkanEngine::LoadTextures() {
+  // Create the sampler shared by the textures
+  _defaultSampler = _device.createSampler(vkinit::SamplerCreateInfo(vk::Filter::eLinear));
+  _mainDeletionQueue.Push(_defaultSampler);
+
+  // White texture used by the materials until their texture is loaded
+  const uint8_t white[] = {255, 255, 255, 255};
+  const MipLevel whiteMip{.width = 1, .height = 1, .offset = 0, .size = sizeof(white)};
+  _placeholderTexture = UploadTexture("placeholder", TextureUploadInfo{
+                                                         .format = vk::Format::eR8G8B8A8Unorm,
+                                                         .data = white,
+                                                         .dataSize = sizeof(white),
+                                                         .mips = {whiteMip},
+                                                     });
+
+  // Create the textured material with the placeholder
+  Material *texturedMaterial = nullptr;
+  if (_bindless) {
+    // Same pipeline as the other materials, the texture is given by its index
+    texturedMaterial = CreateMaterial(GetMaterial("default")->pipelineState, "textured");
+  } else {
+    texturedMaterial = CreateMaterial(_texturedPipelineState, "textured");
+  }
+  SetMaterialTexture(texturedMaterial, _placeholderTexture);
+
+  // Upload the textures in the background
+  _loadingTasks.push_back(LoadTexturesAsync(std::move(_cookedTextures), std::move(_pendingTextures)));
+  _cookedTextures.clear();
+  _pendingTextures.clear();
+}
+
+Task<> VulkanEngine::LoadTexturesAsync(
+    std::vector<TextureSource> cookedTextures,
+    std::vector<std::pair<std::string, std::future<ImageData>>> pendingTextures) {
+  // Start every load before waiting for any of them, so that they run at the same time
+  std::vector<Task<Texture *>> loads;
+  for (auto &texture : cookedTextures) {
+    loads.push_back(LoadTextureAsync(std::move(texture)));
+  }
+  for (auto &[name, pendingImage] : pendingTextures) {
+    loads.push_back(UploadDecodedTextureAsync(name, std::move(pendingImage)));
+  }
+  for (auto &load : loads) {
+    co_await load;
+  }
+
+  // Replace the placeholder of the textured material
+  Texture *empireTexture = GetTexture("empire_diffuse");
+  if (empireTexture != nullptr) {
+    SetMaterialTexture(GetMaterial("textured"), empireTexture);
+  }
+}
+
+void VulkanEngine::SetMaterialTexture(Material *material, Texture *texture) {
+  if (_bindless) {
+    // Frames in flight read either the old or the new index, which are both valid
+    GPUMaterialData &parameters = _materialParameters[material->materialIndex];
+    parameters.textures.x = texture->bindlessIndex;
+    char *data = nullptr;
+    vmaMapMemory(_allocator, _materialBuffer.allocation, (void **)&data);
+    memcpy(data + sizeof(GPUMaterialData) * material->materialIndex, &parameters, sizeof(GPUMaterialData));
+    vmaUnmapMemory(_allocator, _materialBuffer.allocation);
+  } else {
+    // The set can't be updated while a frame in flight uses it, so a new one is allocated.
+    // The previous one is freed with the pool.
+    vkinit::DescriptorSetAllocator(_descriptorPool)
+        .AddSetWithLayout(_textureSetLayout, &material->materialSet)
+        .Allocate(_device)
+        .AddImage(0, 0, _defaultSampler, texture->imageView)
+        .Write(_device);
+  }
+}
+
+void VulkanEngine::UpdateLoading() {
+  _taskScheduler.Poll();
+
+  // Forget the finished loads. Their errors are thrown here.
+  std::erase_if(_loadingTasks, [](Task<> &task) {
+    if (!task.IsDone())
+      return false;
+    task.GetResult();
+    return true;
+  });
+}
+
+void VulkanEngine::UsePlaceholderWhileLoading(RenderObject &object) {
+  if (_loadingMeshes.contains(object.mesh)) {
+    object.pendingMesh = object.mesh;
+    object.mesh = _placeholderMesh;
+  }
 }
 
 void VulkanEngine::Cleanup() {
@@ -612,7 +1380,16 @@ void VulkanEngine::Cleanup() {
     }
     _device.waitForFences(FRAME_OVERLAP, fences, true, 1000000000);
 
-    _mainDeletionQueue.Flush();
+    // Finish the loads in progress, so that their staging buffers and fences are released
+    while (_taskScheduler.HasWaitingTasks()) {
+      UpdateLoading();
+      std::this_thread::yield();
+    }
+
+    _mainDeletionQueue.FlushAll();
+    if (_memoryTracker.GetAllocationCount() > 0) {
+      std::cerr << "[Memory] " << _memoryTracker.GetAllocationCount() << " allocations were never freed\n";
+    }
 
     // Cleanup Vulkan
     vmaDestroyAllocator(_allocator);
@@ -630,6 +1407,8 @@ void VulkanEngine::Cleanup() {
 }
 
 void VulkanEngine::Draw() {
+  PROFILE_FUNCTION();
+
   // Wait until the GPU has finished rendering the last frame. Timeout of 1
   // second
   FrameData &currentFrame = GetCurrentFrame();
@@ -637,7 +1416,38 @@ void VulkanEngine::Draw() {
   auto waitResult = _device.waitForFences(currentFrame.renderFence, true, 1000000000);
   if (waitResult != vk::Result::eSuccess)
     throw std::runtime_error("Error while waiting for fences");
+
+  // Compact the geometry when it gets fragmented.
+  // Done before the fence is reset, since the defragmentation waits for every frame. The buffers being
+  // uploaded in the background can't be moved, so it waits for the uploads too.
+  if (_asyncUploadCount == 0 && _defragmenter.NeedsPass(_frameNumber)) {
+    DefragmentMemory();
+  }
   _device.resetFences(currentFrame.renderFence);
+  const auto recordStart = std::chrono::steady_clock::now();
+  _renderStats = {};
+
+  // The previous use of this frame is done, so its timestamps are available.
+  // Frame numbers start at 1: the slot was only written once FRAME_OVERLAP frames have been submitted.
+  const uint32_t timestampIndex = 2 * (_frameNumber % FRAME_OVERLAP);
+  if (_timestampPool && _frameNumber > FRAME_OVERLAP) {
+    std::array<uint64_t, 2> timestamps{};
+    auto queryResult = _device.getQueryPoolResults(_timestampPool, timestampIndex, 2, sizeof(timestamps),
+                                                   timestamps.data(), sizeof(uint64_t),
+                                                   vk::QueryResultFlagBits::e64);
+    if (queryResult == vk::Result::eSuccess) {
+      _renderStats.gpuTime = static_cast<float>(timestamps[1] - timestamps[0]) *
+                             _gpuProperties.limits.timestampPeriod / 1000000.0f;
+    }
+  }
+
+  // The blocks written by the previous use of this frame are not read anymore
+  _uniformAllocator.BeginFrame(_frameNumber % FRAME_OVERLAP);
+
+  // The frame that used these resources last is done, so the resources retired until then can go
+  if (_frameNumber > FRAME_OVERLAP) {
+    _mainDeletionQueue.Flush(_frameNumber - FRAME_OVERLAP);
+  }
 
   // Request image index from swapchain
   uint32_t swapchainImageIndex;
@@ -668,39 +1478,41 @@ void VulkanEngine::Draw() {
       .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
   };
   currentFrame.mainCommandBuffer.begin(cmdBeginInfo);
+  if (_timestampPool) {
+    currentFrame.mainCommandBuffer.resetQueryPool(_timestampPool, timestampIndex, 2);
+    currentFrame.mainCommandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, _timestampPool,
+                                                  timestampIndex);
+  }
 
   // Define a clear color from frame number
   float flash = abs(sin(static_cast<float>(_frameNumber) / 120.f));
   float flash2 = abs(sin(static_cast<float>(_frameNumber) / 180.f));
-  vk::ClearValue clearColorValue(vkinit::GetColor(1 - flash, flash2, flash));
-
-  // Clear depth stencil
-  vk::ClearValue clearDepthValue(vk::ClearDepthStencilValue{1.0f});
-  vk::ClearValue clearValues[2] = {clearColorValue, clearDepthValue};
-
-  // Start the main renderpass
-  vk::RenderPassBeginInfo rpBeginInfo{
-      .renderPass = _renderPass,
-      .framebuffer = _framebuffers[swapchainImageIndex],
-      .renderArea =
-          {
-              .offset = {.x = 0, .y = 0},
-              .extent = _windowExtent,
-          },
-      .clearValueCount = 2,
-      .pClearValues = clearValues,
-  };
-  currentFrame.mainCommandBuffer.beginRenderPass(rpBeginInfo, vk::SubpassContents::eInline);
+  _renderGraph.SetClearValue(_swapchainResource, vk::ClearValue(vkinit::GetColor(1 - flash, flash2, flash)));
+  _renderGraph.SetImportedImage(_swapchainResource, _swapchainImages[swapchainImageIndex],
+                                _swapchainImageViews[swapchainImageIndex]);
+
+  // Fill the object buffers
+  UpdateObjects(_renderables.data(), _renderables.size());
+  // Skip the objects outside of the frustum.
+  // Without the GPU occlusion culling, the CPU also hides the ones behind the occluders.
+  CullObjectsOutsideFrustum();
+  if (!_occlusionCulling && ENABLE_CPU_OCCLUSION_CULLING) {
+    CullObjectsOnCpu(_renderables.data(), _renderables.size());
+  }
+  _renderStats.visibleObjects = static_cast<uint32_t>(_renderables.size()) - _renderStats.culledObjects;
 
-  // ==== Start Render code ====
+  // Build the overlay from the statistics of the last frame
+  BuildOverlay();
 
-  // Draw objects
-  DrawObjects(currentFrame.mainCommandBuffer, _renderables.data(), _renderables.size());
+  // Record the culling and render passes, with the barriers between them
+  _renderGraph.Execute(currentFrame.mainCommandBuffer);
+  _renderStats.bytesUploaded += _uniformAllocator.GetUsedSize();
 
-  // ==== End Render code ====
+  if (_timestampPool) {
+    currentFrame.mainCommandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, _timestampPool,
+                                                  timestampIndex + 1);
+  }
 
-  // End the renderpass to finish rendering commands
-  currentFrame.mainCommandBuffer.endRenderPass();
   // End the command buffer to finish it and prepare it to be submitted
   currentFrame.mainCommandBuffer.end();
 
@@ -722,6 +1534,11 @@ void VulkanEngine::Draw() {
   };
   _graphicsQueue.submit(submitInfo, currentFrame.renderFence);
 
+  // The recording is done: keep the statistics of the frame for the overlay
+  _renderStats.cpuTime =
+      std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - recordStart).count();
+  _renderStatsHistory.Push(_renderStats);
+
   // Present the image on the screen
   vk::PresentInfoKHR presentInfo{
       // Wait until the rendering is complete
@@ -758,6 +1575,8 @@ void VulkanEngine::Run() {
 
     // Handle window event in a queue
     while (SDL_PollEvent(&event) != 0) {
+      ImGui_ImplSDL2_ProcessEvent(&event);
+
       // Quit event: set shouldQuit to true to exit the main loop
       if (event.type == SDL_QUIT) {
         shouldQuit = true;
@@ -791,6 +1610,38 @@ void VulkanEngine::Run() {
         else if (event.key.keysym.sym == SDLK_LSHIFT) {
           _cameraMotion.y = CAMERA_MOVEMENT_SPEED;
         }
+        // M: dump the memory usage
+        else if (event.key.keysym.sym == SDLK_m) {
+          if (_memoryTracker.DumpJson(MEMORY_REPORT_PATH)) {
+            std::cout << "[Memory] Report written to " << MEMORY_REPORT_PATH << '\n';
+          }
+        }
+        // P: start a profiler capture, or stop it and write the trace
+        else if (PROFILER_ENABLED && event.key.keysym.sym == SDLK_p) {
+          if (!Profiler::IsRecording()) {
+            Profiler::StartRecording();
+            std::cout << "[Profiler] Recording\n";
+          } else {
+            Profiler::StopRecording();
+            if (Profiler::WriteChromeTrace(PROFILER_TRACE_PATH)) {
+              std::cout << "[Profiler] Trace written to " << PROFILER_TRACE_PATH << '\n';
+            }
+          }
+        }
+        // F1: show or hide the performance overlay
+        else if (event.key.keysym.sym == SDLK_F1) {
+          _showOverlay = !_showOverlay;
+        }
+      }
+      // Left click: print the object under the cursor
+      else if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_LEFT &&
+               !ImGui::GetIO().WantCaptureMouse) {
+        const uint32_t object = PickObject(event.button.x, event.button.y);
+        if (object != NO_OBJECT) {
+          const glm::vec3 center = _bvh.GetBounds(object).GetCenter();
+          std::cout << "[Picking] Object " << object << " at (" << center.x << ", " << center.y << ", "
+                    << center.z << ")\n";
+        }
       }
       // Stop motion when releasing
       else if (event.type == SDL_KEYUP) {
@@ -804,47 +1655,112 @@ void VulkanEngine::Run() {
       }
     }
 
-    // Apply motions
-    _cameraPosition += static_cast<float>(_deltaTime) * _cameraMotion;
-    // Rotate monkey
-    _renderables[0].transformMatrix =
-        glm::rotate(_renderables[0].transformMatrix, glm::radians(1.0f), glm::vec3(0.0f, 1.f, 0.f));
+    // Simulate the ticks covered by the time elapsed, then render in between the last two
+    _tickAccumulator = std::min(_tickAccumulator + _deltaTime, MAX_TICKS_PER_FRAME * _tickDuration);
+    while (_tickAccumulator >= _tickDuration) {
+      Tick();
+      _tickAccumulator -= _tickDuration;
+    }
+    const auto alpha = static_cast<float>(_tickAccumulator / _tickDuration);
+    // Continue the loads whose job or upload is done. Finished meshes replace their placeholder.
+    UpdateLoading();
+    _cameraPosition = glm::mix(_previousCameraPosition, _simulatedCameraPosition, alpha);
+    UpdateTransforms(alpha);
+    // Stream the scene in around the new position of the camera
+    StreamScene();
+    UpdateBvh();
 
     // Run the rendering code
     Draw();
   }
 }
 
-AllocatedBuffer VulkanEngine::CreateBuffer(size_t allocationSize, vk::BufferUsageFlags bufferUsage,
-                                           VmaMemoryUsage memoryUsage) {
-  // Buffer info
-  vk::BufferCreateInfo bufferCreateInfo{
-      .size = allocationSize,
-      .usage = bufferUsage,
-  };
-  // Allocation info
-  VmaAllocationCreateInfo allocationCreateInfo{};
-  allocationCreateInfo.usage = memoryUsage;
+void VulkanEngine::Tick() {
+  const auto tickDuration = static_cast<float>(_tickDuration);
+  _transforms.BeginTick();
+
+  // Apply motions
+  _previousCameraPosition = _simulatedCameraPosition;
+  _simulatedCameraPosition += tickDuration * _cameraMotion;
+  // Rotate monkey. Its rotation is kept as a normalized quaternion, so it doesn't drift over time.
+  constexpr float MONKEY_ROTATION_SPEED = 60.0f; // Degrees per second
+  const glm::quat rotation =
+      glm::angleAxis(glm::radians(MONKEY_ROTATION_SPEED * tickDuration), glm::vec3(0.0f, 1.f, 0.f));
+  Transform monkeyTransform = _transforms.GetLocal(_renderables[0].transform);
+  monkeyTransform.rotation = glm::normalize(rotation * monkeyTransform.rotation);
+  _transforms.SetLocal(_renderables[0].transform, monkeyTransform);
+}
 
-  // Create the buffer
-  AllocatedBuffer newBuffer;
-  vmaCreateBuffer(_allocator, reinterpret_cast<VkBufferCreateInfo *>(&bufferCreateInfo),
-                  &allocationCreateInfo, reinterpret_cast<VkBuffer *>(&newBuffer.buffer),
-                  &newBuffer.allocation, nullptr);
+void VulkanEngine::SetTickRate(double ticksPerSecond) {
+  if (ticksPerSecond <= 0.0)
+    throw std::runtime_error("The tick rate must be positive");
+  _tickDuration = 1.0 / ticksPerSecond;
+  _tickAccumulator = std::min(_tickAccumulator, _tickDuration);
+}
 
-  // Register deletion
-  _mainDeletionQueue.PushFunction(
-      [this, newBuffer]() { vmaDestroyBuffer(_allocator, newBuffer.buffer, newBuffer.allocation); });
+MemoryReport VulkanEngine::GetMemoryReport() const { return _memoryTracker.GetReport(); }
+
+const RenderStats &VulkanEngine::GetRenderStats() const { return _renderStatsHistory.GetLatest(); }
+
+const RenderStatsHistory &VulkanEngine::GetRenderStatsHistory() const { return _renderStatsHistory; }
+
+uint32_t VulkanEngine::PickObject(int32_t x, int32_t y) const {
+  // Unproject the pixel on the near and far planes to get the ray under it
+  const glm::mat4 inverseViewProj = glm::inverse(GetCameraData().viewProj);
+  const glm::vec2 ndc{
+      (static_cast<float>(x) + 0.5f) / static_cast<float>(_windowExtent.width) * 2.0f - 1.0f,
+      (static_cast<float>(y) + 0.5f) / static_cast<float>(_windowExtent.height) * 2.0f - 1.0f,
+  };
+  glm::vec4 nearPoint = inverseViewProj * glm::vec4(ndc, -1.0f, 1.0f);
+  glm::vec4 farPoint = inverseViewProj * glm::vec4(ndc, 1.0f, 1.0f);
+  nearPoint /= nearPoint.w;
+  farPoint /= farPoint.w;
+
+  const glm::vec3 origin(nearPoint);
+  const glm::vec3 direction = glm::normalize(glm::vec3(farPoint) - origin);
+  return _bvh.Raycast(origin, direction, PICKING_DISTANCE);
+}
+
+AllocatedBuffer VulkanEngine::CreateBuffer(size_t allocationSize, vk::BufferUsageFlags bufferUsage,
+                                           VmaMemoryUsage memoryUsage, MemoryCategory category,
+                                           VmaAllocationCreateFlags allocationFlags) {
+  // Buffer info
+  vk::BufferCreateInfo bufferCreateInfo{
+      .size = allocationSize,
+      .usage = bufferUsage,
+  };
+  // Create the buffer in the pool of its category
+  AllocatedBuffer newBuffer =
+      _memoryPools.CreateBuffer(bufferCreateInfo, memoryUsage, category, allocationFlags);
+
+  // Register deletion
+  _mainDeletionQueue.Push(newBuffer);
 
   return newBuffer;
 }
 
-Material *VulkanEngine::CreateMaterial(vk::Pipeline pipeline, vk::PipelineLayout layout,
-                                       const std::string &name) {
+Material *VulkanEngine::CreateMaterial(const PipelineState &pipelineState, const std::string &name,
+                                       const GPUMaterialData &parameters) {
   Material mat{
-      .pipeline = pipeline,
-      .pipelineLayout = layout,
+      .pipelineState = pipelineState,
+      .pipelineLayout = pipelineState.layout,
   };
+
+  // In bindless mode, store the parameters in the material buffer
+  if (_bindless) {
+    if (_materialParameters.size() >= MAX_MATERIALS)
+      throw std::runtime_error("Material buffer is full");
+
+    mat.materialSet = _bindlessDescriptor;
+    mat.materialIndex = static_cast<uint32_t>(_materialParameters.size());
+    _materialParameters.push_back(parameters);
+
+    char *data = nullptr;
+    vmaMapMemory(_allocator, _materialBuffer.allocation, (void **)&data);
+    memcpy(data + sizeof(GPUMaterialData) * mat.materialIndex, &parameters, sizeof(GPUMaterialData));
+    vmaUnmapMemory(_allocator, _materialBuffer.allocation);
+  }
+
   // Save it
   _materials[name] = mat;
   return &_materials[name];
@@ -860,6 +1776,16 @@ Material *VulkanEngine::GetMaterial(const std::string &name) {
   }
 }
 
+Texture *VulkanEngine::GetTexture(const std::string &name) {
+  auto it = _textures.find(name);
+  // Return nullptr if the texture does not exist
+  if (it == _textures.end()) {
+    return nullptr;
+  } else {
+    return &it->second;
+  }
+}
+
 Mesh *VulkanEngine::GetMesh(const std::string &name) {
   auto it = _meshes.find(name);
   // Return nullptr if the material does not exist
@@ -870,72 +1796,324 @@ Mesh *VulkanEngine::GetMesh(const std::string &name) {
   }
 }
 
-void VulkanEngine::DrawObjects(vk::CommandBuffer cmd, RenderObject *first, int32_t count) {
-  uint32_t frameIndex = _frameNumber % FRAME_OVERLAP;
-  FrameData frame = _frames[frameIndex];
-
+GPUCameraData VulkanEngine::GetCameraData() const {
   // Camera position
   glm::mat4 view = glm::translate(glm::mat4(1.0f), _cameraPosition);
   // Camera projection
-  glm::mat4 projection = glm::perspective(
-      glm::radians(70.f), static_cast<float_t>(_windowExtent.width) / _windowExtent.height, 0.1f, 200.0f);
+  const float aspectRatio = static_cast<float_t>(_windowExtent.width) / _windowExtent.height;
+  glm::mat4 projection = glm::perspective(glm::radians(CAMERA_FOV), aspectRatio, 0.1f, 200.0f);
   projection[1][1] *= -1;
 
-  // Fill a camera buffer
-  GPUCameraData camData{
+  return GPUCameraData{
       .view = view,
       .projection = projection,
       .viewProj = projection * view,
   };
-  // Copy it to buffer
-  CopyBufferToAllocation(&camData, _cameraBuffer.allocation, true);
+}
 
-  // Set scene parameters
-  _sceneData.ambientColor = glm::vec4(0.6f, 0.4f, 0.2f, 1.0f);
-  CopyBufferToAllocation(&_sceneData, _sceneDataBuffer.allocation, true);
+void VulkanEngine::UpdateObjects(RenderObject *first, int32_t count) {
+  FrameData &frame = GetCurrentFrame();
 
-  // Render objects
-  Mesh *lastMesh = nullptr;
-  Material *lastMaterial = nullptr;
+  // Write the camera and scene blocks of the main view
+  frame.cameraOffset = _uniformAllocator.Push(GetCameraData());
+  _sceneData.ambientColor = glm::vec4(0.6f, 0.4f, 0.2f, 1.0f);
+  frame.sceneOffset = _uniformAllocator.Push(_sceneData);
 
   // Copy object buffer
   GPUObjectData *objectSSBO;
   ObjectColor *objectColorSSBO;
   vmaMapMemory(_allocator, frame.objectColorBuffer.allocation, (void **)&objectColorSSBO);
   vmaMapMemory(_allocator, frame.objectBuffer.allocation, (void **)&objectSSBO);
-  for (uint32_t i = 0; i < count; i++) {
-    RenderObject &object = first[i];
-    objectSSBO[i].modelMatrix = object.transformMatrix;
-    objectColorSSBO[i].albedo = object.albedo;
-  }
+  // Size in pixels of a sphere of radius 1 at a distance of 1, used to pick the levels of detail
+  const glm::vec3 cameraWorldPosition = -_cameraPosition;
+  const float projectionScale =
+      static_cast<float>(_windowExtent.height) * 0.5f / std::tan(glm::radians(CAMERA_FOV) * 0.5f);
+
+  WriteObjectData(first, count, cameraWorldPosition, projectionScale, objectSSBO, objectColorSSBO);
+  _renderStats.bytesUploaded += static_cast<uint64_t>(count) * (sizeof(GPUObjectData) + sizeof(ObjectColor));
   vmaUnmapMemory(_allocator, frame.objectColorBuffer.allocation);
   vmaUnmapMemory(_allocator, frame.objectBuffer.allocation);
+}
+
+void VulkanEngine::CullObjectsOutsideFrustum() {
+  glm::vec4 planes[6];
+  ComputeFrustumPlanes(GetCameraData().viewProj, planes);
+  _bvh.QueryFrustum(planes, _visibleObjects);
+
+  for (RenderObject &object : _renderables) {
+    object.occluded = true;
+  }
+  for (uint32_t object : _visibleObjects) {
+    _renderables[object].occluded = false;
+  }
+  _renderStats.culledObjects += static_cast<uint32_t>(_renderables.size() - _visibleObjects.size());
+}
 
+void VulkanEngine::CullObjectsOnCpu(RenderObject *first, int32_t count) {
+  _cpuOcclusionCuller.BeginFrame(&GetCameraData().viewProj[0][0]);
+
+  // Occluders are rasterized at full resolution: simplified levels may grow outside of the original mesh.
+  // The ones outside of the frustum wouldn't cover any pixel, and placeholders may be larger than their mesh.
   for (uint32_t i = 0; i < count; i++) {
+    const RenderObject &object = first[i];
+    if (!object.occluder || object.occluded || object.pendingMesh != nullptr)
+      continue;
+    const auto &vertices = object.mesh->GetVertices();
+    const MeshLod &lod = object.mesh->GetLod(0);
+    _cpuOcclusionCuller.AddOccluder(&vertices[0].position.x, vertices.size(), sizeof(Vertex),
+                                    object.mesh->GetIndices().data() + lod.firstIndex, lod.indexCount,
+                                    &object.transformMatrix[0][0]);
+  }
+  _cpuOcclusionCuller.Rasterize();
+
+  // Test the box around the bounding sphere of each object
+  _occlusionBoxes.resize(count);
+  _occlusionResults.resize(count);
+  for (uint32_t i = 0; i < count; i++) {
+    const auto [center, radius] = GetWorldBounds(first[i]);
+    OcclusionBox &box = _occlusionBoxes[i];
+    for (uint32_t axis = 0; axis < 3; axis++) {
+      box.min[axis] = center[axis] - radius;
+      box.max[axis] = center[axis] + radius;
+    }
+  }
+  _cpuOcclusionCuller.TestBoxes(_occlusionBoxes.data(), count, _occlusionResults.data());
+
+  // Objects already outside of the frustum were counted by the frustum culling
+  for (uint32_t i = 0; i < count; i++) {
+    const bool hidden = !first[i].occluder && !first[i].occluded && _occlusionResults[i] == 0;
+    first[i].occluded |= hidden;
+    _renderStats.culledObjects += hidden;
+  }
+}
+
+void VulkanEngine::CullMeshlets(vk::CommandBuffer cmd, RenderObject *first, int32_t count) {
+  FrameData &frame = GetCurrentFrame();
+  if (!_meshletCullPipeline)
+    return;
+
+  MeshletCullConstants constants{
+      .cameraPosition = glm::vec4(-_cameraPosition, 1.0f),
+  };
+  ComputeFrustumPlanes(GetCameraData().viewProj, constants.frustumPlanes);
+
+  // The draw commands are written here, the shader only accumulates the index count of the visible meshlets
+  vk::DrawIndexedIndirectCommand *draws;
+  vmaMapMemory(_allocator, frame.meshletDrawBuffer.allocation, (void **)&draws);
+
+  uint32_t drawCount = 0;
+  uint32_t outputIndexCount = 0;
+  const Mesh *lastMesh = nullptr;
+  for (uint32_t i = 0; i < count; i++) {
+    RenderObject &object = first[i];
+    object.meshletDraw = NO_MESHLET_DRAW;
+
+    // Coarser levels are cheap enough to be drawn as a whole
+    const auto &meshlets = object.mesh->GetMeshlets();
+    if (object.lod != 0 || meshlets.empty() || object.occluded)
+      continue;
+    const uint32_t maxIndexCount = object.mesh->GetLod(0).indexCount;
+    if (drawCount == MAX_MESHLET_DRAWS || outputIndexCount + maxIndexCount > MAX_MESHLET_OUTPUT_INDICES)
+      continue;
+
+    // One draw per object, with the object as its first instance
+    draws[drawCount] = vk::DrawIndexedIndirectCommand{
+        .indexCount = 0,
+        .instanceCount = 1,
+        .firstIndex = outputIndexCount,
+        .vertexOffset = 0,
+        .firstInstance = i,
+    };
+
+    if (drawCount == 0) {
+      cmd.bindPipeline(vk::PipelineBindPoint::eCompute, _meshletCullPipeline);
+      cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, _meshletCullPipelineLayout, 0,
+                             frame.meshletCullDescriptor, nullptr);
+      _renderStats.pipelineBinds++;
+      _renderStats.descriptorBinds++;
+    }
+    if (object.mesh != lastMesh) {
+      cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, _meshletCullPipelineLayout, 1,
+                             _meshletDescriptors[object.mesh], nullptr);
+      lastMesh = object.mesh;
+      _renderStats.descriptorBinds++;
+    }
+
+    // One workgroup per meshlet
+    constants.objectIndex = i;
+    constants.drawIndex = drawCount;
+    constants.outputOffset = outputIndexCount;
+    cmd.pushConstants(_meshletCullPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0,
+                      sizeof(MeshletCullConstants), &constants);
+    cmd.dispatch(static_cast<uint32_t>(meshlets.size()), 1, 1);
+    _renderStats.pushConstantCalls++;
+
+    object.meshletDraw = drawCount;
+    drawCount++;
+    outputIndexCount += maxIndexCount;
+  }
+  vmaUnmapMemory(_allocator, frame.meshletDrawBuffer.allocation);
+  _renderStats.bytesUploaded += drawCount * sizeof(vk::DrawIndexedIndirectCommand);
+}
+
+void VulkanEngine::CullObjects(vk::CommandBuffer cmd, RenderObject *first, int32_t count, DrawPass pass) {
+  FrameData &frame = GetCurrentFrame();
+
+  // The draw commands are written by the CPU once for both passes. The shader only sets their instance count.
+  if (pass == DrawPass::eEarly) {
+    vk::DrawIndexedIndirectCommand *draws;
+    vmaMapMemory(_allocator, frame.occlusionDrawBuffer.allocation, (void **)&draws);
+    for (uint32_t i = 0; i < count; i++) {
+      const RenderObject &object = first[i];
+      // Objects with culled meshlets have their own draws in the early pass: they are always occluders
+      const MeshLod &lod = object.mesh->GetLod(object.lod);
+      draws[i] = vk::DrawIndexedIndirectCommand{
+          .indexCount = object.meshletDraw == NO_MESHLET_DRAW ? lod.indexCount : 0,
+          .instanceCount = 0,
+          .firstIndex = lod.firstIndex,
+          .vertexOffset = 0,
+          .firstInstance = i,
+      };
+      draws[MAX_OBJECTS + i] = draws[i];
+    }
+    vmaUnmapMemory(_allocator, frame.occlusionDrawBuffer.allocation);
+
+    const GPUCameraData camData = GetCameraData();
+    GPUCullData cullData{
+        .view = camData.view,
+        .projection = glm::vec4(camData.projection[0][0], camData.projection[1][1], camData.projection[2][2],
+                                camData.projection[3][2]),
+        .pyramid =
+            glm::vec4(_depthPyramidExtent.width, _depthPyramidExtent.height, _depthPyramidLevels, 0.1f),
+        .counts = glm::uvec4(count, MAX_OBJECTS, 0, 0),
+    };
+    ComputeFrustumPlanes(camData.viewProj, cullData.frustumPlanes);
+    CopyBufferToAllocation(&cullData, frame.cullDataBuffer.allocation);
+    _renderStats.bytesUploaded += 2 * count * sizeof(vk::DrawIndexedIndirectCommand) + sizeof(GPUCullData);
+  }
+
+  const uint32_t late = pass == DrawPass::eLate;
+  cmd.bindPipeline(vk::PipelineBindPoint::eCompute, _occlusionCullPipeline);
+  cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, _occlusionCullPipelineLayout, 0,
+                         frame.occlusionCullDescriptor, nullptr);
+  cmd.pushConstants(_occlusionCullPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(uint32_t),
+                    &late);
+  cmd.dispatch((count + 63) / 64, 1, 1);
+  _renderStats.pipelineBinds++;
+  _renderStats.descriptorBinds++;
+  _renderStats.pushConstantCalls++;
+}
+
+void VulkanEngine::BuildDepthPyramid(vk::CommandBuffer cmd) {
+  // The render graph samples the depth image and waits for the previous users of the pyramid.
+  // Only the barriers between the levels are left here.
+  cmd.bindPipeline(vk::PipelineBindPoint::eCompute, _depthReducePipeline);
+  for (uint32_t level = 0; level < _depthPyramidLevels; level++) {
+    const uint32_t width = std::max(_depthPyramidExtent.width >> level, 1u);
+    const uint32_t height = std::max(_depthPyramidExtent.height >> level, 1u);
+
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, _depthReducePipelineLayout, 0,
+                           _depthReduceDescriptors[level], nullptr);
+    cmd.dispatch((width + 15) / 16, (height + 15) / 16, 1);
+
+    // The next level is built from this one
+    vk::MemoryBarrier levelBarrier{
+        .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+        .dstAccessMask = vk::AccessFlagBits::eShaderRead,
+    };
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+                        {}, levelBarrier, nullptr, nullptr);
+  }
+}
+
+void VulkanEngine::DrawObjects(vk::CommandBuffer cmd, RenderObject *first, int32_t count, DrawPass pass) {
+  PROFILE_FUNCTION();
+
+  uint32_t frameIndex = _frameNumber % FRAME_OVERLAP;
+  FrameData frame = _frames[frameIndex];
+
+  // Render objects
+  Mesh *lastMesh = nullptr;
+  vk::Buffer lastIndexBuffer = nullptr;
+  Material *lastMaterial = nullptr;
+  vk::Pipeline lastPipeline = nullptr;
+  vk::PipelineLayout lastLayout = nullptr;
+  vk::DescriptorSet lastMaterialSet = nullptr;
+
+  // With the occlusion culling, each object has an indirect draw per pass
+  const bool occlusionCulled = pass != DrawPass::eAll;
+  const uint32_t occlusionDrawOffset = pass == DrawPass::eLate ? MAX_OBJECTS : 0;
+  constexpr uint32_t drawStride = sizeof(vk::DrawIndexedIndirectCommand);
+
+  for (uint32_t i = 0; i < count;) {
     RenderObject &object = first[i];
 
-    // Only bind pipeline if is it different from the already bound one
+    // Skip the objects hidden by the CPU occlusion culling.
+    // Objects with culled meshlets are entirely drawn in the early pass.
+    if (object.occluded || (pass == DrawPass::eLate && object.meshletDraw != NO_MESHLET_DRAW)) {
+      i++;
+      continue;
+    }
+
+    // Objects following this one with the same mesh, level of detail and material are drawn with the same call,
+    // as instances. The shader finds the data of each one in the object buffer with its instance index.
+    // Objects with culled meshlets have their own indirect draw.
+    uint32_t instanceCount = 1;
+    if (object.meshletDraw == NO_MESHLET_DRAW) {
+      while (i + instanceCount < count) {
+        const RenderObject &next = first[i + instanceCount];
+        if (next.occluded || next.meshletDraw != NO_MESHLET_DRAW || next.mesh != object.mesh ||
+            next.lod != object.lod || next.material != object.material)
+          break;
+        instanceCount++;
+      }
+    }
+
     if (object.material != lastMaterial) {
-      cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, object.material->pipeline);
-
-      // Bind descriptor sets
-      std::vector<vk::DescriptorSet> sets = {_globalDescriptor, frame.objectDescriptor};
-      std::vector<uint32_t> uniformOffsets = {
-          // offset for camera data
-          static_cast<uint32_t>(PadUniformBufferSize(sizeof(GPUCameraData)) * frameIndex),
-          // offset for scene data
-          static_cast<uint32_t>(PadUniformBufferSize(sizeof(GPUSceneData)) * frameIndex)};
-      cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, object.material->pipelineLayout, 0, sets,
-                             uniformOffsets);
       lastMaterial = object.material;
+
+      // Compile the variant the first time it is drawn. Materials with the same state get the same pipeline,
+      // so it is only bound when the handle changes.
+      if (!object.material->pipeline) {
+        object.material->pipeline = _pipelineCache.GetPipeline(object.material->pipelineState);
+      }
+      if (object.material->pipeline != lastPipeline) {
+        cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, object.material->pipeline);
+        lastPipeline = object.material->pipeline;
+        _renderStats.pipelineBinds++;
+      }
+
+      // Layouts come from the layout cache, so materials with compatible layouts share the same handle.
+      // In that case, the bound descriptor sets are still valid and don't need to be bound again.
+      if (object.material->pipelineLayout != lastLayout) {
+        std::vector<vk::DescriptorSet> sets = {_globalDescriptor, frame.objectDescriptor};
+        if (object.material->materialSet) {
+          sets.push_back(object.material->materialSet);
+        }
+        std::vector<uint32_t> uniformOffsets = {frame.cameraOffset, frame.sceneOffset};
+        cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, object.material->pipelineLayout, 0, sets,
+                               uniformOffsets);
+        _renderStats.descriptorBinds++;
+        lastLayout = object.material->pipelineLayout;
+        lastMaterialSet = object.material->materialSet;
+      }
+      // Same layout but another material set: only rebind that set.
+      // In bindless mode, all materials share the same set, so this never happens.
+      else if (object.material->materialSet != lastMaterialSet) {
+        cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, object.material->pipelineLayout, 2,
+                               object.material->materialSet, nullptr);
+        _renderStats.descriptorBinds++;
+        lastMaterialSet = object.material->materialSet;
+      }
     }
 
-    // Upload render matrix with push constants
+    // Upload render matrix with push constants. Only the first instance has its own.
     MeshPushConstants constants{
         .render_matrix = object.transformMatrix,
     };
     cmd.pushConstants(object.material->pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0,
                       sizeof(MeshPushConstants), &constants);
+    _renderStats.pushConstantCalls++;
 
     // Only bind mesh if it is different from the already bound one
     if (object.mesh != lastMesh) {
@@ -943,48 +2121,169 @@ void VulkanEngine::DrawObjects(vk::CommandBuffer cmd, RenderObject *first, int32
       auto vertexBuffer = object.mesh->GetVertexBuffer();
       cmd.bindVertexBuffers(0, 1, &vertexBuffer, &offset);
       lastMesh = object.mesh;
+      _renderStats.vertexBufferBinds++;
+    }
+
+    // Objects with culled meshlets use the indices written by the culling shader
+    const bool culledMeshlets = object.meshletDraw != NO_MESHLET_DRAW;
+    vk::Buffer indexBuffer = culledMeshlets ? frame.meshletIndexBuffer.buffer : object.mesh->GetIndexBuffer();
+    if (indexBuffer != lastIndexBuffer) {
+      cmd.bindIndexBuffer(indexBuffer, 0, vk::IndexType::eUint32);
+      lastIndexBuffer = indexBuffer;
     }
 
-    // Draw
-    cmd.draw(object.mesh->GetVertexCount(), 1, 0, i);
+    // The triangles are counted before the GPU culling, as an upper bound
+    const MeshLod &lod = object.mesh->GetLod(culledMeshlets ? 0 : object.lod);
+    _renderStats.triangles += static_cast<uint64_t>(lod.indexCount / 3) * instanceCount;
+    _renderStats.instances += instanceCount;
+
+    if (culledMeshlets) {
+      cmd.drawIndexedIndirect(frame.meshletDrawBuffer.buffer, object.meshletDraw * drawStride, 1, drawStride);
+      _renderStats.drawCalls++;
+    } else if (occlusionCulled) {
+      // The culling shader set the instance count of each object of the run to 0 or 1
+      const vk::DeviceSize offset = (occlusionDrawOffset + i) * drawStride;
+      if (_multiDrawIndirect) {
+        cmd.drawIndexedIndirect(frame.occlusionDrawBuffer.buffer, offset, instanceCount, drawStride);
+        _renderStats.drawCalls++;
+      } else {
+        for (uint32_t instance = 0; instance < instanceCount; instance++) {
+          cmd.drawIndexedIndirect(frame.occlusionDrawBuffer.buffer, offset + instance * drawStride, 1,
+                                  drawStride);
+        }
+        _renderStats.drawCalls += instanceCount;
+      }
+    } else {
+      // Draw the whole run with the range of the chosen level of detail.
+      // The first instance is the index of the first object in the object buffer.
+      cmd.drawIndexed(lod.indexCount, instanceCount, lod.firstIndex, 0, i);
+      _renderStats.drawCalls++;
+    }
+    i += instanceCount;
+  }
+}
+
+void VulkanEngine::BuildOverlay() {
+  if (!_showOverlay)
+    return;
+
+  ImGui_ImplSDL2_NewFrame(_window);
+  ImGui::NewFrame();
+  _performanceOverlay.Build(_renderStatsHistory, static_cast<float>(_deltaTime * 1000.0), _memoryTracker);
+  ImGui::Render();
+}
+
+void VulkanEngine::DrawOverlay(vk::CommandBuffer cmd) {
+  PROFILE_FUNCTION();
+
+  const ImDrawData *drawData = ImGui::GetDrawData();
+  if (!_showOverlay || drawData == nullptr || drawData->TotalVtxCount == 0)
+    return;
+  FrameData &frame = GetCurrentFrame();
+
+  // Copy the draw lists in the mapped buffers of the frame. The lists that don't fit anymore are skipped.
+  auto *vertices = static_cast<ImDrawVert *>(frame.overlayVertices);
+  auto *indices = static_cast<ImDrawIdx *>(frame.overlayIndices);
+  uint32_t vertexCount = 0;
+  uint32_t indexCount = 0;
+  int32_t listCount = 0;
+  for (; listCount < drawData->CmdListsCount; listCount++) {
+    const ImDrawList *list = drawData->CmdLists[listCount];
+    const auto listVertexCount = static_cast<uint32_t>(list->VtxBuffer.Size);
+    const auto listIndexCount = static_cast<uint32_t>(list->IdxBuffer.Size);
+    if (vertexCount + listVertexCount > OVERLAY_MAX_VERTICES ||
+        indexCount + listIndexCount > OVERLAY_MAX_INDICES)
+      break;
+    memcpy(vertices + vertexCount, list->VtxBuffer.Data, listVertexCount * sizeof(ImDrawVert));
+    memcpy(indices + indexCount, list->IdxBuffer.Data, listIndexCount * sizeof(ImDrawIdx));
+    vertexCount += listVertexCount;
+    indexCount += listIndexCount;
+  }
+  // The memory may not be coherent
+  vmaFlushAllocation(_allocator, frame.overlayVertexBuffer.allocation, 0, vertexCount * sizeof(ImDrawVert));
+  vmaFlushAllocation(_allocator, frame.overlayIndexBuffer.allocation, 0, indexCount * sizeof(ImDrawIdx));
+  _renderStats.bytesUploaded += vertexCount * sizeof(ImDrawVert) + indexCount * sizeof(ImDrawIdx);
+
+  cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, _overlayPipeline);
+  cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, _overlayPipelineLayout, 0, _overlayFontDescriptor,
+                         nullptr);
+  vk::DeviceSize offset = 0;
+  cmd.bindVertexBuffers(0, 1, &frame.overlayVertexBuffer.buffer, &offset);
+  cmd.bindIndexBuffer(frame.overlayIndexBuffer.buffer, 0,
+                      sizeof(ImDrawIdx) == 2 ? vk::IndexType::eUint16 : vk::IndexType::eUint32);
+
+  // Map the display rectangle of ImGui to the clip space
+  const glm::vec2 scale(2.0f / drawData->DisplaySize.x, 2.0f / drawData->DisplaySize.y);
+  const glm::vec4 transform(scale, -1.0f - drawData->DisplayPos.x * scale.x,
+                            -1.0f - drawData->DisplayPos.y * scale.y);
+  cmd.pushConstants(_overlayPipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(glm::vec4),
+                    &transform);
+  _renderStats.pipelineBinds++;
+  _renderStats.descriptorBinds++;
+  _renderStats.vertexBufferBinds++;
+  _renderStats.pushConstantCalls++;
+
+  uint32_t firstVertex = 0;
+  uint32_t firstIndex = 0;
+  for (int32_t l = 0; l < listCount; l++) {
+    const ImDrawList *list = drawData->CmdLists[l];
+    for (const ImDrawCmd &command : list->CmdBuffer) {
+      // The overlay doesn't use callbacks
+      if (command.UserCallback != nullptr)
+        continue;
+
+      // Clip rectangle in framebuffer space, clamped to the window
+      const ImVec2 clipScale = drawData->FramebufferScale;
+      const float minX = std::max((command.ClipRect.x - drawData->DisplayPos.x) * clipScale.x, 0.0f);
+      const float minY = std::max((command.ClipRect.y - drawData->DisplayPos.y) * clipScale.y, 0.0f);
+      const float maxX = std::min((command.ClipRect.z - drawData->DisplayPos.x) * clipScale.x,
+                                  static_cast<float>(_windowExtent.width));
+      const float maxY = std::min((command.ClipRect.w - drawData->DisplayPos.y) * clipScale.y,
+                                  static_cast<float>(_windowExtent.height));
+      if (maxX <= minX || maxY <= minY)
+        continue;
+
+      cmd.setScissor(0, vk::Rect2D{
+                            .offset = {.x = static_cast<int32_t>(minX), .y = static_cast<int32_t>(minY)},
+                            .extent = {.width = static_cast<uint32_t>(maxX - minX),
+                                       .height = static_cast<uint32_t>(maxY - minY)},
+                        });
+      cmd.drawIndexed(command.ElemCount, 1, firstIndex + command.IdxOffset,
+                      static_cast<int32_t>(firstVertex + command.VtxOffset), 0);
+      _renderStats.drawCalls++;
+      _renderStats.instances++;
+      _renderStats.triangles += command.ElemCount / 3;
+    }
+    firstVertex += static_cast<uint32_t>(list->VtxBuffer.Size);
+    firstIndex += static_cast<uint32_t>(list->IdxBuffer.Size);
   }
 }
 
 template <class T>
-void VulkanEngine::CopyBufferToAllocation(const T *src, const VmaAllocation &allocation, bool applyPadding, size_t size) {
+void VulkanEngine::CopyBufferToAllocation(const T *src, const VmaAllocation &allocation, size_t size) {
   char *data = nullptr;
   // Map memory
   vmaMapMemory(_allocator, allocation, (void **)&data);
-  // Apply padding if needed
-  if (applyPadding) {
-    uint32_t frameIndex = _frameNumber % FRAME_OVERLAP;
-    data += PadUniformBufferSize(size) * frameIndex;
-  }
   // Copy data to it
   memcpy(data, src, size);
   // Unmap memory
   vmaUnmapMemory(_allocator, allocation);
 }
 
-size_t VulkanEngine::PadUniformBufferSize(size_t originalSize) const {
-  size_t minAlignment = _gpuProperties.limits.minUniformBufferOffsetAlignment;
-  size_t alignedSize = originalSize;
-  if (minAlignment > 0) {
-    alignedSize = (alignedSize + minAlignment - 1) & ~(minAlignment - 1);
-  }
-  return alignedSize;
-}
-
 void VulkanEngine::InitScene() {
+  PROFILE_FUNCTION();
+
   // Set camera spawn point
   _cameraPosition = glm::vec3(3.f, 0.0f, 0.0f);
+  _previousCameraPosition = _cameraPosition;
+  _simulatedCameraPosition = _cameraPosition;
 
   // Create monkey render object
   Material *defaultMaterial = GetMaterial("default");
   RenderObject monkey{
       .mesh = GetMesh("monkey"),
       .material = defaultMaterial,
-      .transformMatrix = glm::mat4{1.0f},
+      .transform = _transforms.Add(Transform{}),
       .albedo = glm::vec4(1.0f),
   };
   _renderables.push_back(monkey);
@@ -993,35 +2292,224 @@ void VulkanEngine::InitScene() {
   RenderObject redMonkey{
       .mesh = GetMesh("monkey"),
       .material = redMaterial,
-      .transformMatrix = glm::translate(glm::mat4{1.0f}, glm::vec3{3.0f, 0.f, 2.0f}),
+      .transform = _transforms.Add(Transform{.position = glm::vec3{3.0f, 0.f, 2.0f}}),
       .albedo = glm::vec4(1.0f),
   };
   _renderables.push_back(redMonkey);
 
-  // Create triangles
-  Mesh *triangleMesh = GetMesh("triangle");
-  glm::mat4 scale = glm::scale(glm::mat4{1.0f}, glm::vec3(0.2, 0.2, 0.2));
-  for (int x = -20; x <= 20; x++) {
-    for (int y = -20; y <= 20; y++) {
-
-      // Create transform matrix
-      glm::mat4 translation = glm::translate(glm::mat4{1.0f}, glm::vec3(x, 0, y));
-
-      // Create triangle render object
-      RenderObject triangle{
-          .mesh = triangleMesh,
-          .material = defaultMaterial,
-          .transformMatrix = translation * scale,
-          .albedo =
-              glm::vec4{static_cast<float>(x + 20) / 40.f, static_cast<float>(y + 20) / 40.f, 0.1f, 1.0f},
+  // Textured monkey, if the texture could be loaded
+  Material *texturedMaterial = GetMaterial("textured");
+  if (texturedMaterial != nullptr) {
+    RenderObject texturedMonkey{
+        .mesh = GetMesh("monkey"),
+        .material = texturedMaterial,
+        .transform = _transforms.Add(Transform{.position = glm::vec3{-3.0f, 0.f, 2.0f}}),
+        .albedo = glm::vec4(1.0f),
+    };
+    _renderables.push_back(texturedMonkey);
+  }
+
+  // Line of monkeys going away from the camera, to see the levels of detail.
+  // The first one hides a part of the others for the CPU occlusion culling.
+  const TransformId line = _transforms.Add(Transform{.position = glm::vec3{-3.0f, 0.f, -6.0f}});
+  for (int i = 0; i < 12; i++) {
+    RenderObject distantMonkey{
+        .mesh = GetMesh("monkey"),
+        .material = defaultMaterial,
+        .transform = _transforms.Add(Transform{.position = glm::vec3{0.0f, 0.f, -8.0f * i}}, line),
+        .albedo = glm::vec4(1.0f),
+        .occluder = i == 0,
+    };
+    _renderables.push_back(distantMonkey);
+  }
+
+  // The monkey may still be loading
+  for (RenderObject &object : _renderables) {
+    UsePlaceholderWhileLoading(object);
+  }
+
+  _streamedObjectsStart = static_cast<uint32_t>(_renderables.size());
+  UpdateTransforms(1.0f);
+
+  // The static objects come from the scene file
+  LoadScene();
+  StreamScene();
+}
+
+void VulkanEngine::LoadScene() {
+  PROFILE_FUNCTION();
+
+  // The cooked scene is mapped and read in place. Without it, the source is cooked in memory.
+  bool loaded = false;
+  if (std::filesystem::exists(SCENE_COOKED_PATH)) {
+    loaded = _sceneStreamer.Open(SCENE_COOKED_PATH);
+    if (!loaded) {
+      std::cerr << "Can't use " << SCENE_COOKED_PATH << ", cooking " << SCENE_SOURCE_PATH << " instead\n";
+    }
+  }
+  if (!loaded) {
+    std::vector<uint8_t> container;
+    loaded = scenecook::CookScene(SCENE_SOURCE_PATH, container) && _sceneStreamer.Open(std::move(container));
+    if (!loaded)
+      return;
+  }
+
+  // Names are resolved once for the whole scene. The instances of unknown meshes or materials are skipped.
+  _sceneMeshes.clear();
+  for (const auto &name : _sceneStreamer.GetMeshNames()) {
+    _sceneMeshes.push_back(GetMesh(name));
+    if (_sceneMeshes.back() == nullptr) {
+      std::cerr << "[Scene] Unknown mesh " << name << '\n';
+    }
+  }
+  _sceneMaterials.clear();
+  for (const auto &name : _sceneStreamer.GetMaterialNames()) {
+    _sceneMaterials.push_back(GetMaterial(name));
+    if (_sceneMaterials.back() == nullptr) {
+      std::cerr << "[Scene] Unknown material " << name << '\n';
+    }
+  }
+
+  // Streaming never goes over the capacity of the object buffers
+  _renderables.reserve(MAX_OBJECTS);
+  std::cout << "[Scene] " << _sceneStreamer.GetInstanceCount() << " instances in "
+            << _sceneStreamer.GetChunkCount() << " chunks\n";
+}
+
+void VulkanEngine::StreamScene() {
+  if (_sceneStreamer.GetChunkCount() == 0)
+    return;
+  PROFILE_FUNCTION();
+
+  const uint32_t maxInstances = MAX_OBJECTS - std::min(_streamedObjectsStart, MAX_OBJECTS);
+  _sceneStreamer.Update(-_cameraPosition, SCENE_STREAMING_RADIUS, maxInstances, SCENE_MAX_CHUNK_LOADS,
+                        _chunksToLoad, _chunksToUnload);
+  if (!_chunksToLoad.empty() || !_chunksToUnload.empty()) {
+    _bvhOutdated = true;
+  }
+
+  // Remove the objects of the unloaded chunks, and move the following ones back
+  for (uint32_t chunk : _chunksToUnload) {
+    auto streamedChunk = std::find_if(_streamedChunks.begin(), _streamedChunks.end(),
+                                      [chunk](const StreamedChunk &c) { return c.chunk == chunk; });
+    const auto first = _renderables.begin() + streamedChunk->firstObject;
+    _renderables.erase(first, first + streamedChunk->objectCount);
+    for (auto next = streamedChunk + 1; next != _streamedChunks.end(); ++next) {
+      next->firstObject -= streamedChunk->objectCount;
+    }
+    _streamedChunks.erase(streamedChunk);
+  }
+
+  // Append the objects of the loaded chunks. The instances are sorted by mesh and material in each chunk,
+  // so they are drawn as instances.
+  const SceneInstances &instances = _sceneStreamer.GetInstances();
+  for (uint32_t chunk : _chunksToLoad) {
+    const SceneContainerChunk &chunkInfo = _sceneStreamer.GetChunk(chunk);
+    const auto firstObject = static_cast<uint32_t>(_renderables.size());
+    _renderables.resize(firstObject + chunkInfo.instanceCount);
+
+    uint32_t objectCount = 0;
+    for (uint32_t i = chunkInfo.firstInstance; i < chunkInfo.firstInstance + chunkInfo.instanceCount; i++) {
+      const uint16_t meshIndex = instances.meshIndices[i];
+      const uint16_t materialIndex = instances.materialIndices[i];
+      Mesh *mesh = meshIndex < _sceneMeshes.size() ? _sceneMeshes[meshIndex] : nullptr;
+      Material *material = materialIndex < _sceneMaterials.size() ? _sceneMaterials[materialIndex] : nullptr;
+      if (mesh == nullptr || material == nullptr)
+        continue;
+
+      const float *position = instances.positions + 3 * i;
+      const float *rotation = instances.rotations + 4 * i;
+      const float *scale = instances.scales + 3 * i;
+      _renderables[firstObject + objectCount] = RenderObject{
+          .mesh = mesh,
+          .material = material,
+          .transform = NO_TRANSFORM,
+          .transformMatrix = glm::translate(glm::vec3(position[0], position[1], position[2])) *
+                             glm::mat4_cast(glm::quat(rotation[3], rotation[0], rotation[1], rotation[2])) *
+                             glm::scale(glm::vec3(scale[0], scale[1], scale[2])),
+          .albedo = glm::unpackUnorm4x8(instances.colors[i]),
+          .occluder = (instances.flags[i] & SCENE_INSTANCE_OCCLUDER) != 0,
       };
-      _renderables.push_back(triangle);
+      UsePlaceholderWhileLoading(_renderables[firstObject + objectCount]);
+      objectCount++;
     }
+
+    _renderables.resize(firstObject + objectCount);
+    _streamedChunks.push_back(StreamedChunk{
+        .chunk = chunk,
+        .firstObject = firstObject,
+        .objectCount = objectCount,
+    });
   }
 }
+
+void VulkanEngine::UpdateTransforms(float alpha) {
+  _transforms.Update(alpha);
+  // The streamed objects are static: their matrix is set when their chunk is loaded
+  for (uint32_t i = 0; i < _streamedObjectsStart; i++) {
+    const glm::mat4 &matrix = _transforms.GetWorldMatrix(_renderables[i].transform);
+    if (matrix != _renderables[i].transformMatrix) {
+      _renderables[i].transformMatrix = matrix;
+      _movedObjects.push_back(i);
+    }
+  }
+}
+
+void VulkanEngine::UpdateBvh() {
+  PROFILE_FUNCTION();
+
+  // Objects were added or removed, so the indices changed: the tree is rebuilt right away.
+  // A rebuild started before still uses the old indices, so it is dropped.
+  if (_bvhOutdated) {
+    std::vector<Aabb> bounds(_renderables.size());
+    for (uint32_t i = 0; i < _renderables.size(); i++) {
+      bounds[i] = GetWorldBox(_renderables[i]);
+    }
+    _bvh.Build(std::move(bounds));
+    _bvhOutdated = false;
+    _bvhRebuild = {};
+    _movedDuringRebuild.clear();
+    _movedObjects.clear();
+    return;
+  }
+
+  for (uint32_t object : _movedObjects) {
+    _bvh.Refit(object, GetWorldBox(_renderables[object]));
+  }
+  if (_bvhRebuild.valid()) {
+    _movedDuringRebuild.insert(_movedDuringRebuild.end(), _movedObjects.begin(), _movedObjects.end());
+  }
+  _movedObjects.clear();
+
+  // Use the rebuilt tree once it is ready. It has the bounds from when it was started.
+  if (_bvhRebuild.valid() && _bvhRebuild.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+    _bvh = _bvhRebuild.get();
+    for (uint32_t object : _movedDuringRebuild) {
+      _bvh.Refit(object, GetWorldBox(_renderables[object]));
+    }
+    _movedDuringRebuild.clear();
+  }
+
+  // Refits make the nodes looser over time: rebuild the tree in the background when it got too slow
+  if (!_bvhRebuild.valid() && _frameNumber % BVH_QUALITY_CHECK_FRAMES == 0 &&
+      _bvh.GetDegradation() > BVH_REBUILD_DEGRADATION) {
+    std::vector<Aabb> bounds(_bvh.GetObjectCount());
+    for (uint32_t i = 0; i < bounds.size(); i++) {
+      bounds[i] = _bvh.GetBounds(i);
+    }
+    _bvhRebuild = _jobSystem.Submit([bounds = std::move(bounds)]() mutable {
+      Bvh bvh;
+      bvh.Build(std::move(bounds));
+      return bvh;
+    });
+  }
+}
+
 FrameData &VulkanEngine::GetCurrentFrame() { return _frames[_frameNumber % FRAME_OVERLAP]; }
 
 void VulkanEngine::ImmediateSubmit(std::function<void(vk::CommandBuffer)> &&function) {
+  PROFILE_FUNCTION();
+
   // Allocate default command buffer for instant commands
   vk::CommandBufferAllocateInfo cmdAllocInfo{
       .commandPool = _uploadContext.commandPool,
@@ -1056,50 +2544,371 @@ void VulkanEngine::ImmediateSubmit(std::function<void(vk::CommandBuffer)> &&func
   _device.resetCommandPool(_uploadContext.commandPool);
 }
 
+Task<> VulkanEngine::SubmitAsync(std::function<void(vk::CommandBuffer)> function) {
+  // Each upload has its own command buffer and fence, since several can be in flight
+  vk::CommandBufferAllocateInfo cmdAllocInfo{
+      .commandPool = _uploadContext.asyncCommandPool,
+      .level = vk::CommandBufferLevel::ePrimary,
+      .commandBufferCount = 1,
+  };
+  vk::CommandBuffer cmd = _device.allocateCommandBuffers(cmdAllocInfo)[0];
+  vk::Fence fence = _device.createFence(vk::FenceCreateInfo{});
+
+  vk::CommandBufferBeginInfo cmdBeginInfo{
+      .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
+  };
+  cmd.begin(cmdBeginInfo);
+  function(cmd);
+  cmd.end();
+
+  vk::SubmitInfo submit{
+      .commandBufferCount = 1,
+      .pCommandBuffers = &cmd,
+  };
+  _graphicsQueue.submit(1, &submit, fence);
+
+  // Check the fence at each poll instead of waiting for it
+  _asyncUploadCount++;
+  co_await _taskScheduler.WaitUntil(
+      [this, fence]() { return _device.getFenceStatus(fence) == vk::Result::eSuccess; });
+  _asyncUploadCount--;
+
+  _device.destroyFence(fence);
+  _device.freeCommandBuffers(_uploadContext.asyncCommandPool, cmd);
+}
+
 void VulkanEngine::UploadMesh(Mesh &mesh) {
-  const size_t bufferSize = mesh.GetVertexCount() * sizeof(Vertex);
-  // Allocate staging vertexBuffer
+  PendingUpload upload = PrepareMeshUpload(mesh);
+  ImmediateSubmit(std::move(upload.recordCopies));
+  FinishMeshUpload(mesh, upload.stagingBuffer);
+}
+
+Task<> VulkanEngine::UploadMeshAsync(Mesh &mesh) {
+  PendingUpload upload = PrepareMeshUpload(mesh);
+  co_await SubmitAsync(std::move(upload.recordCopies));
+  FinishMeshUpload(mesh, upload.stagingBuffer);
+}
+
+PendingUpload VulkanEngine::PrepareMeshUpload(Mesh &mesh) {
+  const size_t vertexBufferSize = mesh.GetVertexCount() * sizeof(Vertex);
+  const size_t indexBufferSize = mesh.GetIndexCount() * sizeof(uint32_t);
+  const auto &meshlets = mesh.GetMeshlets();
+  const size_t meshletBufferSize = meshlets.size() * sizeof(meshutils::Meshlet);
+  const bool cullMeshlets = !meshlets.empty() && _meshletCullPipeline;
+  // Allocate staging buffer, with the vertices followed by the indices and the meshlets
   vk::BufferCreateInfo stagingBufferInfo{
-      .size = bufferSize,
+      .size = vertexBufferSize + indexBufferSize + (cullMeshlets ? meshletBufferSize : 0),
       .usage = vk::BufferUsageFlagBits::eTransferSrc,
   };
-  VmaAllocationCreateInfo vmaAllocInfo{
-      .usage = VMA_MEMORY_USAGE_CPU_ONLY,
-  };
-  AllocatedBuffer stagingBuffer;
-  vmaCreateBuffer(_allocator, (VkBufferCreateInfo *)&stagingBufferInfo, &vmaAllocInfo,
-                  (VkBuffer *)&stagingBuffer.buffer, &stagingBuffer.allocation, nullptr);
+  AllocatedBuffer stagingBuffer =
+      _memoryPools.CreateBuffer(stagingBufferInfo, VMA_MEMORY_USAGE_CPU_ONLY, MemoryCategory::eStaging);
 
-  // Copy data to this vertexBuffer
+  // Copy data to this buffer
   auto vertices = mesh.GetVertices();
-  CopyBufferToAllocation(vertices.data(), stagingBuffer.allocation, false, bufferSize);
+  const auto &indices = mesh.GetIndices();
+  char *stagingData = nullptr;
+  vmaMapMemory(_allocator, stagingBuffer.allocation, (void **)&stagingData);
+  memcpy(stagingData, vertices.data(), vertexBufferSize);
+  memcpy(stagingData + vertexBufferSize, indices.data(), indexBufferSize);
+  if (cullMeshlets) {
+    memcpy(stagingData + vertexBufferSize + indexBufferSize, meshlets.data(), meshletBufferSize);
+  }
+  vmaUnmapMemory(_allocator, stagingBuffer.allocation);
 
-  // Allocate vertex vertexBuffer
+  // Allocate vertex buffer
   vk::BufferCreateInfo vertexBufferInfo {
-      .size = bufferSize,
+      .size = vertexBufferSize,
       .usage = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
   };
-  vmaAllocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
   vk::Buffer &vertexBuffer = mesh.GetVertexBuffer();
   VmaAllocation &allocation = mesh.GetAllocation();
-  vmaCreateBuffer(_allocator, (VkBufferCreateInfo*) &vertexBufferInfo, &vmaAllocInfo, (VkBuffer*) &vertexBuffer, &allocation, nullptr);
+  AllocatedBuffer newBuffer =
+      _memoryPools.CreateBuffer(vertexBufferInfo, VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::eGeometry);
+  vertexBuffer = newBuffer.buffer;
+  allocation = newBuffer.allocation;
+  _defragmenter.Register(vertexBuffer, allocation, vertexBufferInfo);
+
+  // Allocate index buffer. The culling shader also reads it to copy the visible meshlets
+  vk::BufferCreateInfo indexBufferInfo{
+      .size = indexBufferSize,
+      .usage = vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+  };
+  if (cullMeshlets) {
+    indexBufferInfo.usage |= vk::BufferUsageFlagBits::eStorageBuffer;
+  }
+  vk::Buffer &indexBuffer = mesh.GetIndexBuffer();
+  VmaAllocation &indexAllocation = mesh.GetIndexAllocation();
+  newBuffer =
+      _memoryPools.CreateBuffer(indexBufferInfo, VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::eGeometry);
+  indexBuffer = newBuffer.buffer;
+  indexAllocation = newBuffer.allocation;
+  _defragmenter.Register(indexBuffer, indexAllocation, indexBufferInfo);
+
+  // Allocate meshlet buffer, if the meshlets of this mesh are culled
+  vk::Buffer &meshletBuffer = mesh.GetMeshletBuffer();
+  VmaAllocation &meshletAllocation = mesh.GetMeshletAllocation();
+  if (cullMeshlets) {
+    vk::BufferCreateInfo meshletBufferInfo{
+        .size = meshletBufferSize,
+        .usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+    };
+    newBuffer =
+        _memoryPools.CreateBuffer(meshletBufferInfo, VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::eGeometry);
+    meshletBuffer = newBuffer.buffer;
+    meshletAllocation = newBuffer.allocation;
+    _defragmenter.Register(meshletBuffer, meshletAllocation, meshletBufferInfo);
+  }
 
-  // Copy from staging vertexBuffer to vertex vertexBuffer
-  ImmediateSubmit([bufferSize, stagingBuffer, vertexBuffer](vk::CommandBuffer cmd) {
-    vk::BufferCopy copy {
+  // Copy from staging buffer to the mesh buffers
+  auto recordCopies = [vertexBufferSize, indexBufferSize, meshletBufferSize, stagingBuffer, vertexBuffer,
+                       indexBuffer, meshletBuffer](vk::CommandBuffer cmd) {
+    vk::BufferCopy vertexCopy {
       .srcOffset = 0,
       .dstOffset = 0,
-      .size = bufferSize,
+      .size = vertexBufferSize,
     };
-    cmd.copyBuffer(stagingBuffer.buffer, vertexBuffer, 1, &copy);
-  });
+    cmd.copyBuffer(stagingBuffer.buffer, vertexBuffer, 1, &vertexCopy);
+    vk::BufferCopy indexCopy{
+        .srcOffset = vertexBufferSize,
+        .dstOffset = 0,
+        .size = indexBufferSize,
+    };
+    cmd.copyBuffer(stagingBuffer.buffer, indexBuffer, 1, &indexCopy);
+    if (meshletBuffer) {
+      vk::BufferCopy meshletCopy{
+          .srcOffset = vertexBufferSize + indexBufferSize,
+          .dstOffset = 0,
+          .size = meshletBufferSize,
+      };
+      cmd.copyBuffer(stagingBuffer.buffer, meshletBuffer, 1, &meshletCopy);
+    }
+  };
+  return PendingUpload{
+      .stagingBuffer = stagingBuffer,
+      .recordCopies = recordCopies,
+  };
+}
+
+void VulkanEngine::FinishMeshUpload(Mesh &mesh, const AllocatedBuffer &stagingBuffer) {
+  vk::Buffer &vertexBuffer = mesh.GetVertexBuffer();
+  vk::Buffer &indexBuffer = mesh.GetIndexBuffer();
+  vk::Buffer &meshletBuffer = mesh.GetMeshletBuffer();
+  VmaAllocation &allocation = mesh.GetAllocation();
+  VmaAllocation &indexAllocation = mesh.GetIndexAllocation();
+  VmaAllocation &meshletAllocation = mesh.GetMeshletAllocation();
 
   // Clean up
-  _mainDeletionQueue.PushFunction([this, vertexBuffer, allocation]() {
-    vmaDestroyBuffer(_allocator, vertexBuffer, allocation);
-  });
+  _mainDeletionQueue.Push(AllocatedBuffer{.buffer = vertexBuffer, .allocation = allocation});
+  _mainDeletionQueue.Push(AllocatedBuffer{.buffer = indexBuffer, .allocation = indexAllocation});
+  if (meshletBuffer) {
+    _mainDeletionQueue.Push(AllocatedBuffer{.buffer = meshletBuffer, .allocation = meshletAllocation});
+  }
+
+  // Give the meshlets to the culling shader
+  if (meshletBuffer) {
+    vkinit::DescriptorSetAllocator(_descriptorPool)
+        .AddSetWithLayout(_meshletMeshSetLayout, &_meshletDescriptors[&mesh])
+        .Allocate(_device)
+        .AddBuffer(0, 0, meshletBuffer, mesh.GetMeshlets().size() * sizeof(meshutils::Meshlet))
+        .AddBuffer(0, 1, indexBuffer, mesh.GetIndexCount() * sizeof(uint32_t))
+        .Write(_device);
+  }
+  // Destroy staging buffer right now
+  _memoryTracker.Untrack(stagingBuffer.allocation);
+  vmaDestroyBuffer(_allocator, stagingBuffer.buffer, stagingBuffer.allocation);
+}
+
+Texture *VulkanEngine::UploadTexture(const std::string &name, const TextureUploadInfo &uploadInfo) {
+  Texture texture;
+  PendingUpload upload = PrepareTextureUpload(uploadInfo, texture);
+  ImmediateSubmit(std::move(upload.recordCopies));
+  return FinishTextureUpload(name, texture, upload.stagingBuffer);
+}
+
+Task<Texture *> VulkanEngine::UploadTextureAsync(std::string name, TextureUploadInfo uploadInfo) {
+  Texture texture;
+  PendingUpload upload = PrepareTextureUpload(uploadInfo, texture);
+  co_await SubmitAsync(std::move(upload.recordCopies));
+  co_return FinishTextureUpload(name, texture, upload.stagingBuffer);
+}
+
+PendingUpload VulkanEngine::PrepareTextureUpload(const TextureUploadInfo &uploadInfo, Texture &texture) {
+  // Allocate staging buffer holding the whole mip chain
+  vk::BufferCreateInfo stagingBufferInfo{
+      .size = uploadInfo.dataSize,
+      .usage = vk::BufferUsageFlagBits::eTransferSrc,
+  };
+  AllocatedBuffer stagingBuffer =
+      _memoryPools.CreateBuffer(stagingBufferInfo, VMA_MEMORY_USAGE_CPU_ONLY, MemoryCategory::eStaging);
+  CopyBufferToAllocation(uploadInfo.data, stagingBuffer.allocation, uploadInfo.dataSize);
+
+  // Allocate the image
+  texture = Texture{
+      .format = uploadInfo.format,
+      .mipLevels = static_cast<uint32_t>(uploadInfo.mips.size()),
+  };
+  vk::Extent3D extent{
+      .width = uploadInfo.mips[0].width,
+      .height = uploadInfo.mips[0].height,
+      .depth = 1,
+  };
+  auto imageCreateInfo =
+      vkinit::ImageCreateInfo(texture.format, vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst,
+                              extent, texture.mipLevels);
+  texture.image =
+      _memoryPools.CreateImage(imageCreateInfo, VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::eTextures);
+
+  // Copy every mip level from the staging buffer
+  std::vector<vk::BufferImageCopy> copyRegions;
+  copyRegions.reserve(uploadInfo.mips.size());
+  for (uint32_t i = 0; i < texture.mipLevels; i++) {
+    const MipLevel &mip = uploadInfo.mips[i];
+    copyRegions.push_back(vk::BufferImageCopy{
+        .bufferOffset = mip.offset,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource{
+            .aspectMask = vk::ImageAspectFlagBits::eColor,
+            .mipLevel = i,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+        .imageOffset = {0, 0, 0},
+        .imageExtent = {mip.width, mip.height, 1},
+    });
+  }
+  auto recordCopies = [image = texture.image.image, mipLevels = texture.mipLevels, copyRegions,
+                       stagingBuffer](vk::CommandBuffer cmd) {
+    vk::ImageSubresourceRange range{
+        .aspectMask = vk::ImageAspectFlagBits::eColor,
+        .baseMipLevel = 0,
+        .levelCount = mipLevels,
+        .baseArrayLayer = 0,
+        .layerCount = 1,
+    };
+
+    // Prepare the image to receive the copies
+    vk::ImageMemoryBarrier toTransferBarrier{
+        .srcAccessMask = {},
+        .dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .oldLayout = vk::ImageLayout::eUndefined,
+        .newLayout = vk::ImageLayout::eTransferDstOptimal,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange = range,
+    };
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {},
+                        nullptr, nullptr, toTransferBarrier);
+
+    cmd.copyBufferToImage(stagingBuffer.buffer, image, vk::ImageLayout::eTransferDstOptimal, copyRegions);
+
+    // Make it readable by the shaders
+    vk::ImageMemoryBarrier toShaderBarrier{
+        .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .dstAccessMask = vk::AccessFlagBits::eShaderRead,
+        .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+        .newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange = range,
+    };
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {},
+                        nullptr, nullptr, toShaderBarrier);
+  };
+  return PendingUpload{
+      .stagingBuffer = stagingBuffer,
+      .recordCopies = recordCopies,
+  };
+}
+
+Texture *VulkanEngine::FinishTextureUpload(const std::string &name, Texture &texture,
+                                           const AllocatedBuffer &stagingBuffer) {
   // Destroy staging buffer right now
+  _memoryTracker.Untrack(stagingBuffer.allocation);
   vmaDestroyBuffer(_allocator, stagingBuffer.buffer, stagingBuffer.allocation);
+
+  // Create the view
+  auto imageViewCreateInfo = vkinit::ImageViewCreateInfo(texture.format, texture.image.image,
+                                                         vk::ImageAspectFlagBits::eColor, texture.mipLevels);
+  texture.imageView = _device.createImageView(imageViewCreateInfo);
+
+  // Register deletion
+  _mainDeletionQueue.Push(texture.imageView);
+  _mainDeletionQueue.Push(texture.image);
+
+  // Expose it to the bindless materials
+  if (_bindless) {
+    texture.bindlessIndex = RegisterBindlessTexture(texture.imageView, _defaultSampler);
+  }
+
+  _textures[name] = texture;
+  return &_textures[name];
+}
+
+void VulkanEngine::DefragmentMemory() {
+  // The moved buffers are recreated and their descriptors rewritten, so no frame may still use them
+  std::array<vk::Fence, FRAME_OVERLAP> fences;
+  for (uint32_t i = 0; i < FRAME_OVERLAP; i++) {
+    fences[i] = _frames[i].renderFence;
+  }
+  if (_device.waitForFences(fences, true, 1000000000) != vk::Result::eSuccess)
+    throw std::runtime_error("Error while waiting for fences");
+
+  // Move a bounded amount of memory with the GPU
+  ImmediateSubmit([this](vk::CommandBuffer cmd) {
+    _defragmenter.BeginPass(cmd);
+
+    vk::MemoryBarrier barrier{
+        .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead |
+                         vk::AccessFlagBits::eShaderRead,
+    };
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                        vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eComputeShader,
+                        {}, barrier, nullptr, nullptr);
+  });
+  DefragmentationReport report = _defragmenter.EndPass(_frameNumber);
+
+  // Point the meshlet culling to the new buffers
+  for (auto &[name, mesh] : _meshes) {
+    auto descriptor = _meshletDescriptors.find(&mesh);
+    if (descriptor == _meshletDescriptors.end())
+      continue;
+    auto moved = [&report](VmaAllocation allocation) {
+      return std::find(report.movedAllocations.begin(), report.movedAllocations.end(), allocation) !=
+             report.movedAllocations.end();
+    };
+    if (!moved(mesh.GetMeshletAllocation()) && !moved(mesh.GetIndexAllocation()))
+      continue;
+
+    vk::DescriptorBufferInfo meshletBufferInfo{.buffer = mesh.GetMeshletBuffer(), .range = VK_WHOLE_SIZE};
+    vk::DescriptorBufferInfo indexBufferInfo{.buffer = mesh.GetIndexBuffer(), .range = VK_WHOLE_SIZE};
+    std::array<vk::WriteDescriptorSet, 2> writes{
+        vk::WriteDescriptorSet{
+            .dstSet = descriptor->second,
+            .dstBinding = 0,
+            .descriptorCount = 1,
+            .descriptorType = vk::DescriptorType::eStorageBuffer,
+            .pBufferInfo = &meshletBufferInfo,
+        },
+        vk::WriteDescriptorSet{
+            .dstSet = descriptor->second,
+            .dstBinding = 1,
+            .descriptorCount = 1,
+            .descriptorType = vk::DescriptorType::eStorageBuffer,
+            .pBufferInfo = &indexBufferInfo,
+        },
+    };
+    _device.updateDescriptorSets(writes, nullptr);
+  }
+
+  std::cout << "[Memory] Defragmentation moved " << report.movedAllocations.size() << " buffers ("
+            << report.bytesMoved / 1024 << " KiB), freed " << report.blocksFreed << " blocks ("
+            << report.bytesFreed / 1024 << " KiB)\n"
+            << "  before: " << report.before.ToString() << '\n'
+            << "  after:  " << report.after.ToString() << '\n';
 }
 
 // ===== PIPELINE BUILDER =====
@@ -1108,7 +2917,13 @@ vk::Pipeline PipelineBuilder::Build(vk::Device device, vk::RenderPass pass) {
 
   // Set pipeline blend
   _colorBlendAttachment = vk::PipelineColorBlendAttachmentState{
-      .blendEnable = false,
+      .blendEnable = _alphaBlending,
+      .srcColorBlendFactor = vk::BlendFactor::eSrcAlpha,
+      .dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha,
+      .colorBlendOp = vk::BlendOp::eAdd,
+      .srcAlphaBlendFactor = vk::BlendFactor::eOne,
+      .dstAlphaBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha,
+      .alphaBlendOp = vk::BlendOp::eAdd,
       .colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
                         vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA,
   };
@@ -1136,6 +2951,20 @@ vk::Pipeline PipelineBuilder::Build(vk::Device device, vk::RenderPass pass) {
   if (!_depthSettingsProvided)
     WithDepthTestingSettings(false, false);
 
+  // Point the stages to the specialization constants. The builder is copied by each call, so the pointers
+  // are only valid once it is final.
+  if (!_specializationEntries.empty()) {
+    _specializationInfo = vk::SpecializationInfo{
+        .mapEntryCount = static_cast<uint32_t>(_specializationEntries.size()),
+        .pMapEntries = _specializationEntries.data(),
+        .dataSize = _specializationData.size() * sizeof(uint32_t),
+        .pData = _specializationData.data(),
+    };
+    for (auto &stage : _shaderStages) {
+      stage.pSpecializationInfo = &_specializationInfo;
+    }
+  }
+
   // Create viewport state from stored viewport and scissors
   vk::PipelineViewportStateCreateInfo viewportState{
       .viewportCount = 1,
@@ -1150,6 +2979,10 @@ vk::Pipeline PipelineBuilder::Build(vk::Device device, vk::RenderPass pass) {
       .attachmentCount = 1,
       .pAttachments = &_colorBlendAttachment,
   };
+  vk::PipelineDynamicStateCreateInfo dynamicState{
+      .dynamicStateCount = static_cast<uint32_t>(_dynamicStates.size()),
+      .pDynamicStates = _dynamicStates.data(),
+  };
 
 #ifndef NDEBUG
   if (!_pipelineLayoutInited) {
@@ -1174,6 +3007,7 @@ vk::Pipeline PipelineBuilder::Build(vk::Device device, vk::RenderPass pass) {
       .pMultisampleState = &_multisampling,
       .pDepthStencilState = &_depthStencilCreateInfo,
       .pColorBlendState = &colorBlending,
+      .pDynamicState = _dynamicStates.empty() ? nullptr : &dynamicState,
       .layout = _pipelineLayout,
       .renderPass = pass,
       .subpass = 0,
@@ -1331,14 +3165,22 @@ PipelineBuilder PipelineBuilder::WithDepthTestingSettings(bool doDepthTest, bool
   return *this;
 }
 
-// ==== DeletionQueue ====
+PipelineBuilder PipelineBuilder::WithAlphaBlending() {
+  _alphaBlending = true;
+  return *this;
+}
 
-void DeletionQueue::PushFunction(std::function<void()> &&ppFunction) { _deletors.push_back(ppFunction); }
-void DeletionQueue::Flush() {
-  // Reverse iterate the deletion queue to execute all the functions
-  for (auto it = _deletors.rbegin(); it != _deletors.rend(); it++) {
-    (*it)();
-  }
+PipelineBuilder PipelineBuilder::WithDynamicState(vk::DynamicState state) {
+  _dynamicStates.push_back(state);
+  return *this;
+}
 
-  _deletors.clear();
+PipelineBuilder PipelineBuilder::WithSpecializationConstant(uint32_t constantId, uint32_t value) {
+  _specializationEntries.push_back(vk::SpecializationMapEntry{
+      .constantID = constantId,
+      .offset = static_cast<uint32_t>(_specializationData.size() * sizeof(uint32_t)),
+      .size = sizeof(uint32_t),
+  });
+  _specializationData.push_back(value);
+  return *this;
 }
@@ -4,14 +4,39 @@
 
 #pragma once
 
+#include "Bvh.h"
+#include "DeletionQueue.h"
+#include "Defragmenter.h"
+#include "JobSystem.h"
+#include "MemoryPools.h"
+#include "MemoryTracker.h"
 #include "Mesh.h"
+#include "OcclusionCuller.h"
+#include "PerformanceOverlay.h"
+#include "PipelineCache.h"
+#include "Profiler.h"
+#include "RenderGraph.h"
+#include "RenderStats.h"
+#include "SceneStreamer.h"
+#include "Task.h"
+#include "TaskScheduler.h"
+#include "Texture.h"
+#include "TransformHierarchy.h"
+#include "UniformAllocator.h"
+#include "vk_init.h"
 #include "vk_types.h"
 #include <deque>
+#include <future>
 #include <glm/glm.hpp>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 struct GPUObjectData {
   glm::mat4 modelMatrix;
+  glm::uvec4 materialData; // x is the material index in bindless mode, yzw unused
+  glm::vec4 boundingSphere; // xyz for the center in world space, w for the radius
 };
 
 struct ObjectColor {
@@ -24,6 +49,19 @@ struct GPUCameraData {
   glm::mat4 viewProj;
 };
 
+/** Parameters of the occlusion culling shader */
+struct GPUCullData {
+  glm::mat4 view;
+  /** World space planes, pointing inside the frustum */
+  glm::vec4 frustumPlanes[6];
+  /** Terms of the projection matrix: x for [0][0], y for [1][1], z for [2][2], w for [3][2] */
+  glm::vec4 projection;
+  /** xy for the size of the depth pyramid, z for its number of levels, w for the near plane distance */
+  glm::vec4 pyramid;
+  /** x for the number of objects, y for the index of the first draw of the late pass, zw unused */
+  glm::uvec4 counts;
+};
+
 struct GPUSceneData {
   glm::vec4 fogColor; // w is for exponent
 	glm::vec4 fogDistances; //x for min, y for max, zw unused.
@@ -32,9 +70,38 @@ struct GPUSceneData {
 	glm::vec4 sunlightColor;
 };
 
+/**
+ * Material flags, stored in GPUMaterialData::textures.y in bindless mode.
+ * The default_lit template receives them as the specialization constant MATERIAL_CONSTANT_FLAGS instead.
+ */
+constexpr uint32_t MATERIAL_FLAG_UNLIT = 1;
+/** Specialization constants of the default_lit template */
+constexpr uint32_t MATERIAL_CONSTANT_FLAGS = 0;
+/** First of the 4 constants of the albedo, in RGBA order */
+constexpr uint32_t MATERIAL_CONSTANT_ALBEDO = 1;
+struct GPUMaterialData {
+  glm::vec4 albedo;
+  glm::uvec4 textures{NO_TEXTURE, 0, 0, 0}; // x for albedo texture, y for flags, zw unused
+};
+
+/** Location of a texture on disk */
+struct TextureSource {
+  std::string name;
+  std::string imagePath;
+  std::string cookedPath;
+};
+
 struct UploadContext {
   vk::Fence uploadFence;
   vk::CommandPool commandPool;
+  /** Command buffers of the uploads running in the background. The other pool is reset after each upload. */
+  vk::CommandPool asyncCommandPool;
+};
+
+/** Staging buffer holding the data of an upload, and the copies from it to record */
+struct PendingUpload {
+  AllocatedBuffer stagingBuffer;
+  std::function<void(vk::CommandBuffer)> recordCopies;
 };
 
 struct FrameData {
@@ -45,33 +112,135 @@ struct FrameData {
   AllocatedBuffer objectBuffer;
   AllocatedBuffer objectColorBuffer;
   vk::DescriptorSet objectDescriptor;
+  /** Indices of the meshlets that passed the culling, written by the culling shader */
+  AllocatedBuffer meshletIndexBuffer;
+  /** Indirect draw commands of the objects whose meshlets are culled */
+  AllocatedBuffer meshletDrawBuffer;
+  vk::DescriptorSet meshletCullDescriptor;
+  /** Indirect draw command of each object, for the early pass then for the late pass */
+  AllocatedBuffer occlusionDrawBuffer;
+  /** Holds a GPUCullData */
+  AllocatedBuffer cullDataBuffer;
+  vk::DescriptorSet occlusionCullDescriptor;
+  /** Dynamic offsets of the camera and scene blocks of the main view, in the uniform allocator */
+  uint32_t cameraOffset = 0;
+  uint32_t sceneOffset = 0;
+  /** Geometry of the overlay, persistently mapped */
+  AllocatedBuffer overlayVertexBuffer;
+  AllocatedBuffer overlayIndexBuffer;
+  void *overlayVertices = nullptr;
+  void *overlayIndices = nullptr;
 };
 
-struct MeshPushConstants {
-  glm::vec4 data;
-  glm::mat4 render_matrix;
+/** Objects drawn by a call to DrawObjects */
+enum class DrawPass {
+  /** Every object, when the occlusion culling is disabled */
+  eAll,
+  /** Objects visible in the last frame, and the ones whose meshlets are culled */
+  eEarly,
+  /** Objects hidden in the last frame that became visible */
+  eLate,
 };
 
-class DeletionQueue {
-  std::deque<std::function<void()>> _deletors;
+/** Push constants of the meshlet culling shader */
+struct MeshletCullConstants {
+  /** World space planes, pointing inside the frustum */
+  glm::vec4 frustumPlanes[6];
+  /** xyz for the position of the camera in world space, w unused */
+  glm::vec4 cameraPosition;
+  uint32_t objectIndex;
+  /** Index of the indirect draw command of the object */
+  uint32_t drawIndex;
+  /** First index of the object in the output index buffer */
+  uint32_t outputOffset;
+  uint32_t padding;
+};
 
-public:
-  void PushFunction(std::function<void()> &&ppFunction);
-  void Flush();
+struct MeshPushConstants {
+  glm::vec4 data;
+  glm::mat4 render_matrix;
 };
 
 struct Material {
-  vk::Pipeline pipeline;
+  /** Pipeline compiled from the state the first time the material is drawn. Shared by equal states. */
+  vk::Pipeline pipeline = nullptr;
+  PipelineState pipelineState;
   vk::PipelineLayout pipelineLayout;
+  /** Set bound at index 2, if the material uses one */
+  vk::DescriptorSet materialSet = nullptr;
+  /** Index of the material parameters in the material buffer (bindless mode) */
+  uint32_t materialIndex = 0;
 };
+constexpr uint32_t NO_MESHLET_DRAW = ~0u;
 struct RenderObject {
   Mesh *mesh;
+  /** Mesh still loading, replacing mesh once it is ready. Until then, mesh is the placeholder. */
+  Mesh *pendingMesh = nullptr;
   Material *material;
-  glm::mat4 transformMatrix;
+  /** Node of the object in the transform hierarchy, or NO_TRANSFORM for the static objects of the scene */
+  TransformId transform = NO_TRANSFORM;
+  /** World matrix of the node, copied from the hierarchy when it is updated */
+  glm::mat4 transformMatrix{1.0f};
   glm::vec4 albedo;
+  /** Level of detail of the mesh used in the last frame */
+  uint32_t lod = 0;
+  /** Index of the indirect draw of the object if its meshlets are culled this frame, or NO_MESHLET_DRAW */
+  uint32_t meshletDraw = NO_MESHLET_DRAW;
+  /** Large object rasterized by the CPU occlusion culling to hide the ones behind it */
+  bool occluder = false;
+  /** Skipped this frame: outside of the frustum, or hidden behind the occluders by the CPU occlusion culling
+   */
+  bool occluded = false;
 };
 
 constexpr uint32_t FRAME_OVERLAP = 2;
+/** Size of the uniform blocks each frame can write: enough for the camera and scene data of many views */
+constexpr size_t UNIFORM_FRAME_SIZE = 64 * 1024;
+/** Capacity of the object buffers */
+constexpr uint32_t MAX_OBJECTS = 10000;
+/** Vertical field of view of the camera, in degrees */
+constexpr float CAMERA_FOV = 70.f;
+/** Cull the meshlets of the objects drawn at full resolution in a compute pass */
+constexpr bool ENABLE_MESHLET_CULLING = true;
+/** Cull the objects hidden behind the depth of the previous frame, if the GPU supports it */
+constexpr bool ENABLE_OCCLUSION_CULLING = true;
+/** Cull the objects hidden behind the occluders on the CPU, when the GPU occlusion culling isn't available */
+constexpr bool ENABLE_CPU_OCCLUSION_CULLING = true;
+/** Size of the depth buffer of the CPU occlusion culling */
+constexpr uint32_t CPU_OCCLUSION_WIDTH = 320;
+constexpr uint32_t CPU_OCCLUSION_HEIGHT = 192;
+/** Maximum number of objects whose meshlets are culled each frame */
+constexpr uint32_t MAX_MESHLET_DRAWS = 64;
+/** Capacity of the per frame buffer receiving the indices of the visible meshlets */
+constexpr uint32_t MAX_MESHLET_OUTPUT_INDICES = 1 << 20;
+/** Use descriptor indexing to draw all materials sharing a pipeline without rebinding, if supported */
+constexpr bool ENABLE_BINDLESS = true;
+constexpr uint32_t MAX_BINDLESS_TEXTURES = 4096;
+constexpr uint32_t MAX_MATERIALS = 256;
+/** Capacity of the per frame geometry buffers of the overlay. Draw lists that don't fit are skipped. */
+constexpr uint32_t OVERLAY_MAX_VERTICES = 64 * 1024;
+constexpr uint32_t OVERLAY_MAX_INDICES = 128 * 1024;
+/** Simulation ticks per second, unless changed with SetTickRate */
+constexpr double SIMULATION_TICK_RATE = 60.0;
+/** Ticks simulated in one frame at most. After a long frame, the simulation slows down instead. */
+constexpr uint32_t MAX_TICKS_PER_FRAME = 8;
+/** File written when the M key is pressed */
+constexpr const char *MEMORY_REPORT_PATH = "memory_report.json";
+/** Chrome trace written when a profiler capture is stopped with the P key. Open it in chrome://tracing. */
+constexpr const char *PROFILER_TRACE_PATH = "profiler_trace.json";
+/** Scene streamed around the camera. The cooked file is made from the source by asset_cook. */
+constexpr const char *SCENE_SOURCE_PATH = "../assets/demo_scene.txt";
+constexpr const char *SCENE_COOKED_PATH = "../assets/demo_scene.scene";
+/** Chunks of the scene closer than this to the camera are resident, as long as they fit in MAX_OBJECTS */
+constexpr float SCENE_STREAMING_RADIUS = 48.0f;
+/** Chunks streamed in per frame at most */
+constexpr uint32_t SCENE_MAX_CHUNK_LOADS = 8;
+/** The BVH of the objects is rebuilt in the background once refits made it this much slower to traverse */
+constexpr float BVH_REBUILD_DEGRADATION = 1.5f;
+/** Frames between two checks of the quality of the BVH */
+constexpr uint64_t BVH_QUALITY_CHECK_FRAMES = 60;
+/** Distance at which the objects can be picked with the mouse */
+constexpr float PICKING_DISTANCE = 200.0f;
 
 class VulkanEngine {
 private:
@@ -84,10 +253,23 @@ private:
   /** Index of the current frame */
   int _frameNumber{1};
   double_t _deltaTime = 0;
-  /** Deletion queue handling object deletion */
+
+  // == SIMULATION ==
+
+  /** The simulation runs at a fixed rate, independent from the frame rate */
+  double_t _tickDuration = 1.0 / SIMULATION_TICK_RATE;
+  /** Time not simulated yet, less than a tick after the ticks of the frame */
+  double_t _tickAccumulator = 0;
+  /** Deletion queue handling object deletion, at shutdown or once the frames using them are done */
   DeletionQueue _mainDeletionQueue;
   /** Memory allocator */
   VmaAllocator _allocator = nullptr;
+  /** Usage of the allocations of _allocator, per category and per heap */
+  MemoryTracker _memoryTracker;
+  /** Custom pools of _allocator, one per class of resources */
+  MemoryPools _memoryPools;
+  /** Compacts the defragmentable pools when they get fragmented */
+  Defragmenter _defragmenter;
 
   // == WINDOWING ==
 
@@ -114,39 +296,166 @@ private:
   /** Image format expected by the windowing system */
   vk::Format _swapchainImageFormat;
   vk::Format _depthImageFormat;
+  /** Can indirect draws have a first instance other than 0 ? The GPU culling passes need it */
+  bool _drawIndirectFirstInstance = false;
+  /** Can a single indirect call contain several draws ? */
+  bool _multiDrawIndirect = false;
   /** Array of images from the swapchain */
   std::vector<vk::Image> _swapchainImages;
   /** Array of image views from the swapchain */
   std::vector<vk::ImageView> _swapchainImageViews;
-  AllocatedImage _depthImage;
-  vk::ImageView _depthImageView = nullptr;
   /** Queue used for rendering */
   vk::Queue _graphicsQueue = nullptr;
   /** Family of the graphics queue */
   uint32_t _graphicsQueueFamily;
-  /** Render pass */
+  /** Passes of a frame, with the barriers between them */
+  RenderGraph _renderGraph;
+  RenderGraph::Resource _swapchainResource = 0;
+  /** Depth image, owned by the render graph */
+  RenderGraph::Resource _depthResource = 0;
+  /** Render pass of the first graphics pass of the graph, which the pipelines are created for */
   vk::RenderPass _renderPass;
-  /** Framebuffers */
-  std::vector<vk::Framebuffer> _framebuffers;
   FrameData _frames[FRAME_OVERLAP];
   /* Descriptor sets */
   vk::DescriptorSetLayout _globalSetLayout;
   vk::DescriptorSet _globalDescriptor;
   vk::DescriptorSetLayout _objectSetLayout;
   vk::DescriptorPool _descriptorPool = nullptr;
+  /** Shared descriptor set layouts and pipeline layouts */
+  vkinit::LayoutCache _layoutCache;
+  /** Pipelines of the materials, compiled on first use */
+  PipelineCache _pipelineCache;
+  /* Bindless resources */
+  /** Is the bindless mode enabled and supported by the GPU ? */
+  bool _bindless = false;
+  uint32_t _maxBindlessTextures = MAX_BINDLESS_TEXTURES;
+  uint32_t _bindlessTextureCount = 0;
+  vk::DescriptorSetLayout _bindlessSetLayout;
+  vk::DescriptorSet _bindlessDescriptor;
+  vk::DescriptorPool _bindlessPool = nullptr;
+  AllocatedBuffer _materialBuffer;
+  std::vector<GPUMaterialData> _materialParameters;
   /* Immediate submit */
   UploadContext _uploadContext;
 
+  // == Textures ==
+  /** Worker threads used for asset loading and the CPU occlusion culling */
+  JobSystem _jobSystem;
+  std::unordered_map<std::string, Texture> _textures;
+  /** Textures being decoded on the worker threads */
+  std::vector<std::pair<std::string, std::future<ImageData>>> _pendingTextures;
+  /** Textures already cooked by asset_cook, with the path of their source image as a fallback */
+  std::vector<TextureSource> _cookedTextures;
+  /** Can block compressed textures be used ? */
+  bool _textureCompressionBC = false;
+  vk::Sampler _defaultSampler = nullptr;
+  vkinit::DescriptorSetLayout _textureSetLayout;
+  /** State of the textured material, which is created once the placeholder texture exists */
+  PipelineState _texturedPipelineState;
+
+  // == Asset loading ==
+  /** Resumes the loading coroutines once per frame, when their job or upload is done */
+  TaskScheduler _taskScheduler;
+  /** Loads started by the engine itself. They are removed when they are done. */
+  std::vector<Task<>> _loadingTasks;
+  /** Meshes whose data isn't uploaded yet. The objects using them draw the placeholder instead. */
+  std::unordered_set<const Mesh *> _loadingMeshes;
+  Mesh *_placeholderMesh = nullptr;
+  /** Texture of the materials whose texture isn't uploaded yet */
+  Texture *_placeholderTexture = nullptr;
+  /** Uploads submitted by SubmitAsync that the GPU hasn't finished */
+  uint32_t _asyncUploadCount = 0;
+
+  // == Meshlet culling ==
+  vkinit::DescriptorSetLayout _meshletFrameSetLayout;
+  vkinit::DescriptorSetLayout _meshletMeshSetLayout;
+  vk::PipelineLayout _meshletCullPipelineLayout = nullptr;
+  vk::Pipeline _meshletCullPipeline = nullptr;
+  /** Set with the meshlets and indices of each mesh that has meshlets */
+  std::unordered_map<const Mesh *, vk::DescriptorSet> _meshletDescriptors;
+
+  // == Occlusion culling ==
+  /** Is the occlusion culling enabled and supported ? */
+  bool _occlusionCulling = false;
+  /** Maximum depth of the early pass, halved at each level */
+  AllocatedImage _depthPyramid;
+  vk::ImageView _depthPyramidView = nullptr;
+  RenderGraph::Resource _depthPyramidResource = 0;
+  /** View of each level, to write them */
+  std::vector<vk::ImageView> _depthPyramidMips;
+  /** Set used to build each level from the previous one, or from the depth image for the first one */
+  std::vector<vk::DescriptorSet> _depthReduceDescriptors;
+  vk::Extent2D _depthPyramidExtent;
+  uint32_t _depthPyramidLevels = 0;
+  vk::Sampler _depthPyramidSampler = nullptr;
+  vkinit::DescriptorSetLayout _depthReduceSetLayout;
+  vkinit::DescriptorSetLayout _occlusionCullSetLayout;
+  vk::PipelineLayout _depthReducePipelineLayout = nullptr;
+  vk::PipelineLayout _occlusionCullPipelineLayout = nullptr;
+  vk::Pipeline _depthReducePipeline = nullptr;
+  vk::Pipeline _occlusionCullPipeline = nullptr;
+  /** Visibility of each object at the end of the last frame, only accessed by the GPU */
+  AllocatedBuffer _visibilityBuffer;
+  /** Fallback on the CPU, when the GPU can't do it */
+  OcclusionCuller _cpuOcclusionCuller{CPU_OCCLUSION_WIDTH, CPU_OCCLUSION_HEIGHT, &_jobSystem};
+  std::vector<OcclusionBox> _occlusionBoxes;
+  std::vector<uint8_t> _occlusionResults;
+
+  // == Statistics ==
+  /** Counters of the frame being recorded, and of the last complete ones */
+  RenderStats _renderStats;
+  RenderStatsHistory _renderStatsHistory;
+  /** Two timestamps per frame in flight, around its commands. Null if the queue doesn't support them. */
+  vk::QueryPool _timestampPool = nullptr;
+
+  // == Overlay ==
+  bool _showOverlay = false;
+  PerformanceOverlay _performanceOverlay;
+  vk::Pipeline _overlayPipeline = nullptr;
+  vk::PipelineLayout _overlayPipelineLayout = nullptr;
+  /** Font atlas of ImGui */
+  vk::DescriptorSet _overlayFontDescriptor = nullptr;
+
   // == Scene ==
   std::vector<RenderObject> _renderables;
+  TransformHierarchy _transforms;
+  /** Objects built in code come first in _renderables. The ones streamed from the scene start here. */
+  uint32_t _streamedObjectsStart = 0;
+  SceneStreamer _sceneStreamer;
+  /** Meshes and materials of the scene, by index in its tables. Null if unknown. */
+  std::vector<Mesh *> _sceneMeshes;
+  std::vector<Material *> _sceneMaterials;
+  /** Resident chunks, and the range of their objects in _renderables */
+  struct StreamedChunk {
+    uint32_t chunk;
+    uint32_t firstObject;
+    uint32_t objectCount;
+  };
+  std::vector<StreamedChunk> _streamedChunks;
+  std::vector<uint32_t> _chunksToLoad;
+  std::vector<uint32_t> _chunksToUnload;
+  /** Boxes of the renderables, by index. Used by the culling and the picking. */
+  Bvh _bvh;
+  /** The renderables were added or removed: the BVH must be rebuilt before its next use */
+  bool _bvhOutdated = true;
+  /** Rebuild running on the job system, and the objects that moved since it was started */
+  std::future<Bvh> _bvhRebuild;
+  std::vector<uint32_t> _movedDuringRebuild;
+  /** Objects whose matrix changed since the last refit */
+  std::vector<uint32_t> _movedObjects;
+  std::vector<uint32_t> _visibleObjects;
   std::unordered_map<std::string, Material> _materials;
   std::unordered_map<std::string, Mesh> _meshes;
   GPUSceneData _sceneData;
-  AllocatedBuffer _sceneDataBuffer;
-  AllocatedBuffer _cameraBuffer;
+  /** Camera and scene blocks of the frames, bound to _globalDescriptor with dynamic offsets */
+  UniformAllocator _uniformAllocator;
 
   // == Camera ==
   glm::vec3 _cameraMotion{0.0f};
+  /** Position at the start and at the end of the current tick */
+  glm::vec3 _previousCameraPosition;
+  glm::vec3 _simulatedCameraPosition;
+  /** Position interpolated between the two, used for rendering */
   glm::vec3 _cameraPosition;
 
   // Shader switching
@@ -156,31 +465,87 @@ private:
   void InitVulkan();
   void InitSwapchain();
   void InitCommands();
-  void InitDefaultRenderPass();
+  void InitRenderGraph();
   void InitDescriptors();
-  void InitFramebuffers();
+  void InitBindlessDescriptors();
+  static bool CheckExtensionSupport(vk::PhysicalDevice physicalDevice, const char *extensionName);
+  static bool CheckBindlessSupport(vk::PhysicalDevice physicalDevice);
   void InitSyncStructures();
   void InitPipelines();
+  void InitMeshletCulling();
+  void InitOcclusionCulling();
+  void InitOverlay();
+  vk::Pipeline CreateComputePipeline(const char *shaderPath, vk::PipelineLayout layout);
   void LoadMeshes();
+  void StartTextureLoads();
+  void LoadTextures();
+  std::future<ImageData> DecodeTextureAsync(const std::string &imagePath);
+  Task<Texture *> UploadDecodedTextureAsync(std::string name, std::future<ImageData> pendingImage);
+  /** Uploads the textures found by StartTextureLoads, then gives them to their materials */
+  Task<> LoadTexturesAsync(std::vector<TextureSource> cookedTextures,
+                           std::vector<std::pair<std::string, std::future<ImageData>>> pendingTextures);
+  /** Makes the material sample the texture. Can be called while frames using the material are in flight. */
+  void SetMaterialTexture(Material *material, Texture *texture);
+  /** Resumes the loads that can continue, and forgets the finished ones */
+  void UpdateLoading();
+  /** Makes the object draw the placeholder if its mesh is still loading */
+  void UsePlaceholderWhileLoading(RenderObject &object);
   void InitScene();
-  void DrawObjects(vk::CommandBuffer cmd, RenderObject *first, int32_t count);
+  void LoadScene();
+  /** Streams the chunks of the scene in and out around the camera */
+  void StreamScene();
+  /** Advances the simulation by one tick */
+  void Tick();
+  /** Interpolates the world matrices of the renderables between the last two ticks */
+  void UpdateTransforms(float alpha);
+  /** Refits the BVH to the objects that moved, and rebuilds it when needed */
+  void UpdateBvh();
+  [[nodiscard]] GPUCameraData GetCameraData() const;
+  void UpdateObjects(RenderObject *first, int32_t count);
+  /** Hides the objects outside of the frustum, found with the BVH. Every renderable is updated. */
+  void CullObjectsOutsideFrustum();
+  void CullObjectsOnCpu(RenderObject *first, int32_t count);
+  void CullMeshlets(vk::CommandBuffer cmd, RenderObject *first, int32_t count);
+  void CullObjects(vk::CommandBuffer cmd, RenderObject *first, int32_t count, DrawPass pass);
+  void BuildDepthPyramid(vk::CommandBuffer cmd);
+  void DrawObjects(vk::CommandBuffer cmd, RenderObject *first, int32_t count, DrawPass pass);
+  /** Builds the ImGui frame of the overlay, if it is shown */
+  void BuildOverlay();
+  void DrawOverlay(vk::CommandBuffer cmd);
+  /** Creates the buffers of the mesh, and a staging buffer with their content */
+  PendingUpload PrepareMeshUpload(Mesh &mesh);
+  /** Makes the buffers of the mesh usable, once the copies are done */
+  void FinishMeshUpload(Mesh &mesh, const AllocatedBuffer &stagingBuffer);
   void UploadMesh(Mesh &mesh);
+  Task<> UploadMeshAsync(Mesh &mesh);
+  PendingUpload PrepareTextureUpload(const TextureUploadInfo &uploadInfo, Texture &texture);
+  Texture *FinishTextureUpload(const std::string &name, Texture &texture,
+                               const AllocatedBuffer &stagingBuffer);
+  Texture *UploadTexture(const std::string &name, const TextureUploadInfo &uploadInfo);
+  Task<Texture *> UploadTextureAsync(std::string name, TextureUploadInfo uploadInfo);
+  void DefragmentMemory();
   vk::ShaderModule LoadShaderModule(const char *filePath);
   FrameData &GetCurrentFrame();
   static void HandleSDLError();
   AllocatedBuffer CreateBuffer(size_t allocationSize,
                                vk::BufferUsageFlags usageFlags,
-                               VmaMemoryUsage memoryUsage);
-
-  Material *CreateMaterial(vk::Pipeline pipeline, vk::PipelineLayout layout,
-                           const std::string &name);
+                               VmaMemoryUsage memoryUsage,
+                               MemoryCategory category,
+                               VmaAllocationCreateFlags allocationFlags = 0);
+
+  /** Declares a material. Its pipeline is only compiled when it is first drawn. */
+  Material *CreateMaterial(const PipelineState &pipelineState, const std::string &name,
+                           const GPUMaterialData &parameters = {.albedo = glm::vec4(1.0f)});
+  uint32_t RegisterBindlessTexture(vk::ImageView imageView, vk::Sampler sampler);
   Material *GetMaterial(const std::string &name);
   Mesh *GetMesh(const std::string &name);
+  Texture *GetTexture(const std::string &name);
 
   template <class T>
-  void CopyBufferToAllocation(const T *src, const VmaAllocation &allocation, bool applyPadding, size_t size = sizeof(T));
-  [[nodiscard]] size_t PadUniformBufferSize(size_t originalSize) const;
+  void CopyBufferToAllocation(const T *src, const VmaAllocation &allocation, size_t size = sizeof(T));
   void ImmediateSubmit(std::function<void(vk::CommandBuffer)>&& function);
+  /** Submits the commands without waiting for them. The task is done when the GPU has executed them. */
+  Task<> SubmitAsync(std::function<void(vk::CommandBuffer)> function);
 public:
   /**
    * Initializes everything in the engine
@@ -201,6 +566,47 @@ public:
    * Run main loop
    */
   void Run();
+
+  /**
+   * Changes the number of simulation ticks per second
+   */
+  void SetTickRate(double ticksPerSecond);
+
+  /**
+   * Current memory usage, per category and per heap
+   */
+  [[nodiscard]] MemoryReport GetMemoryReport() const;
+
+  /**
+   * Counters of the last complete frame
+   */
+  [[nodiscard]] const RenderStats &GetRenderStats() const;
+
+  /**
+   * Counters of the last RENDER_STATS_HISTORY_SIZE frames, to check budgets over a run
+   */
+  [[nodiscard]] const RenderStatsHistory &GetRenderStatsHistory() const;
+
+  /**
+   * Index in the renderables of the first object under a pixel of the window, or NO_OBJECT.
+   * The bounds of the objects are tested, not their triangles.
+   */
+  [[nodiscard]] uint32_t PickObject(int32_t x, int32_t y) const;
+
+  /**
+   * Loads an OBJ mesh without blocking the frames: the file is parsed and the levels of detail are generated
+   * on a worker, then the mesh is uploaded in the background. GetMesh returns it right away, but the objects
+   * using it draw a placeholder until it is ready.
+   * @return the mesh once it is ready, or null if the file can't be loaded
+   */
+  Task<Mesh *> LoadMeshAsync(std::string name, std::string path);
+
+  /**
+   * Loads a texture without blocking the frames: the cooked file is used if it exists, otherwise the image
+   * is decoded on a worker. The upload runs in the background.
+   * @return the texture once it is ready, or null if it can't be loaded
+   */
+  Task<Texture *> LoadTextureAsync(TextureSource source);
 };
 
 class PipelineBuilder {
@@ -215,6 +621,12 @@ private:
   vk::PipelineMultisampleStateCreateInfo _multisampling;
   vk::PipelineLayout _pipelineLayout;
   vk::PipelineDepthStencilStateCreateInfo _depthStencilCreateInfo;
+  std::vector<vk::DynamicState> _dynamicStates;
+  /** Specialization constants of every stage. The info pointing to them is only filled in Build. */
+  std::vector<vk::SpecializationMapEntry> _specializationEntries;
+  std::vector<uint32_t> _specializationData;
+  vk::SpecializationInfo _specializationInfo;
+  bool _alphaBlending = false;
   // Booleans to store whether default should be applied or not
   bool _rasterizerInited = false;
   bool _inputAssemblyInited = false;
@@ -244,6 +656,12 @@ public:
                                float minDepth, float maxDepth);
   PipelineBuilder WithViewport(vk::Viewport viewport);
   PipelineBuilder GetDefaultsForExtent(vk::Extent2D windowExtent);
+  /** Blends the output with the attachment using its alpha, for transparent geometry like UI */
+  PipelineBuilder WithAlphaBlending();
+  /** The state is set with commands when drawing. The value given to the builder is ignored. */
+  PipelineBuilder WithDynamicState(vk::DynamicState state);
+  /** Sets a specialization constant of every stage. Stages that don't declare it ignore it. */
+  PipelineBuilder WithSpecializationConstant(uint32_t constantId, uint32_t value);
   vk::Pipeline Build(vk::Device device, vk::RenderPass pass);
 };
 
@@ -4,7 +4,12 @@
 
 #include "vk_init.h"
 #include "vk_engine.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <stdexcept>
 
 std::array<float, 4> vkinit::GetColor(float r, float g, float b, float a) {
   return std::array<float, 4>{r, g, b, a};
@@ -21,7 +26,7 @@ vk::PipelineLayoutCreateInfo vkinit::PipelineLayoutCreateInfo() {
   return info;
 }
 vk::ImageViewCreateInfo vkinit::ImageViewCreateInfo(vk::Format format, vk::Image image,
-                                                    vk::ImageAspectFlags aspectFlags) {
+                                                    vk::ImageAspectFlags aspectFlags, uint32_t mipLevels) {
   return vk::ImageViewCreateInfo{
       .image = image,
       .viewType = vk::ImageViewType::e2D,
@@ -29,7 +34,7 @@ vk::ImageViewCreateInfo vkinit::ImageViewCreateInfo(vk::Format format, vk::Image
       .subresourceRange{
           .aspectMask = aspectFlags,
           .baseMipLevel = 0,
-          .levelCount = 1,
+          .levelCount = mipLevels,
           .baseArrayLayer = 0,
           .layerCount = 1,
       },
@@ -37,12 +42,12 @@ vk::ImageViewCreateInfo vkinit::ImageViewCreateInfo(vk::Format format, vk::Image
 }
 
 vk::ImageCreateInfo vkinit::ImageCreateInfo(vk::Format format, vk::ImageUsageFlags flags,
-                                            vk::Extent3D extent) {
+                                            vk::Extent3D extent, uint32_t mipLevels) {
   return vk::ImageCreateInfo{
       .imageType = vk::ImageType::e2D,
       .format = format,
       .extent = extent,
-      .mipLevels = 1,
+      .mipLevels = mipLevels,
       .arrayLayers = 1,
       .samples = vk::SampleCountFlagBits::e1,
       .tiling = vk::ImageTiling::eOptimal,
@@ -50,6 +55,53 @@ vk::ImageCreateInfo vkinit::ImageCreateInfo(vk::Format format, vk::ImageUsageFla
   };
 }
 
+vk::SamplerCreateInfo vkinit::SamplerCreateInfo(vk::Filter filter, vk::SamplerAddressMode addressMode) {
+  return vk::SamplerCreateInfo{
+      .magFilter = filter,
+      .minFilter = filter,
+      .mipmapMode = vk::SamplerMipmapMode::eLinear,
+      .addressModeU = addressMode,
+      .addressModeV = addressMode,
+      .addressModeW = addressMode,
+      .mipLodBias = 0.0f,
+      .anisotropyEnable = false,
+      .maxAnisotropy = 1.0f,
+      .compareEnable = false,
+      .compareOp = vk::CompareOp::eAlways,
+      .minLod = 0.0f,
+      // Use every mip level of the image
+      .maxLod = VK_LOD_CLAMP_NONE,
+  };
+}
+
+vk::ShaderModule vkinit::LoadShaderModule(vk::Device device, const char *filePath) {
+  // Load the binary file with the cursor at the end
+  std::ifstream file(filePath, std::ios::ate | std::ios::binary);
+
+  if (!file.is_open()) {
+    // Display error
+    std::cerr << strerror(errno) << '\n';
+    throw std::runtime_error("Couldn't load shader " + std::string(filePath));
+  }
+  // Since the cursor is at the end, tellg gives the size of the file
+  size_t fileSize = file.tellg();
+  // Create a vector long enough to hold the content
+  std::vector<uint32_t> buffer(fileSize / sizeof(uint32_t));
+  // Cursor at the beginning
+  file.seekg(0);
+  // Load the file into the buffer
+  file.read((char *)buffer.data(), fileSize);
+  // Close the file
+  file.close();
+
+  // Create a shader module
+  vk::ShaderModuleCreateInfo shaderCreateInfo{
+      .codeSize = buffer.size() * sizeof(uint32_t),
+      .pCode = buffer.data(),
+  };
+  return device.createShaderModule(shaderCreateInfo);
+}
+
 // ==== Set allocator ===
 
 vkinit::DescriptorSetAllocator::DescriptorSetAllocator(vk::DescriptorPool pool) { _pool = pool; }
@@ -80,20 +132,144 @@ vkinit::DescriptorSetAllocator::AddSetWithLayout(const vkinit::DescriptorSetLayo
   return *this;
 }
 
-// == Set layout builder ==
+// == Layout cache ==
+
+bool vkinit::LayoutCache::DescriptorSetLayoutKey::operator==(const DescriptorSetLayoutKey &other) const {
+  return flags == other.flags && bindings == other.bindings && bindingFlags == other.bindingFlags;
+}
+
+size_t vkinit::LayoutCache::DescriptorSetLayoutKey::Hash() const {
+  size_t seed = bindings.size();
+  HashCombine(seed, static_cast<VkDescriptorSetLayoutCreateFlags>(flags));
+  for (const auto &bindingFlag : bindingFlags) {
+    HashCombine(seed, static_cast<VkDescriptorBindingFlags>(bindingFlag));
+  }
+  for (const auto &binding : bindings) {
+    HashCombine(seed, binding.binding);
+    HashCombine(seed, static_cast<size_t>(binding.descriptorType));
+    HashCombine(seed, binding.descriptorCount);
+    HashCombine(seed, static_cast<VkShaderStageFlags>(binding.stageFlags));
+  }
+  return seed;
+}
 
-vkinit::DescriptorSetLayout vkinit::DescriptorSetLayoutBuilder::Build(const vk::Device &device,
-                                                                      DeletionQueue &deletionQueue) {
-  // Create layout
+bool vkinit::LayoutCache::PipelineLayoutKey::operator==(const PipelineLayoutKey &other) const {
+  return setLayouts == other.setLayouts && pushConstantRanges == other.pushConstantRanges;
+}
+
+size_t vkinit::LayoutCache::PipelineLayoutKey::Hash() const {
+  size_t seed = setLayouts.size();
+  for (const auto &setLayout : setLayouts) {
+    HashCombine(seed, HashHandle(setLayout));
+  }
+  for (const auto &range : pushConstantRanges) {
+    HashCombine(seed, static_cast<VkShaderStageFlags>(range.stageFlags));
+    HashCombine(seed, range.offset);
+    HashCombine(seed, range.size);
+  }
+  return seed;
+}
+
+void vkinit::LayoutCache::Init(vk::Device device) { _device = device; }
+
+vk::DescriptorSetLayout
+vkinit::LayoutCache::CreateDescriptorSetLayout(std::vector<vk::DescriptorSetLayoutBinding> bindings,
+                                               std::vector<vk::DescriptorBindingFlags> bindingFlags,
+                                               vk::DescriptorSetLayoutCreateFlags flags) {
+  // Sort the bindings so that the same set declared in another order gives the same key.
+  // Binding flags are sorted along with their binding.
+  if (!bindingFlags.empty()) {
+    std::vector<std::pair<vk::DescriptorSetLayoutBinding, vk::DescriptorBindingFlags>> pairs;
+    pairs.reserve(bindings.size());
+    for (size_t i = 0; i < bindings.size(); i++) {
+      pairs.emplace_back(bindings[i], bindingFlags[i]);
+    }
+    std::sort(pairs.begin(), pairs.end(),
+              [](const auto &a, const auto &b) { return a.first.binding < b.first.binding; });
+    for (size_t i = 0; i < pairs.size(); i++) {
+      bindings[i] = pairs[i].first;
+      bindingFlags[i] = pairs[i].second;
+    }
+  } else {
+    std::sort(bindings.begin(), bindings.end(),
+              [](const auto &a, const auto &b) { return a.binding < b.binding; });
+  }
+  DescriptorSetLayoutKey key{
+      .bindings = std::move(bindings),
+      .bindingFlags = std::move(bindingFlags),
+      .flags = flags,
+  };
+
+  // Return the existing layout if there is one
+  auto it = _setLayouts.find(key);
+  if (it != _setLayouts.end()) {
+    return it->second;
+  }
+
+  // Else, create it
+  vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo{
+      .bindingCount = static_cast<uint32_t>(key.bindingFlags.size()),
+      .pBindingFlags = key.bindingFlags.data(),
+  };
   vk::DescriptorSetLayoutCreateInfo setLayoutCreateInfo{
-      .bindingCount = static_cast<uint32_t>(_bindings.size()),
-      .pBindings = _bindings.data(),
+      .pNext = key.bindingFlags.empty() ? nullptr : &bindingFlagsCreateInfo,
+      .flags = key.flags,
+      .bindingCount = static_cast<uint32_t>(key.bindings.size()),
+      .pBindings = key.bindings.data(),
+  };
+  vk::DescriptorSetLayout layout = _device.createDescriptorSetLayout(setLayoutCreateInfo);
+  _setLayouts.emplace(std::move(key), layout);
+  return layout;
+}
+
+vk::PipelineLayout
+vkinit::LayoutCache::CreatePipelineLayout(const std::vector<vk::DescriptorSetLayout> &setLayouts,
+                                          const std::vector<vk::PushConstantRange> &pushConstantRanges) {
+  PipelineLayoutKey key{
+      .setLayouts = setLayouts,
+      .pushConstantRanges = pushConstantRanges,
   };
 
-  vk::DescriptorSetLayout layout = device.createDescriptorSetLayout(setLayoutCreateInfo);
+  // Return the existing layout if there is one
+  auto it = _pipelineLayouts.find(key);
+  if (it != _pipelineLayouts.end()) {
+    return it->second;
+  }
+
+  // Else, create it
+  auto pipelineLayoutCreateInfo = PipelineLayoutCreateInfo();
+  pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+  pipelineLayoutCreateInfo.pSetLayouts = setLayouts.data();
+  pipelineLayoutCreateInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+  pipelineLayoutCreateInfo.pPushConstantRanges = pushConstantRanges.data();
+  vk::PipelineLayout layout = _device.createPipelineLayout(pipelineLayoutCreateInfo);
+  _pipelineLayouts.emplace(std::move(key), layout);
+  return layout;
+}
+
+void vkinit::LayoutCache::Cleanup() {
+  // Pipeline layouts first since they reference the set layouts
+  for (auto &[key, layout] : _pipelineLayouts) {
+    _device.destroyPipelineLayout(layout);
+  }
+  for (auto &[key, layout] : _setLayouts) {
+    _device.destroyDescriptorSetLayout(layout);
+  }
+  _pipelineLayouts.clear();
+  _setLayouts.clear();
+}
+
+// == Set layout builder ==
 
-  // Register deletion
-  deletionQueue.PushFunction([device, layout]() { device.destroyDescriptorSetLayout(layout); });
+vkinit::DescriptorSetLayout vkinit::DescriptorSetLayoutBuilder::Build(LayoutCache &layoutCache) {
+  // Get the layout from the cache: it is only created if no identical layout exists yet
+  // Binding flags are only given when at least one binding needs them
+  bool hasBindingFlags = false;
+  for (const auto &bindingFlags : _bindingFlags) {
+    hasBindingFlags |= static_cast<bool>(bindingFlags);
+  }
+  vk::DescriptorSetLayout layout = layoutCache.CreateDescriptorSetLayout(
+      _bindings, hasBindingFlags ? _bindingFlags : std::vector<vk::DescriptorBindingFlags>{}, _flags);
 
   // Return it
   return vkinit::DescriptorSetLayout{
@@ -102,18 +278,26 @@ vkinit::DescriptorSetLayout vkinit::DescriptorSetLayoutBuilder::Build(const vk::
   };
 }
 vkinit::DescriptorSetLayoutBuilder
-vkinit::DescriptorSetLayoutBuilder::AddBinding(vk::ShaderStageFlags stages,
-                                               vk::DescriptorType descriptorType) {
+vkinit::DescriptorSetLayoutBuilder::AddBinding(vk::ShaderStageFlags stages, vk::DescriptorType descriptorType,
+                                               uint32_t descriptorCount,
+                                               vk::DescriptorBindingFlags bindingFlags) {
 
   // Set binding
   _bindings.push_back(vk::DescriptorSetLayoutBinding{
       .binding = static_cast<uint32_t>(_bindings.size()),
       .descriptorType = descriptorType,
-      .descriptorCount = 1,
+      .descriptorCount = descriptorCount,
       .stageFlags = stages,
       .pImmutableSamplers = nullptr,
   });
+  _bindingFlags.push_back(bindingFlags);
+
+  return *this;
+}
 
+vkinit::DescriptorSetLayoutBuilder
+vkinit::DescriptorSetLayoutBuilder::WithFlags(vk::DescriptorSetLayoutCreateFlags flags) {
+  _flags = flags;
   return *this;
 }
 
@@ -140,18 +324,59 @@ vkinit::DescriptorSetWriter vkinit::DescriptorSetWriter::AddBuffer(uint32_t setI
       .range = range,
   });
 
-  // Set write
+  // Set write. The info pointer is set in Write, since the vector may still grow
+  _writes.push_back(vk::WriteDescriptorSet{
+      .dstSet = *_sets[setIndex],
+      .dstBinding = bindingIndex,
+      .descriptorCount = 1,
+      .descriptorType = binding.descriptorType,
+  });
+
+  return *this;
+}
+
+vkinit::DescriptorSetWriter vkinit::DescriptorSetWriter::AddImage(uint32_t setIndex, uint32_t bindingIndex,
+                                                                  vk::Sampler sampler, vk::ImageView imageView,
+                                                                  vk::ImageLayout layout) {
+  // Get binding
+  auto binding = _bindings[setIndex][bindingIndex];
+
+  // Set image info
+  _imageInfos.push_back(vk::DescriptorImageInfo{
+      .sampler = sampler,
+      .imageView = imageView,
+      .imageLayout = layout,
+  });
+
+  // Set write. The info pointer is set in Write, since the vector may still grow
   _writes.push_back(vk::WriteDescriptorSet{
       .dstSet = *_sets[setIndex],
       .dstBinding = bindingIndex,
       .descriptorCount = 1,
       .descriptorType = binding.descriptorType,
-      .pBufferInfo = &_bufferInfos[_bufferInfos.size() - 1],
   });
 
   return *this;
 }
 
 void vkinit::DescriptorSetWriter::Write(const vk::Device &device) {
+  // Link the infos, in the order in which they were added
+  size_t bufferIndex = 0;
+  size_t imageIndex = 0;
+  for (auto &write : _writes) {
+    switch (write.descriptorType) {
+    case vk::DescriptorType::eSampler:
+    case vk::DescriptorType::eCombinedImageSampler:
+    case vk::DescriptorType::eSampledImage:
+    case vk::DescriptorType::eStorageImage:
+    case vk::DescriptorType::eInputAttachment:
+      write.pImageInfo = &_imageInfos[imageIndex++];
+      break;
+    default:
+      write.pBufferInfo = &_bufferInfos[bufferIndex++];
+      break;
+    }
+  }
+
   device.updateDescriptorSets(_writes, nullptr);
 }
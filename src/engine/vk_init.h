@@ -5,16 +5,76 @@
 #pragma once
 
 #include "vk_types.h"
-
-class DeletionQueue;
+#include <functional>
+#include <unordered_map>
+#include <vector>
 
 namespace vkinit {
 std::array<float, 4> GetColor(float r = 1.0f, float g = 1.0f, float b = 1.0f, float a = 1.0f);
 
 vk::PipelineLayoutCreateInfo PipelineLayoutCreateInfo();
-vk::ImageCreateInfo ImageCreateInfo(vk::Format format, vk::ImageUsageFlags flags, vk::Extent3D extent);
-vk::ImageViewCreateInfo ImageViewCreateInfo(vk::Format format, vk::Image image,
-                                            vk::ImageAspectFlags aspectFlags);
+vk::ImageCreateInfo ImageCreateInfo(vk::Format format, vk::ImageUsageFlags flags, vk::Extent3D extent,
+                                    uint32_t mipLevels = 1);
+vk::ImageViewCreateInfo ImageViewCreateInfo(vk::Format format, vk::Image image, vk::ImageAspectFlags aspectFlags,
+                                            uint32_t mipLevels = 1);
+vk::SamplerCreateInfo SamplerCreateInfo(vk::Filter filter,
+                                        vk::SamplerAddressMode addressMode = vk::SamplerAddressMode::eRepeat);
+/** Creates a shader module from a SPIR-V file */
+vk::ShaderModule LoadShaderModule(vk::Device device, const char *filePath);
+
+// Hashing of the cache keys
+/** Mixes the hash of a value into a seed */
+inline void HashCombine(size_t &seed, size_t value) {
+  seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+template <class Handle> size_t HashHandle(Handle handle) {
+  // Non dispatchable handles are 64 bits on every platform
+  return std::hash<uint64_t>{}((uint64_t) static_cast<typename Handle::CType>(handle));
+}
+
+// Layout cache
+/**
+ * Hash-consing cache for descriptor set layouts and pipeline layouts.
+ * Identical layouts are only created once, so two materials built from the same bindings share the same
+ * handles and are layout-compatible. The cache owns the handles and destroys them in Cleanup.
+ */
+class LayoutCache {
+private:
+  struct DescriptorSetLayoutKey {
+    std::vector<vk::DescriptorSetLayoutBinding> bindings;
+    std::vector<vk::DescriptorBindingFlags> bindingFlags;
+    vk::DescriptorSetLayoutCreateFlags flags;
+
+    bool operator==(const DescriptorSetLayoutKey &other) const;
+    [[nodiscard]] size_t Hash() const;
+  };
+
+  struct PipelineLayoutKey {
+    std::vector<vk::DescriptorSetLayout> setLayouts;
+    std::vector<vk::PushConstantRange> pushConstantRanges;
+
+    bool operator==(const PipelineLayoutKey &other) const;
+    [[nodiscard]] size_t Hash() const;
+  };
+
+  struct KeyHasher {
+    template <class K> size_t operator()(const K &key) const { return key.Hash(); }
+  };
+
+  vk::Device _device;
+  std::unordered_map<DescriptorSetLayoutKey, vk::DescriptorSetLayout, KeyHasher> _setLayouts;
+  std::unordered_map<PipelineLayoutKey, vk::PipelineLayout, KeyHasher> _pipelineLayouts;
+
+public:
+  void Init(vk::Device device);
+  vk::DescriptorSetLayout CreateDescriptorSetLayout(std::vector<vk::DescriptorSetLayoutBinding> bindings,
+                                                    std::vector<vk::DescriptorBindingFlags> bindingFlags = {},
+                                                    vk::DescriptorSetLayoutCreateFlags flags = {});
+  vk::PipelineLayout CreatePipelineLayout(const std::vector<vk::DescriptorSetLayout> &setLayouts,
+                                          const std::vector<vk::PushConstantRange> &pushConstantRanges);
+  void Cleanup();
+};
 
 // Layout builder
 struct DescriptorSetLayout {
@@ -26,10 +86,14 @@ class DescriptorSetLayoutBuilder {
 
 private:
   std::vector<vk::DescriptorSetLayoutBinding> _bindings;
+  std::vector<vk::DescriptorBindingFlags> _bindingFlags;
+  vk::DescriptorSetLayoutCreateFlags _flags;
 
 public:
-  DescriptorSetLayoutBuilder AddBinding(vk::ShaderStageFlags stages, vk::DescriptorType descriptorType);
-  DescriptorSetLayout Build(const vk::Device &device, DeletionQueue &deletionQueue);
+  DescriptorSetLayoutBuilder AddBinding(vk::ShaderStageFlags stages, vk::DescriptorType descriptorType,
+                                        uint32_t descriptorCount = 1, vk::DescriptorBindingFlags bindingFlags = {});
+  DescriptorSetLayoutBuilder WithFlags(vk::DescriptorSetLayoutCreateFlags flags);
+  DescriptorSetLayout Build(LayoutCache &layoutCache);
 };
 
 // Set writer
@@ -37,6 +101,7 @@ class DescriptorSetWriter {
 private:
   std::vector<vk::WriteDescriptorSet> _writes;
   std::vector<vk::DescriptorBufferInfo> _bufferInfos;
+  std::vector<vk::DescriptorImageInfo> _imageInfos;
   std::vector<std::vector<vk::DescriptorSetLayoutBinding>> _bindings;
   std::vector<vk::DescriptorSet *> _sets;
 
@@ -45,6 +110,9 @@ public:
                       const std::vector<std::vector<vk::DescriptorSetLayoutBinding>> &bindings);
   DescriptorSetWriter AddBuffer(uint32_t setIndex, uint32_t bindingIndex, vk::Buffer buffer, size_t range,
                                 size_t offset = 0);
+  DescriptorSetWriter AddImage(uint32_t setIndex, uint32_t bindingIndex, vk::Sampler sampler,
+                               vk::ImageView imageView,
+                               vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal);
   void Write(const vk::Device &device);
 };
 
@@ -0,0 +1,231 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "BlockCompression.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+constexpr uint32_t PIXELS_PER_BLOCK = 16;
+
+uint16_t PackRGB565(const float color[3]) {
+  auto r = static_cast<uint16_t>(std::clamp(std::lround(color[0] * 31.0f / 255.0f), 0L, 31L));
+  auto g = static_cast<uint16_t>(std::clamp(std::lround(color[1] * 63.0f / 255.0f), 0L, 63L));
+  auto b = static_cast<uint16_t>(std::clamp(std::lround(color[2] * 31.0f / 255.0f), 0L, 31L));
+  return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+void UnpackRGB565(uint16_t packed, int32_t color[3]) {
+  int32_t r = (packed >> 11) & 31;
+  int32_t g = (packed >> 5) & 63;
+  int32_t b = packed & 31;
+  // Replicate the high bits in the low ones, like the hardware does
+  color[0] = (r << 3) | (r >> 2);
+  color[1] = (g << 2) | (g >> 4);
+  color[2] = (b << 3) | (b >> 2);
+}
+
+/**
+ * Finds the endpoints of the color block along its principal axis
+ */
+void FindColorEndpoints(const uint8_t *block, float minColor[3], float maxColor[3]) {
+  // Mean
+  float mean[3] = {0, 0, 0};
+  for (uint32_t i = 0; i < PIXELS_PER_BLOCK; i++) {
+    for (uint32_t c = 0; c < 3; c++) {
+      mean[c] += block[i * 4 + c];
+    }
+  }
+  for (float &m : mean) {
+    m /= PIXELS_PER_BLOCK;
+  }
+
+  // Covariance matrix (symmetric: xx, xy, xz, yy, yz, zz)
+  float cov[6] = {0, 0, 0, 0, 0, 0};
+  for (uint32_t i = 0; i < PIXELS_PER_BLOCK; i++) {
+    float r = block[i * 4 + 0] - mean[0];
+    float g = block[i * 4 + 1] - mean[1];
+    float b = block[i * 4 + 2] - mean[2];
+    cov[0] += r * r;
+    cov[1] += r * g;
+    cov[2] += r * b;
+    cov[3] += g * g;
+    cov[4] += g * b;
+    cov[5] += b * b;
+  }
+
+  // Principal axis with a few power iterations
+  float axis[3] = {1.0f, 1.0f, 1.0f};
+  for (uint32_t iteration = 0; iteration < 8; iteration++) {
+    float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+    float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+    float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+    float length = std::max({std::abs(x), std::abs(y), std::abs(z)});
+    if (length < 1e-6f)
+      break;
+    axis[0] = x / length;
+    axis[1] = y / length;
+    axis[2] = z / length;
+  }
+
+  // Project the pixels on the axis to find the extremes
+  float minProjection = INFINITY;
+  float maxProjection = -INFINITY;
+  for (uint32_t i = 0; i < PIXELS_PER_BLOCK; i++) {
+    float projection = (block[i * 4 + 0] - mean[0]) * axis[0] + (block[i * 4 + 1] - mean[1]) * axis[1] +
+                       (block[i * 4 + 2] - mean[2]) * axis[2];
+    minProjection = std::min(minProjection, projection);
+    maxProjection = std::max(maxProjection, projection);
+  }
+
+  float axisLengthSquared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+  for (uint32_t c = 0; c < 3; c++) {
+    float direction = axisLengthSquared > 0 ? axis[c] / axisLengthSquared : 0;
+    minColor[c] = std::clamp(mean[c] + direction * minProjection, 0.0f, 255.0f);
+    maxColor[c] = std::clamp(mean[c] + direction * maxProjection, 0.0f, 255.0f);
+  }
+
+  // Inset the endpoints slightly to reduce the error of the interpolated colors
+  for (uint32_t c = 0; c < 3; c++) {
+    float inset = (maxColor[c] - minColor[c]) / 16.0f;
+    minColor[c] += inset;
+    maxColor[c] -= inset;
+  }
+}
+
+/**
+ * Encodes the color part of a block in 4-colors mode
+ */
+void EncodeColorBlock(const uint8_t *block, uint8_t *dst) {
+  float minColor[3], maxColor[3];
+  FindColorEndpoints(block, minColor, maxColor);
+
+  uint16_t color0 = PackRGB565(maxColor);
+  uint16_t color1 = PackRGB565(minColor);
+  // color0 > color1 selects the 4-colors mode
+  if (color0 < color1) {
+    std::swap(color0, color1);
+  }
+
+  uint32_t indices = 0;
+  if (color0 != color1) {
+    // Build the palette
+    int32_t palette[4][3];
+    UnpackRGB565(color0, palette[0]);
+    UnpackRGB565(color1, palette[1]);
+    for (uint32_t c = 0; c < 3; c++) {
+      palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    // Take the closest palette entry for every pixel
+    for (uint32_t i = 0; i < PIXELS_PER_BLOCK; i++) {
+      uint32_t bestIndex = 0;
+      int32_t bestDistance = INT32_MAX;
+      for (uint32_t p = 0; p < 4; p++) {
+        int32_t dr = block[i * 4 + 0] - palette[p][0];
+        int32_t dg = block[i * 4 + 1] - palette[p][1];
+        int32_t db = block[i * 4 + 2] - palette[p][2];
+        int32_t distance = dr * dr + dg * dg + db * db;
+        if (distance < bestDistance) {
+          bestDistance = distance;
+          bestIndex = p;
+        }
+      }
+      indices |= bestIndex << (2 * i);
+    }
+  }
+
+  // Little endian block layout
+  dst[0] = color0 & 0xFF;
+  dst[1] = color0 >> 8;
+  dst[2] = color1 & 0xFF;
+  dst[3] = color1 >> 8;
+  for (uint32_t i = 0; i < 4; i++) {
+    dst[4 + i] = (indices >> (8 * i)) & 0xFF;
+  }
+}
+
+/**
+ * Encodes the alpha part of a BC3 block in 8-alphas mode
+ */
+void EncodeAlphaBlock(const uint8_t *block, uint8_t *dst) {
+  uint8_t minAlpha = 255;
+  uint8_t maxAlpha = 0;
+  for (uint32_t i = 0; i < PIXELS_PER_BLOCK; i++) {
+    minAlpha = std::min(minAlpha, block[i * 4 + 3]);
+    maxAlpha = std::max(maxAlpha, block[i * 4 + 3]);
+  }
+
+  dst[0] = maxAlpha;
+  dst[1] = minAlpha;
+  uint64_t indices = 0;
+  if (maxAlpha != minAlpha) {
+    // alpha0 > alpha1 selects the 8-alphas mode
+    int32_t palette[8];
+    palette[0] = maxAlpha;
+    palette[1] = minAlpha;
+    for (int32_t p = 1; p < 7; p++) {
+      palette[p + 1] = ((7 - p) * maxAlpha + p * minAlpha) / 7;
+    }
+
+    for (uint32_t i = 0; i < PIXELS_PER_BLOCK; i++) {
+      uint64_t bestIndex = 0;
+      int32_t bestDistance = INT32_MAX;
+      for (uint32_t p = 0; p < 8; p++) {
+        int32_t distance = std::abs(block[i * 4 + 3] - palette[p]);
+        if (distance < bestDistance) {
+          bestDistance = distance;
+          bestIndex = p;
+        }
+      }
+      indices |= bestIndex << (3 * i);
+    }
+  }
+
+  // 48 bits of indices
+  for (uint32_t i = 0; i < 6; i++) {
+    dst[2 + i] = (indices >> (8 * i)) & 0xFF;
+  }
+}
+} // namespace
+
+void bc::EncodeBC1Block(const uint8_t *block, uint8_t *dst) { EncodeColorBlock(block, dst); }
+
+void bc::EncodeBC3Block(const uint8_t *block, uint8_t *dst) {
+  EncodeAlphaBlock(block, dst);
+  EncodeColorBlock(block, dst + 8);
+}
+
+size_t bc::GetCompressedSize(uint32_t width, uint32_t height, uint32_t blockSize) {
+  return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+}
+
+void bc::CompressImage(const uint8_t *pixels, uint32_t width, uint32_t height, uint32_t blockSize,
+                       uint8_t *dst) {
+  const uint32_t blocksX = (width + 3) / 4;
+  const uint32_t blocksY = (height + 3) / 4;
+
+  uint8_t block[PIXELS_PER_BLOCK * 4];
+  for (uint32_t by = 0; by < blocksY; by++) {
+    for (uint32_t bx = 0; bx < blocksX; bx++) {
+      // Gather the block, clamping at the borders
+      for (uint32_t y = 0; y < 4; y++) {
+        uint32_t srcY = std::min(by * 4 + y, height - 1);
+        for (uint32_t x = 0; x < 4; x++) {
+          uint32_t srcX = std::min(bx * 4 + x, width - 1);
+          memcpy(block + (y * 4 + x) * 4, pixels + (static_cast<size_t>(srcY) * width + srcX) * 4, 4);
+        }
+      }
+
+      uint8_t *dstBlock = dst + (static_cast<size_t>(by) * blocksX + bx) * blockSize;
+      if (blockSize == BC1_BLOCK_SIZE) {
+        EncodeBC1Block(block, dstBlock);
+      } else {
+        EncodeBC3Block(block, dstBlock);
+      }
+    }
+  }
+}
@@ -0,0 +1,34 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bc {
+constexpr uint32_t BC1_BLOCK_SIZE = 8;
+constexpr uint32_t BC3_BLOCK_SIZE = 16;
+
+/**
+ * Encodes a 4x4 block of RGBA8 pixels (64 bytes, row major) to BC1. Alpha is ignored.
+ */
+void EncodeBC1Block(const uint8_t *block, uint8_t *dst);
+
+/**
+ * Encodes a 4x4 block of RGBA8 pixels (64 bytes, row major) to BC3
+ */
+void EncodeBC3Block(const uint8_t *block, uint8_t *dst);
+
+/**
+ * Size in bytes of an image compressed with blocks of the given size
+ */
+[[nodiscard]] size_t GetCompressedSize(uint32_t width, uint32_t height, uint32_t blockSize);
+
+/**
+ * Compresses a whole RGBA8 image. Borders of images whose size is not a multiple of 4 are clamped.
+ * @param blockSize BC1_BLOCK_SIZE or BC3_BLOCK_SIZE
+ */
+void CompressImage(const uint8_t *pixels, uint32_t width, uint32_t height, uint32_t blockSize, uint8_t *dst);
+} // namespace bc
@@ -0,0 +1,177 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+// Offline asset cooker:
+// - converts an image to a texture container with a full mip chain, block compressed so that the engine can
+//   upload it without decoding anything.
+// - converts a scene description to a scene container, that the engine maps and streams in place.
+
+#include "BlockCompression.h"
+#include <engine/ImageProcessing.h>
+#include <engine/SceneContainer.h>
+#include <engine/SceneCooking.h>
+#include <engine/TextureContainer.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+void PrintUsage() {
+  std::cerr << "Usage: asset_cook <input image> <output.tex> [auto|bc1|bc3|rgba8]\n"
+            << "  auto (default) uses bc3 if the image has transparent pixels, bc1 otherwise.\n"
+            << "       asset_cook <input scene.txt> <output.scene>\n";
+}
+
+bool HasTransparency(const ImageData &image) {
+  const MipLevel &mip = image.mips[0];
+  for (size_t i = 3; i < mip.size; i += imgutils::BYTES_PER_PIXEL) {
+    if (image.pixels[mip.offset + i] != 255)
+      return true;
+  }
+  return false;
+}
+
+/**
+ * Compresses a mip level, splitting rows of blocks between threads
+ */
+void CompressMip(const uint8_t *pixels, const MipLevel &mip, uint32_t blockSize, uint8_t *dst) {
+  const uint32_t blockRows = (mip.height + 3) / 4;
+  const size_t blockRowSize = bc::GetCompressedSize(mip.width, 4, blockSize);
+  const uint32_t threadCount = std::clamp(std::thread::hardware_concurrency(), 1u, blockRows);
+  const uint32_t rowsPerThread = (blockRows + threadCount - 1) / threadCount;
+
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < threadCount; t++) {
+    uint32_t firstRow = t * rowsPerThread;
+    uint32_t rowCount = std::min(rowsPerThread, blockRows - std::min(firstRow, blockRows));
+    if (rowCount == 0)
+      break;
+
+    threads.emplace_back([=]() {
+      // Each thread sees its rows as a smaller image. The last one may be clamped by the real height.
+      uint32_t firstPixelRow = firstRow * 4;
+      uint32_t height = std::min(rowCount * 4, mip.height - firstPixelRow);
+      bc::CompressImage(pixels + static_cast<size_t>(firstPixelRow) * mip.width * imgutils::BYTES_PER_PIXEL,
+                        mip.width, height, blockSize, dst + firstRow * blockRowSize);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+size_t Align(size_t value, size_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+bool WriteFile(const char *path, const std::vector<uint8_t> &data) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    std::cerr << "Couldn't open " << path << " for writing\n";
+    return false;
+  }
+  file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+  return true;
+}
+
+int CookScene(const char *inputPath, const char *outputPath) {
+  std::vector<uint8_t> container;
+  if (!scenecook::CookScene(inputPath, container) || !WriteFile(outputPath, container))
+    return 1;
+
+  SceneContainerHeader header{};
+  memcpy(&header, container.data(), sizeof(header));
+  std::cout << inputPath << " -> " << outputPath << " (" << header.instanceCount << " instances, "
+            << header.chunkCount << " chunks, " << container.size() / 1024 << " KiB)\n";
+  return 0;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    PrintUsage();
+    return 1;
+  }
+  const char *inputPath = argv[1];
+  const char *outputPath = argv[2];
+  if (std::string(outputPath).ends_with(".scene"))
+    return CookScene(inputPath, outputPath);
+  const std::string formatName = argc > 3 ? argv[3] : "auto";
+
+  // Decode the source and build the mip chain
+  ImageData image;
+  if (!imgutils::LoadImage(inputPath, image))
+    return 1;
+  imgutils::GenerateMipChain(image);
+
+  // Choose format
+  TextureContainerFormat format;
+  if (formatName == "bc1") {
+    format = TextureContainerFormat::BC1;
+  } else if (formatName == "bc3") {
+    format = TextureContainerFormat::BC3;
+  } else if (formatName == "rgba8") {
+    format = TextureContainerFormat::RGBA8;
+  } else if (formatName == "auto") {
+    format = HasTransparency(image) ? TextureContainerFormat::BC3 : TextureContainerFormat::BC1;
+  } else {
+    PrintUsage();
+    return 1;
+  }
+  const uint32_t blockSize = format == TextureContainerFormat::BC1 ? bc::BC1_BLOCK_SIZE : bc::BC3_BLOCK_SIZE;
+
+  // Compute the layout of the file
+  const auto mipCount = static_cast<uint32_t>(image.mips.size());
+  std::vector<TextureContainerMip> mipEntries(mipCount);
+  size_t offset = Align(sizeof(TextureContainerHeader) + sizeof(TextureContainerMip) * mipCount,
+                        TEXTURE_CONTAINER_ALIGNMENT);
+  for (uint32_t i = 0; i < mipCount; i++) {
+    const MipLevel &mip = image.mips[i];
+    size_t size = format == TextureContainerFormat::RGBA8 ? mip.size
+                                                          : bc::GetCompressedSize(mip.width, mip.height, blockSize);
+    mipEntries[i] = TextureContainerMip{
+        .width = mip.width,
+        .height = mip.height,
+        .offset = offset,
+        .size = size,
+    };
+    offset = Align(offset + size, TEXTURE_CONTAINER_ALIGNMENT);
+  }
+
+  // Fill the payloads
+  std::vector<uint8_t> payload(offset, 0);
+  for (uint32_t i = 0; i < mipCount; i++) {
+    const MipLevel &mip = image.mips[i];
+    uint8_t *dst = payload.data() + mipEntries[i].offset;
+    if (format == TextureContainerFormat::RGBA8) {
+      memcpy(dst, image.pixels.data() + mip.offset, mip.size);
+    } else {
+      CompressMip(image.pixels.data() + mip.offset, mip, blockSize, dst);
+    }
+  }
+
+  // Header and mip table go at the start of the file
+  TextureContainerHeader header{
+      .magic = TEXTURE_CONTAINER_MAGIC,
+      .version = TEXTURE_CONTAINER_VERSION,
+      .format = format,
+      .width = image.mips[0].width,
+      .height = image.mips[0].height,
+      .mipCount = mipCount,
+      .reserved = {0, 0},
+  };
+  memcpy(payload.data(), &header, sizeof(header));
+  memcpy(payload.data() + sizeof(header), mipEntries.data(), sizeof(TextureContainerMip) * mipCount);
+
+  // Write it
+  if (!WriteFile(outputPath, payload))
+    return 1;
+
+  std::cout << inputPath << " -> " << outputPath << " (" << header.width << "x" << header.height << ", "
+            << mipCount << " mips, " << payload.size() / 1024 << " KiB, " << image.pixels.size() / 1024
+            << " KiB uncompressed)\n";
+  return 0;
+}
@@ -0,0 +1,200 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#include "Microbench.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+namespace microbench {
+
+// ==== State ====
+
+State::State(uint64_t iterations, int64_t argument) : _iterations(iterations), _argument(argument) {}
+
+State::Iterator State::begin() {
+  ResumeTiming();
+  return Iterator{this, _iterations};
+}
+
+State::Iterator State::end() { return Iterator{this, 0}; }
+
+void State::PauseTiming() {
+  if (_running) {
+    _elapsed += Clock::now() - _start;
+    _running = false;
+  }
+}
+
+void State::ResumeTiming() {
+  if (!_running) {
+    _running = true;
+    _start = Clock::now();
+  }
+}
+
+int64_t State::GetArgument() const { return _argument; }
+uint64_t State::GetIterations() const { return _iterations; }
+void State::SetItemsProcessed(uint64_t items) { _itemsProcessed = items; }
+uint64_t State::GetItemsProcessed() const { return _itemsProcessed; }
+double State::GetElapsedSeconds() const { return std::chrono::duration<double>(_elapsed).count(); }
+
+// ==== Benchmark ====
+
+Benchmark::Benchmark(std::string name, std::function<void(State &)> function)
+    : _name(std::move(name)), _function(std::move(function)) {}
+
+Benchmark *Benchmark::Arg(int64_t argument) {
+  _arguments.push_back(argument);
+  return this;
+}
+
+const std::string &Benchmark::GetName() const { return _name; }
+const std::vector<int64_t> &Benchmark::GetArguments() const { return _arguments; }
+void Benchmark::Run(State &state) const { _function(state); }
+
+// ==== Runner ====
+
+namespace {
+/** Benchmarks are registered by static initializers, so the list must be created on first use */
+std::vector<std::unique_ptr<Benchmark>> &GetBenchmarks() {
+  static std::vector<std::unique_ptr<Benchmark>> benchmarks;
+  return benchmarks;
+}
+
+struct Options {
+  std::string filter;
+  double minTime = 0.2;
+  uint32_t repetitions = 5;
+  std::string jsonPath;
+};
+
+struct Result {
+  std::string name;
+  uint64_t iterations;
+  /** Median and fastest of the repetitions */
+  double nanoseconds;
+  double minNanoseconds;
+  double itemsPerSecond;
+};
+
+Options ParseOptions(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string option = argv[i];
+    if (option == "--filter") {
+      options.filter = argv[i + 1];
+    } else if (option == "--min-time") {
+      options.minTime = std::stod(argv[i + 1]);
+    } else if (option == "--repetitions") {
+      options.repetitions = std::max<uint32_t>(1, std::stoul(argv[i + 1]));
+    } else if (option == "--json") {
+      options.jsonPath = argv[i + 1];
+    } else {
+      std::cerr << "[Microbench] Unknown option " << option << '\n';
+    }
+  }
+  return options;
+}
+
+Result Measure(const Benchmark &benchmark, const std::string &name, int64_t argument,
+               const Options &options) {
+  // Find an iteration count long enough for the timer
+  uint64_t iterations = 1;
+  while (true) {
+    State state(iterations, argument);
+    benchmark.Run(state);
+    const double elapsed = state.GetElapsedSeconds();
+    if (elapsed >= options.minTime || iterations >= 1'000'000'000)
+      break;
+    const double growth = elapsed > 0.0 ? options.minTime * 1.2 / elapsed : 100.0;
+    iterations = static_cast<uint64_t>(static_cast<double>(iterations) * std::clamp(growth, 2.0, 100.0));
+  }
+
+  std::vector<double> nanoseconds;
+  double itemsPerSecond = 0.0;
+  for (uint32_t repetition = 0; repetition < options.repetitions; repetition++) {
+    State state(iterations, argument);
+    benchmark.Run(state);
+    nanoseconds.push_back(state.GetElapsedSeconds() * 1e9 / static_cast<double>(iterations));
+    if (state.GetItemsProcessed() > 0) {
+      itemsPerSecond = std::max(itemsPerSecond,
+                                static_cast<double>(state.GetItemsProcessed()) / state.GetElapsedSeconds());
+    }
+  }
+  std::sort(nanoseconds.begin(), nanoseconds.end());
+
+  return Result{
+      .name = name,
+      .iterations = iterations,
+      .nanoseconds = nanoseconds[nanoseconds.size() / 2],
+      .minNanoseconds = nanoseconds.front(),
+      .itemsPerSecond = itemsPerSecond,
+  };
+}
+
+void WriteJson(const std::string &path, const std::vector<Result> &results) {
+  std::ofstream file(path);
+  if (!file.is_open()) {
+    std::cerr << "[Microbench] Unable to write " << path << '\n';
+    return;
+  }
+  file << "{\n  \"benchmarks\": [\n";
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result &result = results[i];
+    file << "    {\"name\": \"" << result.name << "\", \"iterations\": " << result.iterations
+         << ", \"ns_per_iteration\": " << result.nanoseconds
+         << ", \"min_ns_per_iteration\": " << result.minNanoseconds
+         << ", \"items_per_second\": " << result.itemsPerSecond << "}" << (i + 1 < results.size() ? "," : "")
+         << '\n';
+  }
+  file << "  ]\n}\n";
+}
+} // namespace
+
+Benchmark *Register(const std::string &name, std::function<void(State &)> function) {
+  GetBenchmarks().push_back(std::make_unique<Benchmark>(name, std::move(function)));
+  return GetBenchmarks().back().get();
+}
+
+int RunAll(int argc, char **argv) {
+  const Options options = ParseOptions(argc, argv);
+
+  std::cout << std::left << std::setw(40) << "Benchmark" << std::right << std::setw(14) << "Time (ns)"
+            << std::setw(14) << "Min (ns)" << std::setw(14) << "Iterations" << std::setw(16) << "Items/s"
+            << '\n'
+            << std::string(98, '-') << '\n';
+
+  std::vector<Result> results;
+  for (const auto &benchmark : GetBenchmarks()) {
+    // Benchmarks without arguments run once
+    std::vector<int64_t> arguments = benchmark->GetArguments();
+    const bool hasArguments = !arguments.empty();
+    if (!hasArguments) {
+      arguments.push_back(0);
+    }
+
+    for (int64_t argument : arguments) {
+      const std::string name = benchmark->GetName() + (hasArguments ? "/" + std::to_string(argument) : "");
+      if (name.find(options.filter) == std::string::npos)
+        continue;
+
+      const Result result = Measure(*benchmark, name, argument, options);
+      std::cout << std::left << std::setw(40) << result.name << std::right << std::fixed
+                << std::setprecision(1) << std::setw(14) << result.nanoseconds << std::setw(14)
+                << result.minNanoseconds << std::setw(14) << result.iterations << std::setw(16)
+                << std::setprecision(0) << result.itemsPerSecond << '\n';
+      results.push_back(result);
+    }
+  }
+
+  if (!options.jsonPath.empty()) {
+    WriteJson(options.jsonPath, results);
+  }
+  return 0;
+}
+
+} // namespace microbench
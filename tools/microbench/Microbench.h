@@ -0,0 +1,111 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+#pragma once
+
+// Minimal benchmark harness, in the spirit of Google Benchmark:
+//
+//   void LookupMaterial(microbench::State &state) {
+//     ... setup, not timed ...
+//     for (auto _ : state) {
+//       microbench::DoNotOptimize(...);
+//     }
+//   }
+//   MICROBENCH(LookupMaterial);
+//   MICROBENCH(FillObjects)->Arg(1000)->Arg(10000);
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace microbench {
+
+/** Prevents the compiler from removing the computation of the value */
+template <class T> inline void DoNotOptimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const void *sink;
+  sink = &value;
+#endif
+}
+
+/** Handed to the benchmark functions. The body of the range-based loop is timed. */
+class State {
+private:
+  using Clock = std::chrono::steady_clock;
+
+  uint64_t _iterations;
+  int64_t _argument;
+  uint64_t _itemsProcessed = 0;
+  Clock::time_point _start;
+  Clock::duration _elapsed{0};
+  bool _running = false;
+
+public:
+  struct Iterator {
+    State *state;
+    uint64_t remaining;
+
+    bool operator!=(const Iterator &) {
+      if (remaining > 0)
+        return true;
+      state->PauseTiming();
+      return false;
+    }
+    void operator++() { remaining--; }
+    int operator*() const { return 0; }
+  };
+
+  State(uint64_t iterations, int64_t argument);
+
+  Iterator begin();
+  Iterator end();
+
+  /** Excludes the code between PauseTiming and ResumeTiming from the measurement, like a setup */
+  void PauseTiming();
+  void ResumeTiming();
+
+  [[nodiscard]] int64_t GetArgument() const;
+  [[nodiscard]] uint64_t GetIterations() const;
+  /** Items handled by the whole run, to report a throughput */
+  void SetItemsProcessed(uint64_t items);
+  [[nodiscard]] uint64_t GetItemsProcessed() const;
+  [[nodiscard]] double GetElapsedSeconds() const;
+};
+
+class Benchmark {
+private:
+  std::string _name;
+  std::function<void(State &)> _function;
+  std::vector<int64_t> _arguments;
+
+public:
+  Benchmark(std::string name, std::function<void(State &)> function);
+
+  /** Runs the benchmark once more with this argument */
+  Benchmark *Arg(int64_t argument);
+
+  [[nodiscard]] const std::string &GetName() const;
+  [[nodiscard]] const std::vector<int64_t> &GetArguments() const;
+  void Run(State &state) const;
+};
+
+Benchmark *Register(const std::string &name, std::function<void(State &)> function);
+
+/**
+ * Runs the registered benchmarks and prints their results.
+ * Options: --filter <substring>, --min-time <seconds>, --repetitions <count>, --json <path>
+ */
+int RunAll(int argc, char **argv);
+
+} // namespace microbench
+
+#define MICROBENCH_CONCAT_IMPL(a, b) a##b
+#define MICROBENCH_CONCAT(a, b) MICROBENCH_CONCAT_IMPL(a, b)
+#define MICROBENCH(function)                                                                                 \
+  static ::microbench::Benchmark *MICROBENCH_CONCAT(microbench_, __LINE__) =                                \
+      ::microbench::Register(#function, function)
@@ -0,0 +1,184 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+// Micro-benchmarks of the CPU side hot paths of the engine. None of them needs a GPU or a window:
+// the object buffers are plain memory, and the deletion queue only runs functions.
+//
+// Usage: the_good_one_microbench [--filter <substring>] [--min-time <seconds>] [--repetitions <count>]
+//                                [--json <path>]
+
+#include "Microbench.h"
+#include <engine/Bvh.h>
+#include <engine/DeletionQueue.h>
+#include <engine/Mesh.h>
+#include <engine/ObjectData.h>
+#include <engine/vk_engine.h>
+#include <cmath>
+#include <cstdlib>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <vector>
+
+// The engine sources used here call VMA and the dynamic dispatcher, which live in vk_engine.cpp
+#define VMA_IMPLEMENTATION
+#include <vk_mem_alloc.h>
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
+
+namespace {
+/** Same path as the engine: run from the bin directory */
+constexpr const char *MONKEY_PATH = "../assets/monkey_smooth.obj";
+
+/** Monkey mesh prepared like in the engine, loaded once for the benchmarks that need a mesh */
+Mesh *GetMonkeyMesh() {
+  static Mesh *mesh = [] {
+    auto *monkey = new Mesh();
+    if (!monkey->LoadFromObj(MONKEY_PATH)) {
+      std::cerr << "[Microbench] Unable to load " << MONKEY_PATH << '\n';
+      std::exit(1);
+    }
+    monkey->GenerateLods();
+    return monkey;
+  }();
+  return mesh;
+}
+
+// ==== Meshes ====
+
+void LoadMonkeyObj(microbench::State &state) {
+  for (auto _ : state) {
+    Mesh mesh;
+    mesh.LoadFromObj(MONKEY_PATH);
+    microbench::DoNotOptimize(mesh.GetIndexCount());
+  }
+}
+MICROBENCH(LoadMonkeyObj);
+
+void GetVertexDescription(microbench::State &state) {
+  for (auto _ : state) {
+    VertexInputDescription description = Vertex::GetVertexDescription();
+    microbench::DoNotOptimize(description.attributes.data());
+  }
+}
+MICROBENCH(GetVertexDescription);
+
+// ==== Object buffers ====
+
+/** Level of detail selection and copy of the object data, like UpdateObjects does every frame */
+void WriteObjects(microbench::State &state) {
+  const auto count = static_cast<uint32_t>(state.GetArgument());
+  Material material{.materialIndex = 1};
+  Mesh *mesh = GetMonkeyMesh();
+
+  // Grid of objects in front of the camera, at various distances so that every level is used
+  const auto side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+  std::vector<RenderObject> objects;
+  objects.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    RenderObject object{
+        .mesh = mesh,
+        .material = &material,
+        .albedo = glm::vec4(1.0f),
+    };
+    object.transformMatrix[3] = glm::vec4(3.0f * static_cast<float>(i % side), 0.0f,
+                                          -3.0f * static_cast<float>(i / side), 1.0f);
+    objects.push_back(object);
+  }
+  // Stand-ins for the mapped buffers
+  std::vector<GPUObjectData> objectData(count);
+  std::vector<ObjectColor> colors(count);
+  const glm::vec3 cameraPosition{0.0f, 2.0f, 5.0f};
+  const float projectionScale = 900.0f * 0.5f / std::tan(glm::radians(CAMERA_FOV) * 0.5f);
+
+  for (auto _ : state) {
+    WriteObjectData(objects.data(), count, cameraPosition, projectionScale, objectData.data(), colors.data());
+    microbench::DoNotOptimize(objectData.data());
+  }
+  state.SetItemsProcessed(state.GetIterations() * count);
+}
+MICROBENCH(WriteObjects)->Arg(1000)->Arg(10000)->Arg(100000);
+
+// ==== BVH ====
+
+/** Boxes of a grid of objects of various sizes, spread like the streamed scene */
+std::vector<Aabb> GetGridBoxes(uint32_t count) {
+  const auto side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+  std::vector<Aabb> boxes(count);
+  for (uint32_t i = 0; i < count; i++) {
+    const glm::vec3 center{3.0f * static_cast<float>(i % side), static_cast<float>(i % 7),
+                           -3.0f * static_cast<float>(i / side)};
+    const float radius = 0.5f + static_cast<float>(i % 5) * 0.25f;
+    boxes[i] = Aabb{.min = center - glm::vec3(radius), .max = center + glm::vec3(radius)};
+  }
+  return boxes;
+}
+
+/** Full rebuild, like the one done when chunks are streamed in or out */
+void BvhBuild(microbench::State &state) {
+  const std::vector<Aabb> boxes = GetGridBoxes(static_cast<uint32_t>(state.GetArgument()));
+  Bvh bvh;
+
+  for (auto _ : state) {
+    bvh.Build(boxes);
+    microbench::DoNotOptimize(bvh.GetObjectCount());
+  }
+  state.SetItemsProcessed(state.GetIterations() * boxes.size());
+}
+MICROBENCH(BvhBuild)->Arg(1000)->Arg(10000)->Arg(100000);
+
+/** Frustum culling of the main view, looking along the grid */
+void BvhQueryFrustum(microbench::State &state) {
+  const std::vector<Aabb> boxes = GetGridBoxes(static_cast<uint32_t>(state.GetArgument()));
+  Bvh bvh;
+  bvh.Build(boxes);
+  const glm::mat4 projection = glm::perspective(glm::radians(CAMERA_FOV), 16.0f / 9.0f, 0.1f, 200.0f);
+  const glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(-50.0f, -2.0f, 0.0f));
+  const glm::mat4 rows = glm::transpose(projection * view);
+  glm::vec4 planes[6] = {rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1],
+                         rows[3] - rows[1], rows[3] + rows[2], rows[3] - rows[2]};
+  std::vector<uint32_t> visible;
+
+  for (auto _ : state) {
+    bvh.QueryFrustum(planes, visible);
+    microbench::DoNotOptimize(visible.data());
+  }
+  state.SetItemsProcessed(state.GetIterations() * boxes.size());
+}
+MICROBENCH(BvhQueryFrustum)->Arg(10000)->Arg(100000);
+
+// ==== Deletion queue ====
+
+/** Functions pushed at init and called at shutdown */
+void DeletionQueuePushFunctions(microbench::State &state) {
+  constexpr uint32_t FUNCTION_COUNT = 1000;
+  uint64_t calls = 0;
+
+  for (auto _ : state) {
+    DeletionQueue queue;
+    queue.Init(nullptr, nullptr);
+    for (uint32_t i = 0; i < FUNCTION_COUNT; i++) {
+      queue.PushFunction([&calls]() { calls++; });
+    }
+    queue.FlushAll();
+  }
+  microbench::DoNotOptimize(calls);
+  state.SetItemsProcessed(state.GetIterations() * FUNCTION_COUNT);
+}
+MICROBENCH(DeletionQueuePushFunctions);
+
+/** Flush of every frame, most of the time with nothing retired */
+void DeletionQueueFlushEmpty(microbench::State &state) {
+  DeletionQueue queue;
+  queue.Init(nullptr, nullptr);
+  uint64_t frame = 0;
+
+  for (auto _ : state) {
+    queue.Flush(frame++);
+  }
+  queue.FlushAll();
+}
+MICROBENCH(DeletionQueueFlushEmpty);
+} // namespace
+
+int main(int argc, char **argv) { return microbench::RunAll(argc, argv); }
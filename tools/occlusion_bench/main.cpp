@@ -0,0 +1,142 @@
+//
+// Created by Martin Danhier on 18/10/2026.
+//
+
+// Benchmark of the CPU occlusion culling: a street of large buildings hides a field of small objects while
+// the camera walks along the street. Reports the time spent per frame and the share of objects culled.
+
+#include <engine/JobSystem.h>
+#include <engine/OcclusionCuller.h>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr uint32_t DEPTH_WIDTH = 320;
+constexpr uint32_t DEPTH_HEIGHT = 192;
+constexpr float FOV = 70.0f;
+constexpr float NEAR_PLANE = 0.1f;
+constexpr float FAR_PLANE = 200.0f;
+
+/** Closed box mesh, used for the buildings */
+struct BoxMesh {
+  std::vector<float> positions;
+  std::vector<uint32_t> indices;
+};
+
+BoxMesh CreateBoxMesh() {
+  BoxMesh mesh;
+  for (uint32_t corner = 0; corner < 8; corner++) {
+    mesh.positions.push_back(corner & 1 ? 0.5f : -0.5f);
+    mesh.positions.push_back(corner & 2 ? 0.5f : -0.5f);
+    mesh.positions.push_back(corner & 4 ? 0.5f : -0.5f);
+  }
+  mesh.indices = {0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5, 0, 4, 5, 0, 5, 1,
+                  2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3};
+  return mesh;
+}
+
+/** Column major matrix scaling then translating, as glm would build it */
+void ScaleTranslate(const float *scale, const float *translation, float *matrix) {
+  std::fill(matrix, matrix + 16, 0.0f);
+  matrix[0] = scale[0];
+  matrix[5] = scale[1];
+  matrix[10] = scale[2];
+  matrix[12] = translation[0];
+  matrix[13] = translation[1];
+  matrix[14] = translation[2];
+  matrix[15] = 1.0f;
+}
+
+/** Same camera as the engine: perspective with flipped y, looking towards -z from the given position */
+void CameraViewProj(const float *position, float aspectRatio, float *matrix) {
+  const float f = 1.0f / std::tan(FOV * 3.14159265f / 360.0f);
+  std::fill(matrix, matrix + 16, 0.0f);
+  matrix[0] = f / aspectRatio;
+  matrix[5] = -f;
+  matrix[10] = -(FAR_PLANE + NEAR_PLANE) / (FAR_PLANE - NEAR_PLANE);
+  matrix[11] = -1.0f;
+  matrix[14] = -2.0f * FAR_PLANE * NEAR_PLANE / (FAR_PLANE - NEAR_PLANE);
+  // Translation by -position, applied on the right
+  for (uint32_t row = 0; row < 4; row++) {
+    matrix[12 + row] -=
+        matrix[row] * position[0] + matrix[4 + row] * position[1] + matrix[8 + row] * position[2];
+  }
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const uint32_t objectCount = argc > 1 ? std::stoul(argv[1]) : 20000;
+  const uint32_t frameCount = argc > 2 ? std::stoul(argv[2]) : 200;
+
+  // Two rows of buildings along the street, which goes towards -z
+  const BoxMesh box = CreateBoxMesh();
+  std::vector<std::vector<float>> buildings;
+  for (int32_t i = 0; i < 12; i++) {
+    for (float side : {-1.0f, 1.0f}) {
+      const float scale[3] = {10.0f, 8.0f + static_cast<float>(i % 3) * 4.0f, 10.0f};
+      const float translation[3] = {side * 10.0f, 0.0f, -12.0f * static_cast<float>(i)};
+      std::vector<float> model(16);
+      ScaleTranslate(scale, translation, model.data());
+      buildings.push_back(model);
+    }
+  }
+
+  // Small objects all around, most of them behind the buildings
+  std::mt19937 random(42);
+  std::uniform_real_distribution<float> x(-60.0f, 60.0f);
+  std::uniform_real_distribution<float> z(-150.0f, 10.0f);
+  std::vector<OcclusionBox> boxes(objectCount);
+  for (auto &objectBox : boxes) {
+    const float center[3] = {x(random), 0.0f, z(random)};
+    for (uint32_t axis = 0; axis < 3; axis++) {
+      objectBox.min[axis] = center[axis] - 0.5f;
+      objectBox.max[axis] = center[axis] + 0.5f;
+    }
+  }
+  std::vector<uint8_t> visible(objectCount);
+
+  JobSystem jobSystem;
+  OcclusionCuller culler(DEPTH_WIDTH, DEPTH_HEIGHT, &jobSystem);
+
+  double rasterizationTime = 0.0;
+  double testTime = 0.0;
+  uint64_t culledCount = 0;
+  for (uint32_t frame = 0; frame < frameCount; frame++) {
+    // Walk down the street
+    const float cameraPosition[3] = {0.0f, 1.5f, 5.0f - 100.0f * static_cast<float>(frame) / frameCount};
+    float viewProj[16];
+    CameraViewProj(cameraPosition, 1700.0f / 900.0f, viewProj);
+
+    auto start = std::chrono::steady_clock::now();
+    culler.BeginFrame(viewProj);
+    for (const auto &model : buildings) {
+      culler.AddOccluder(box.positions.data(), 8, 3 * sizeof(float), box.indices.data(), box.indices.size(),
+                         model.data());
+    }
+    culler.Rasterize();
+    auto rasterized = std::chrono::steady_clock::now();
+    culler.TestBoxes(boxes.data(), boxes.size(), visible.data());
+    auto tested = std::chrono::steady_clock::now();
+
+    rasterizationTime += std::chrono::duration<double, std::milli>(rasterized - start).count();
+    testTime += std::chrono::duration<double, std::milli>(tested - rasterized).count();
+    for (uint8_t v : visible) {
+      culledCount += v == 0;
+    }
+  }
+
+  std::cout << "Occlusion culling of " << objectCount << " objects behind " << buildings.size()
+            << " occluders, " << culler.GetWidth() << "x" << culler.GetHeight() << " depth buffer, "
+            << (OcclusionCuller::UsesAvx2() ? "AVX2" : "scalar") << ", " << jobSystem.GetWorkerCount() + 1
+            << " threads\n"
+            << "  rasterization: " << rasterizationTime / frameCount << " ms per frame\n"
+            << "  tests: " << testTime / frameCount << " ms per frame\n"
+            << "  culled: "
+            << 100.0 * static_cast<double>(culledCount) / (static_cast<double>(objectCount) * frameCount)
+            << " % (hidden or outside of the screen)\n";
+  return 0;
+}